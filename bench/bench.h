@@ -0,0 +1,54 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include <fmt/format.h>
+
+namespace docsmith::bench
+{
+
+/// Run fn the given number of times and print the mean time per iteration.
+template <typename Fn>
+double run_benchmark(const std::string &name, std::size_t iterations, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < iterations; ++i)
+        fn();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    double us_per_iter = elapsed.count() / static_cast<double>(iterations);
+    fmt::print("{:<48} {:>12.2f} us/iter ({} iterations)\n", name, us_per_iter, iterations);
+    return us_per_iter;
+}
+
+/// Print throughput for a benchmark that processed the given number of bytes per iteration.
+inline void print_throughput(const std::string &name, std::size_t bytes, double us_per_iter)
+{
+    double mb_per_s = static_cast<double>(bytes) / us_per_iter; // bytes/us == MB/s
+    fmt::print("{:<48} {:>12.2f} MB/s\n", name, mb_per_s);
+}
+
+void odt_writer();
+void docx_writer();
+void query();
+void search();
+void exporters();
+}
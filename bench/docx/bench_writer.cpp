@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <filesystem>
+#include <string>
+
+#include "bench.h"
+#include "docsmithcpp/docx/writer.h"
+#include "docsmithcpp/odt/file.h"
+#include "docsmithcpp/odt/to_docx.h"
+#include "docsmithcpp/odt/writer.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith::bench
+{
+namespace fs = std::filesystem;
+
+/// The same documents as odt_writer, so the two formats can be compared
+void docx_writer()
+{
+    auto out_dir = fs::temp_directory_path() / "docsmithcpp_bench";
+    fs::create_directories(out_dir);
+    auto filename = (out_dir / "empty.docx").string();
+
+    const text_doc empty;
+    run_benchmark("docx::writer::write empty document", 2000, [&] { //
+        docx::writer::write(empty, filename);
+    });
+
+    text_doc small{heading{1, "Heading"}, paragraph{"Some paragraph text."}};
+    run_benchmark("docx::writer::write small document", 2000, [&] { //
+        docx::writer::write(small, filename);
+    });
+
+    text_doc large;
+    for(int i = 0; i < 20000; ++i)
+    {
+        large.add(heading{2, "Section " + std::to_string(i)});
+        large.add(paragraph{"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+                            "tempor incididunt ut labore et dolore magna aliqua " +
+                            std::to_string(i)});
+    }
+    auto large_filename = (out_dir / "large.docx").string();
+    run_benchmark("docx::writer::write large document", 5, [&] { //
+        docx::writer::write(large, large_filename);
+    });
+    run_benchmark("docx::writer::write_async large document", 5, [&] { //
+        docx::writer::write_async(large, large_filename).get();
+    });
+
+    // Converting straight from ODT, against reading the tree and writing it out again
+    auto odt_filename = (out_dir / "large.odt").string();
+    odt::writer::write(large, odt_filename);
+    run_benchmark("odt::convert_to_docx large document", 5, [&] { //
+        odt::convert_to_docx(odt_filename, large_filename);
+    });
+    run_benchmark("odt_file::parse_text_doc + docx::writer::write large document", 5, [&] { //
+        docx::writer::write(odt_file(odt_filename).parse_text_doc(), large_filename);
+    });
+
+    fs::remove_all(out_dir);
+}
+}
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <sstream>
+#include <string>
+
+#include "bench.h"
+#include "docsmithcpp/html_writer.h"
+#include "docsmithcpp/iostream_writer.h"
+#include "docsmithcpp/json.h"
+#include "docsmithcpp/markdown_writer.h"
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/text_extractor.h"
+
+namespace docsmith::bench
+{
+namespace
+{
+/// About 1M words in 100k paragraphs, some split into runs
+text_doc make_export_doc()
+{
+    static const char *words[] = {"the", "supplier", "shall", "deliver", "goods", "payment",
+        "within", "days", "contract", "party", "agreement", "notice", "term", "clause"};
+    text_doc doc;
+    std::string s;
+    for(int p = 0; p < 100000; ++p)
+    {
+        s.clear();
+        for(int w = 0; w < 10; ++w)
+        {
+            s += words[(p * 7 + w * 3) % std::size(words)];
+            s += ' ';
+        }
+        if(p % 10 == 0)
+            doc.add(heading{1, s});
+        else if(p % 3 == 0)
+            doc.add(paragraph{s, span{text{"emphasis"}}.set_style("Emphasis"), "."});
+        else
+            doc.add(paragraph{s});
+    }
+    doc.styles().add(style{"Emphasis", text_props{font_style::italic}});
+    return doc;
+}
+}
+
+void exporters()
+{
+    auto doc = make_export_doc();
+
+    std::size_t bytes = 0;
+    auto us = run_benchmark("io_writer to std::ostringstream", 5, [&] {
+        std::ostringstream os;
+        io_writer writer(os);
+        doc.accept(writer);
+        bytes = os.str().size();
+    });
+    print_throughput("io_writer to std::ostringstream", bytes, us);
+
+    // The same sink for both: bytes are counted, not stored, so only the exporters are timed
+    std::size_t sunk = 0;
+    output_buffer out([&](const char *, std::size_t size) { sunk += size; });
+    us = run_benchmark("text_extractor to output_buffer", 5, [&] {
+        auto before = out.size();
+        extract_text(doc, out);
+        out.flush();
+        bytes = out.size() - before;
+    });
+    print_throughput("text_extractor to output_buffer", bytes, us);
+
+    us = run_benchmark("markdown_writer to output_buffer", 5, [&] {
+        auto before = out.size();
+        write_markdown(doc, out);
+        out.flush();
+        bytes = out.size() - before;
+    });
+    print_throughput("markdown_writer to output_buffer", bytes, us);
+
+    us = run_benchmark("html_writer to output_buffer", 5, [&] {
+        auto before = out.size();
+        write_html(doc, out);
+        out.flush();
+        bytes = out.size() - before;
+    });
+    print_throughput("html_writer to output_buffer", bytes, us);
+    fmt::print("(HTML is {} bytes)\n", bytes);
+
+    us = run_benchmark("json_writer to output_buffer", 5, [&] {
+        auto before = out.size();
+        write_json(doc, out);
+        out.flush();
+        bytes = out.size() - before;
+    });
+    print_throughput("json_writer to output_buffer", bytes, us);
+    fmt::print("({} bytes sunk)\n", sunk);
+
+    auto json = to_json(doc);
+    std::size_t blocks = 0;
+    us = run_benchmark("read_json", 5, [&] { blocks += read_json(json).child_list()->size(); });
+    print_throughput("read_json", json.size(), us);
+    fmt::print("({} blocks read)\n", blocks);
+}
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <filesystem>
+#include <string>
+
+#include "bench.h"
+#include "docsmithcpp/odt/writer.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith::bench
+{
+namespace fs = std::filesystem;
+
+void odt_writer()
+{
+    auto out_dir = fs::temp_directory_path() / "docsmithcpp_bench";
+    fs::create_directories(out_dir);
+    auto filename = (out_dir / "empty.odt").string();
+
+    // Fixed per-save overhead: skeleton setup, manifest and archive creation.
+    const text_doc empty;
+    run_benchmark("odt::writer::write empty document", 2000, [&] { //
+        odt::writer::write(empty, filename);
+    });
+
+    text_doc small{heading{1, "Heading"}, paragraph{"Some paragraph text."}};
+    run_benchmark("odt::writer::write small document", 2000, [&] { //
+        odt::writer::write(small, filename);
+    });
+
+    // Large document: the pipelined save overlaps printing, deflating and writing.
+    text_doc large;
+    for(int i = 0; i < 20000; ++i)
+    {
+        large.add(heading{2, "Section " + std::to_string(i)});
+        large.add(paragraph{"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+                            "tempor incididunt ut labore et dolore magna aliqua " +
+                            std::to_string(i)});
+    }
+    auto large_filename = (out_dir / "large.odt").string();
+    run_benchmark("odt::writer::write large document", 5, [&] { //
+        odt::writer::write(large, large_filename);
+    });
+    run_benchmark("odt::writer::write_async large document", 5, [&] { //
+        odt::writer::write_async(large, large_filename).get();
+    });
+
+    // Flat ODT: the same XML without the archive, manifest or deflate
+    auto flat_filename = (out_dir / "large.fodt").string();
+    run_benchmark("odt::writer::write_flat large document", 5, [&] { //
+        odt::writer::write_flat(large, flat_filename);
+    });
+
+    fs::remove_all(out_dir);
+}
+}
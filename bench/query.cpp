@@ -0,0 +1,56 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <string>
+
+#include "bench.h"
+#include "docsmithcpp/query.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith::bench
+{
+
+void query()
+{
+    text_doc doc;
+    for(int i = 0; i < 5000; ++i)
+    {
+        doc.add(heading{1 + i % 4, "Section " + std::to_string(i)});
+        doc.add(paragraph{text{"Body text "}, span{text{"with a span"}}, text{" and more text."}}
+                    .set_style("Text_20_body"));
+        doc.add(list{list_item{"First"}, list_item{"Second"}});
+    }
+
+    std::size_t found = 0;
+    run_benchmark("find_all<heading> level <= 2 (lambda)", 100, [&] {
+        found += doc.find_all<heading>([](element *e)
+                       { return dynamic_cast<heading *>(e)->level() <= 2; })
+                     .size();
+    });
+
+    selector top_headings("heading[level<=2]");
+    run_benchmark("selector heading[level<=2]", 100, [&] { //
+        found += top_headings.select(doc).size();
+    });
+
+    selector list_paragraphs("list > list_item paragraph");
+    run_benchmark("selector list > list_item paragraph", 100, [&] { //
+        found += list_paragraphs.select(doc).size();
+    });
+    fmt::print("({} matches)\n", found);
+}
+}
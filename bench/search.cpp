@@ -0,0 +1,211 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <regex>
+#include <string>
+#include <utility>
+
+#include "bench.h"
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/regex.h"
+#include "docsmithcpp/replace.h"
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/text_index.h"
+#include "docsmithcpp/text_search.h"
+
+namespace docsmith::bench
+{
+namespace
+{
+/// About 1M words of varied text in 100k paragraphs
+text_doc make_large_doc()
+{
+    static const char *words[] = {"the", "supplier", "shall", "deliver", "goods", "payment",
+        "within", "days", "contract", "party", "agreement", "notice", "term", "clause"};
+    text_doc doc;
+    std::string s;
+    for(int p = 0; p < 100000; ++p)
+    {
+        s.clear();
+        for(int w = 0; w < 10; ++w)
+        {
+            s += words[(p * 7 + w * 3) % std::size(words)];
+            s += w == 9 ? " ref" + std::to_string(p) + "." : " ";
+        }
+        doc.add(paragraph{s});
+    }
+    return doc;
+}
+}
+
+void search()
+{
+    auto doc = make_large_doc();
+
+    text_index index;
+    run_benchmark("text_index::build (1M words)", 3, [&] { index.build(doc); });
+
+    std::size_t found = 0;
+    run_benchmark("text_index::find common term", 10000, [&] { //
+        found += index.find("Supplier").size();
+    });
+    run_benchmark("text_index::find rare term", 10000, [&] { //
+        found += index.find("ref4242").size();
+    });
+    fmt::print("({} matches)\n", found);
+
+    // Index-free scanning. The kernels on one large haystack, and on the many short strings of
+    // a real document:
+    std::string all;
+    auto texts = doc.get_elem_of<text>();
+    for(auto *t : texts)
+        all += t->m_text;
+
+    auto us = run_benchmark("std::string::find (one string)", 50, [&] {
+        for(auto pos = all.find("agreement"); pos != std::string::npos;
+            pos = all.find("agreement", pos + 9))
+            ++found;
+    });
+    print_throughput("std::string::find (one string)", all.size(), us);
+    us = run_benchmark("find_substring (one string)", 50, [&] {
+        for(auto pos = find_substring(all, "agreement"); pos != std::string::npos;
+            pos = find_substring(all, "agreement", pos + 9))
+            ++found;
+    });
+    print_throughput("find_substring (one string)", all.size(), us);
+    us = run_benchmark("find_substring nocase (one string)", 50, [&] {
+        for(auto pos = find_substring(all, "AGREEMENT", 0, true); pos != std::string::npos;
+            pos = find_substring(all, "AGREEMENT", pos + 9, true))
+            ++found;
+    });
+    print_throughput("find_substring nocase (one string)", all.size(), us);
+
+    // Each kernel the machine supports, as find_substring() picks only the fastest:
+    for(auto [kernel, name] : {std::pair{search_kernel::scalar, "scalar"},
+            std::pair{search_kernel::sse2, "sse2"}, std::pair{search_kernel::avx2, "avx2"}})
+    {
+        if(!is_supported(kernel))
+            continue;
+        auto label = fmt::format("find_substring {} (one string)", name);
+        us = run_benchmark(label, 50, [&] {
+            for(auto pos = find_substring(kernel, all, "agreement"); pos != std::string::npos;
+                pos = find_substring(kernel, all, "agreement", pos + 9))
+                ++found;
+        });
+        print_throughput(label, all.size(), us);
+    }
+
+    us = run_benchmark("get_elem_of + std::string::find", 20, [&] {
+        for(auto *t : doc.get_elem_of<text>())
+            for(auto pos = t->m_text.find("agreement"); pos != std::string::npos;
+                pos = t->m_text.find("agreement", pos + 9))
+                ++found;
+    });
+    print_throughput("get_elem_of + std::string::find", all.size(), us);
+    us = run_benchmark("find_text", 20, [&] { found += find_text(doc, "agreement").size(); });
+    print_throughput("find_text", all.size(), us);
+    us = run_benchmark("find_text case insensitive", 20, [&] {
+        found += find_text(doc, "AGREEMENT", {.m_case_insensitive = true}).size();
+    });
+    print_throughput("find_text case insensitive", all.size(), us);
+
+    // Each iteration replaces the words and then puts them back
+    std::vector<replacer::rule> there, back;
+    for(const char *w : {"supplier", "deliver", "payment", "contract", "agreement", "notice"})
+    {
+        std::string upper = w;
+        upper[0] = static_cast<char>(upper[0] - 'a' + 'A');
+        there.emplace_back(w, upper);
+        back.emplace_back(upper, w);
+    }
+    us = run_benchmark("per node std::string::replace loop", 5, [&] {
+        for(auto *rules : {&there, &back})
+            for(auto *t : doc.get_elem_of<text>())
+                for(const auto &[from, to] : *rules)
+                    for(auto pos = t->m_text.find(from); pos != std::string::npos;
+                        pos = t->m_text.find(from, pos + to.size()))
+                        t->m_text.replace(pos, from.size(), to);
+    });
+    print_throughput("per node std::string::replace loop", 2 * all.size(), us);
+    replacer forward(there), reverse(back);
+    us = run_benchmark("replacer", 5, [&] {
+        found += forward.apply(doc).total();
+        found += reverse.apply(doc).total();
+    });
+    print_throughput("replacer", 2 * all.size(), us);
+
+    // A realistic rule set: hundreds of terms, few of which occur
+    for(int i = 0; i < 200; ++i)
+    {
+        there.emplace_back("term" + std::to_string(i) + "x", "TERM");
+        back.emplace_back("TERM" + std::to_string(i) + "x", "term");
+    }
+    us = run_benchmark("per node std::string::replace loop, 206 rules", 2, [&] {
+        for(auto *rules : {&there, &back})
+            for(auto *t : doc.get_elem_of<text>())
+                for(const auto &[from, to] : *rules)
+                    for(auto pos = t->m_text.find(from); pos != std::string::npos;
+                        pos = t->m_text.find(from, pos + to.size()))
+                        t->m_text.replace(pos, from.size(), to);
+    });
+    print_throughput("per node std::string::replace loop, 206 rules", 2 * all.size(), us);
+    replacer forward_many(there), reverse_many(back);
+    us = run_benchmark("replacer, 206 rules", 2, [&] {
+        found += forward_many.apply(doc).total();
+        found += reverse_many.apply(doc).total();
+    });
+    print_throughput("replacer, 206 rules", 2 * all.size(), us);
+
+    // Regex scanning, against std::regex over the same block strings
+    std::vector<std::string> blocks;
+    for_each_block(doc, [&](element &b) { blocks.push_back(block_text(b).str()); });
+    const char *pattern = "ref\\d*42\\.|(supplier|party) shall";
+
+    std::regex std_re(pattern);
+    us = run_benchmark("std::regex_search", 1, [&] {
+        for(const auto &b : blocks)
+            for(std::sregex_iterator it(b.begin(), b.end(), std_re), end; it != end; ++it)
+                ++found;
+    });
+    print_throughput("std::regex_search", all.size(), us);
+    regex re(pattern);
+    us = run_benchmark("regex::find_all", 5, [&] { found += re.find_all(doc).size(); });
+    print_throughput("regex::find_all", all.size(), us);
+    regex rare("ref\\d*42\\.");
+    us = run_benchmark("regex::find_all, rare matches", 5, [&] { //
+        found += rare.find_all(doc).size();
+    });
+    print_throughput("regex::find_all, rare matches", all.size(), us);
+
+    std::vector<text_doc> corpus;
+    std::vector<element *> roots;
+    for(int i = 0; i < 8; ++i)
+        corpus.push_back(make_large_doc());
+    for(auto &d : corpus)
+        roots.push_back(&d);
+    for(unsigned threads : {1u, 0u})
+    {
+        auto name = fmt::format("find_all_parallel, 8 docs, {} threads", threads);
+        us = run_benchmark(name, 2, [&] {
+            for(const auto &r : find_all_parallel(re, roots, threads))
+                found += r.size();
+        });
+        print_throughput(name, 8 * all.size(), us);
+    }
+    fmt::print("({} matches)\n", found);
+}
+}
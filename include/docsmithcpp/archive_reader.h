@@ -0,0 +1,52 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <memory>
+#include <string>
+
+#include "docsmithcpp/zip_writer.h"
+
+namespace libzippp
+{
+class ZipArchive;
+}
+
+namespace docsmith
+{
+
+/// Reads the entries of a zip archive on disk, inflating each in chunks so that no entry is held
+/// in memory whole
+class archive_reader
+{
+public:
+    /// Throws std::runtime_error if filename can't be opened as an archive
+    explicit archive_reader(const std::string &filename);
+    ~archive_reader();
+
+    archive_reader(const archive_reader &) = delete;
+    archive_reader &operator=(const archive_reader &) = delete;
+
+    /// Pass the data of the entry name to sink in chunks. Returns false if there is no such entry
+    /// and throws std::runtime_error if it can't be read.
+    bool read(const std::string &name, const byte_sink &sink) const;
+
+private:
+    std::unique_ptr<libzippp::ZipArchive> m_zip;
+};
+
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace docsmith
+{
+
+/// Length of the base64 (RFC 4648, padded) encoding of n bytes
+constexpr std::size_t base64_size(std::size_t n) { return (n + 2) / 3 * 4; }
+
+/// Encode in to out, which must have room for base64_size(in.size()) characters. Returns the end
+/// of the output. Inputs split at multiples of 3 bytes can be encoded a chunk at a time.
+inline char *base64_encode(std::string_view in, char *out)
+{
+    constexpr const char *alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    auto byte = [&](std::size_t i) {
+        return static_cast<unsigned>(static_cast<unsigned char>(in[i]));
+    };
+
+    std::size_t i = 0;
+    for(; i + 3 <= in.size(); i += 3)
+    {
+        unsigned v = byte(i) << 16 | byte(i + 1) << 8 | byte(i + 2);
+        *out++ = alphabet[v >> 18];
+        *out++ = alphabet[v >> 12 & 63];
+        *out++ = alphabet[v >> 6 & 63];
+        *out++ = alphabet[v & 63];
+    }
+    if(auto rest = in.size() - i; rest > 0)
+    {
+        unsigned v = byte(i) << 16 | (rest == 2 ? byte(i + 1) << 8 : 0);
+        *out++ = alphabet[v >> 18];
+        *out++ = alphabet[v >> 12 & 63];
+        *out++ = rest == 2 ? alphabet[v >> 6 & 63] : '=';
+        *out++ = '=';
+    }
+    return out;
+}
+
+inline std::string base64_encode(std::string_view in)
+{
+    std::string r(base64_size(in.size()), '\0');
+    base64_encode(in, r.data());
+    return r;
+}
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+#include "docsmithcpp/forward_decl.h"
+#include "docsmithcpp/text_search.h"
+
+namespace docsmith
+{
+
+/// The text of one block (a paragraph or heading) as a single string, with a map back to the
+/// text nodes it came from. Words split over spans, hyperlinks and plain text runs can then be
+/// matched as they read.
+///
+/// Element is element, or const element for a block that must not be changed: the runs then refer
+/// to const text nodes. Use the block_text and const_block_text aliases.
+template <typename Element>
+class basic_block_text
+{
+public:
+    using text_type = const_like_t<Element, text>;
+
+    /// Where one text node's characters start in the block string
+    struct run
+    {
+        text_type *m_node;
+        std::size_t m_start;
+    };
+
+    basic_block_text() = default;
+    explicit basic_block_text(Element &block);
+
+    /// Collect the text of another block, reusing the storage
+    void assign(Element &block);
+
+    Element &block() const { return *m_block; }
+    const std::string &str() const { return m_str; }
+    const std::vector<run> &runs() const { return m_runs; }
+
+    /// The text node and node offset for a block offset. Offsets on a boundary between runs
+    /// resolve to the later run, skipping empty ones, so an offset before the end of str() always
+    /// resolves to the run holding its byte. Must not be called for a block without text.
+    basic_text_hit<text_type> locate(std::size_t offset) const;
+
+    /// Index into runs() of the run holding offset, with the same rule as locate()
+    std::size_t run_index(std::size_t offset) const;
+
+private:
+    void collect(Element &e);
+
+    Element *m_block{nullptr};
+    std::string m_str;
+    std::vector<run> m_runs;
+};
+
+using block_text = basic_block_text<element>;
+using const_block_text = basic_block_text<const element>;
+
+/// Call fn for each paragraph and heading below root, in document order. The text of a nested
+/// paragraph (e.g. in a list item) belongs to that paragraph only.
+void for_each_block(element &root, const std::function<void(element &)> &fn);
+void for_each_block(const element &root, const std::function<void(const element &)> &fn);
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace docsmith
+{
+
+/// Blocking queue with a fixed capacity, for handing work between pipeline stages. A full queue
+/// holds back the producer so that memory stays bounded however far ahead it is.
+template <typename T>
+class bounded_queue
+{
+public:
+    explicit bounded_queue(std::size_t capacity) :
+        m_capacity(capacity)
+    {
+    }
+
+    /// Wait for space and add value. Returns false, dropping value, if the queue was closed.
+    bool push(T value)
+    {
+        std::unique_lock lock(m_mutex);
+        m_not_full.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if(m_closed)
+            return false;
+        m_items.push_back(std::move(value));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /// Wait for an item. Returns nullopt once the queue is closed and empty.
+    std::optional<T> pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_not_empty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if(m_items.empty())
+            return std::nullopt;
+        T value = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return value;
+    }
+
+    /// No more items will be pushed. Items already queued can still be popped.
+    void close()
+    {
+        std::lock_guard lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+private:
+    std::size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_closed{false};
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+};
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+
+namespace docsmith
+{
+
+/// Counts of a document or part of one
+struct text_counts
+{
+    std::size_t m_words{0};      //!< Runs of non-whitespace characters
+    std::size_t m_chars{0};      //!< Unicode characters, including spaces
+    std::size_t m_paragraphs{0};
+    std::size_t m_headings{0};
+
+    text_counts &operator+=(const text_counts &rhs);
+    text_counts &operator-=(const text_counts &rhs);
+    bool operator==(const text_counts &rhs) const = default;
+};
+
+/// Word, character, paragraph and heading counts, kept up to date as the document changes.
+///
+/// Counts are cached for each paragraph and heading and for each element containing them. A change
+/// reported through element::notify() recounts only the affected block (or the added subtree) and
+/// applies the difference along its path to the root, so totals() is O(1) and an edit costs
+/// O(block size + depth). Words and characters are counted over a block's text as it reads, so a
+/// word split across spans counts once.
+///
+/// Use text_doc::stats(), which forwards the document's changes here.
+class doc_stats
+{
+public:
+    explicit doc_stats(element &root);
+
+    /// Counts for the whole document
+    const text_counts &totals() const { return m_root_aggregate->m_totals; }
+
+    /// Counts for the blocks (paragraphs and headings) of each style. Unstyled blocks are under "".
+    const std::map<std::string, text_counts> &by_style() const
+    {
+        return m_root_aggregate->m_by_style;
+    }
+
+    /// Counts for the paragraphs and headings in the subtree at e. Text inside a block counts with
+    /// the block, so this is zero for a span that holds no nested paragraph.
+    text_counts of(element &e);
+
+    /// Apply a change below the root. Called by text_doc for each notification.
+    void update(element &origin, change_t kind);
+
+    /// Recount everything, e.g. after m_children was edited directly
+    void rebuild();
+
+    /// Number of elements with cached counts: the blocks, and the elements outside blocks
+    std::size_t cached() const { return m_cache.size(); }
+
+private:
+    struct aggregate
+    {
+        text_counts m_totals;
+        std::map<std::string, text_counts> m_by_style;
+        std::vector<const element *> m_below; //!< The nearest cached elements below this one
+    };
+
+    aggregate compute(element &e, bool inside_block);
+    /// Drop the entries below e, found through m_below as the elements may be destroyed already
+    void forget_below(const element *e);
+    void apply(element &target, const aggregate &old, const aggregate &now);
+
+    element *m_root;
+    std::unordered_map<const element *, aggregate> m_cache;
+    aggregate *m_root_aggregate{nullptr};
+};
+}
@@ -0,0 +1,161 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/zip_writer.h"
+
+namespace docsmith::docx
+{
+
+/// Passes the bytes of a picture to the sink in as many pieces as it likes. Returns false if
+/// there is no picture with that URI.
+using media_reader = std::function<bool(const std::string &uri, const byte_sink &sink)>;
+
+/// Size of a picture in EMU, 914400 to the inch
+struct extent
+{
+    long long m_cx;
+    long long m_cy;
+};
+
+/// Used when the size of a picture isn't known: 2 inches square
+inline constexpr extent default_image_extent{1828800, 1828800};
+
+/// Prints a DOCX package from one call per element, in document order. word/document.xml is
+/// printed as the calls are made. Only what the later parts need is kept: the styles and
+/// numbering in use, the relationships and the pictures. So memory doesn't grow with the length
+/// of the document. docx::writer drives it from a tree, and odt::convert_to_docx from the
+/// events of an ODT content.xml.
+class document_writer
+{
+public:
+    /// Add the parts which are the same for every package
+    static void begin_package(zip_writer &zip);
+
+    /// Print word/document.xml into out, which must outlive end_document
+    void begin_document(output_buffer &out);
+    void end_document();
+
+    /// Start a paragraph, or a heading when outline_level (0 for heading level 1) isn't negative.
+    /// Headings without a style get "Heading<level>". Blocks within a block are written inline.
+    void begin_block(std::string_view style, int outline_level = -1);
+    void end_block();
+
+    /// Start a list. A nested list continues the numbering of the outermost list, and its level
+    /// in that list's style is used.
+    void begin_list(const list_style *style);
+    void end_list();
+    void begin_item();
+
+    /// Text takes the style of the innermost styled span
+    void begin_span(std::string_view style);
+    void end_span();
+    void text(std::string_view s);
+
+    /// A URL starting with '#' links to the bookmark it names
+    void begin_hyperlink(std::string_view url);
+    void end_hyperlink();
+
+    void bookmark(std::string_view name);
+
+    /// A picture, stored in the package as word/media/image<n>
+    void image(const std::string &uri, extent size);
+
+    /// Add the parts which depend on what was printed: styles.xml with each of styles,
+    /// numbering.xml, the relationships, [Content_Types].xml and the pictures, which are read with
+    /// read_media. Then finish the archive.
+    void end_package(zip_writer &zip, const style_registry &styles, const media_reader &read_media);
+
+private:
+    struct open_list
+    {
+        int m_num_id;         //!< Numbering instance, shared by the nested lists
+        bool m_item_numbered; //!< The current item has had its numbered paragraph
+    };
+
+    struct numbering_def
+    {
+        const list_style *m_style; //!< nullptr for lists without a registered style
+        int m_levels{1};           //!< Levels used, at least
+    };
+
+    struct num_instance
+    {
+        std::size_t m_def; //!< Index into m_numbering_defs
+        bool m_restart;    //!< An earlier instance used the same definition
+    };
+
+    struct relationship
+    {
+        std::string m_type;   //!< Last segment of the relationship type, e.g. "hyperlink"
+        std::string m_target; //!< Path relative to word/, or an external URL
+        bool m_external{false};
+    };
+
+    struct media_item
+    {
+        std::string m_source; //!< URI it is read from
+        std::string m_dest;   //!< Destination within the archive
+    };
+
+    /// Add the part name to zip, printed by print through m_out
+    void write_part(zip_writer &zip, const std::string &name, const std::function<void()> &print);
+
+    void write_styles(const style_registry &styles);
+    void write_numbering();
+    void write_relationships();
+    void write_content_types();
+
+    void begin_run();
+    void write_escaped(std::string_view s, bool attribute = false);
+    void write_number(long long n);
+    std::string add_relationship(relationship r);
+
+    output_buffer *m_out{nullptr};
+
+    int m_block_depth{0};                 //!< Open blocks, including those written inline
+    std::vector<std::string> m_spans;     //!< Style of each span, kept to reuse its capacity
+    std::size_t m_span_depth{0};          //!< Open spans, the first entries of m_spans
+    std::vector<open_list> m_lists;       //!< Open lists, outermost first
+    int m_bookmarks{0};                   //!< Bookmark ids handed out
+    int m_drawings{0};                    //!< Drawing ids handed out
+
+    std::set<std::string, std::less<>> m_character_styles; //!< Styles used by spans
+    std::set<std::string, std::less<>> m_block_styles;     //!< Styles used by blocks
+    std::set<int> m_heading_levels; //!< Levels of headings without a style
+
+    std::vector<numbering_def> m_numbering_defs;
+    std::unordered_map<const list_style *, std::size_t> m_numbering_def_index;
+    std::vector<num_instance> m_nums; //!< Numbering instance n is m_nums[n - 1]
+
+    std::vector<relationship> m_relationships{
+        {"styles", "styles.xml"}, {"numbering", "numbering.xml"}}; //!< rId<n> is [n - 1]
+    std::unordered_map<std::string, std::string> m_link_ids;  //!< URL to its relationship id
+    std::vector<media_item> m_media;
+    std::unordered_map<std::string, std::string> m_media_ids; //!< Source to its relationship id
+};
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <future>
+#include <string>
+
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+class docx_file
+{
+public:
+    explicit docx_file(const std::string &filename);
+
+    /// Read the document, see docx::read. Parts are inflated and parsed in chunks, so memory use
+    /// doesn't grow with the size of word/document.xml.
+    text_doc parse_text_doc();
+
+    /// Write doc to the file, see docx::writer
+    void save(const text_doc &doc);
+
+    /// Save on background threads, see docx::writer::write_async. doc must outlive the future.
+    std::future<void> async_save(const text_doc &doc);
+
+    const std::string &filename() const { return m_filename; }
+
+private:
+    std::string m_filename;
+};
+
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <functional>
+#include <string>
+
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/zip_writer.h"
+
+namespace docsmith::docx
+{
+
+/// Streams the part of a package with the given name to the sink, in as many pieces as it likes.
+/// Returns false if the package has no such part.
+using part_reader = std::function<bool(const std::string &name, const byte_sink &sink)>;
+
+/// Build a text_doc from the parts of a DOCX package. Each part is parsed as it streams in, so no
+/// XML tree of it is ever held in memory.
+///
+/// - Paragraphs become paragraphs, or headings when their own or their style's outline level is
+///   set (outline level 0 is heading level 1).
+/// - Runs become spans, with the run style as their style.
+/// - Numbered paragraphs are gathered into (nested) lists, with a list style "WWNum<id>" made
+///   from each numbering definition in numbering.xml.
+/// - Hyperlinks become hyperlinks, to their external target or "#<anchor>".
+/// - Pictures become images in frames, with the package path of the picture as the URI.
+/// - Paragraph and character styles go into the style registry, with their font and
+///   page-break properties.
+///
+/// Table paragraphs are read in document order without the table. Text boxes are skipped.
+/// Throws std::runtime_error if a part isn't well formed or the main document is missing.
+text_doc read(const part_reader &parts);
+}
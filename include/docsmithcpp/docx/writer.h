@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <future>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "docsmithcpp/docx/document_writer.h"
+
+namespace docsmith::docx
+{
+
+/// Writes a text_doc as a DOCX package, through the same zip_writer and pipeline as odt::writer.
+/// word/document.xml is printed straight into its archive entry by a document_writer while the
+/// tree is visited, so no XML tree is built for it. The parts which depend on what was visited
+/// follow it:
+///
+/// - styles.xml has a style per entry in the style registry. Styles used by spans are character
+///   styles and all others paragraph styles. Headings without a style get "Heading<level>".
+/// - numbering.xml has a numbering definition per list style in use. Each top level list is a
+///   numbering instance of its own, so its numbering restarts.
+/// - Images are read from their URI on the filesystem and stored as word/media/image<n>.
+///
+/// docx::read reads the result back into the same tree, except that text directly in a block comes
+/// back wrapped in a span, and list items with more than one block are split. Page breaks after a
+/// paragraph have no DOCX equivalent and are dropped.
+class writer : private element_visitor
+{
+public:
+    static void write(const text_doc &doc, const std::string &filename);
+
+    /// Write the package to a stream. word/document.xml is compressed as it is printed.
+    static void write(const text_doc &doc, std::ostream &os);
+
+    /// Write the package into memory
+    static std::vector<std::byte> write(const text_doc &doc);
+
+    /// Write the package on background threads and return straight away, see
+    /// odt::writer::write_async. doc must stay alive and unmodified until the future is ready.
+    static std::future<void> write_async(const text_doc &doc, const std::string &filename);
+
+private:
+    void visit(const class text &) override;
+    void visit(const class span &) override;
+
+    void visit(const class heading &) override;
+    void visit(const class paragraph &) override;
+
+    void visit(const class hyperlink &) override;
+    void visit(const class text_doc &) override;
+
+    void visit(const class list &) override;
+    void visit(const class list_item &) override;
+    void visit(const class list_style_num &) override { }
+    void visit(const class list_style_bullet &) override { }
+
+    void visit(const class frame &) override;
+    void visit(const class image &) override;
+
+    void visit(const class bookmark &) override;
+
+    void push() override;
+    void pop() override;
+
+private:
+    enum class open_t : char
+    {
+        other,
+        block,
+        span,
+        hyperlink,
+        list
+    };
+
+    writer() = default;
+
+    /// Visit doc and write all parts of it to the archive. When pipelined, document.xml is
+    /// produced, compressed and written on separate threads.
+    void write_archive(zip_writer &zip, const text_doc &doc, bool pipelined);
+
+    document_writer m_document;
+    const text_doc *m_doc{nullptr};
+
+    std::vector<open_t> m_open;   //!< Each element between push and pop
+    open_t m_next{open_t::other}; //!< The element just visited
+};
+}
@@ -16,6 +16,7 @@
  * limitations under the License.
  *****************************************************************************/
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <memory>
@@ -47,11 +48,45 @@ enum class elem_t
     bookmark, // Bookmark
 };
 
+template <typename Derived>
+struct nodes;
+
+class handle_table;
+
+/// An element's slot in a handle_table. Allocated the first time a handle to the element is taken.
+struct handle_link
+{
+    std::weak_ptr<handle_table> m_table;
+    std::uint32_t m_index;
+};
+
+/// T with the constness of E, e.g. the text nodes found below a const element are const text
+template <typename E, typename T>
+using const_like_t = std::conditional_t<std::is_const_v<E>, const T, T>;
+
+/// What changed, for element::notify()
+enum class change_t
+{
+    text,     //!< The text of a text node
+    style,    //!< The style of an element
+    added,    //!< The element was added to its parent
+    children, //!< The element's children were replaced
+};
+
 /// Base class for all document elements
+///
+/// Const members don't change the tree or any state shared between readers, except for caches
+/// which are built under a lock (text_doc::get_outline()). So any number of threads can read one
+/// document through const references at once, e.g. with accept(), find_all() and
+/// selector::select(), without copying it, as long as no thread modifies it meanwhile.
 class element
 {
 public:
-    virtual ~element() = default;
+    element() = default;
+    // A copy is not part of the original's tree, so the parent and handle aren't copied:
+    element(const element &) {}
+    element &operator=(const element &) { return *this; }
+    virtual ~element(); // Invalidates any handles to this element
     virtual void accept(class element_visitor &) const = 0;
     virtual std::unique_ptr<element> clone() const = 0;
     virtual bool is_equal(const element &other) const
@@ -68,40 +103,124 @@ public:
     // Default element has no children
     virtual std::list<element *> children() { return {}; }
 
+    /// The children, read only
+    std::list<const element *> children() const
+    {
+        std::list<const element *> r;
+        if(const auto *kids = child_list())
+            for(const auto &c : *kids)
+                r.push_back(c.get());
+        return r;
+    }
+
+    /// The children owned by this element, or nullptr if it has none. Unlike children() this
+    /// doesn't build a temporary list, so it is the cheaper way to walk the tree.
+    virtual const std::list<std::unique_ptr<element>> *child_list() const { return nullptr; }
+
     virtual elem_t type() const = 0;
     virtual bool is_type(elem_t query) const = 0;
 
     template <typename T>
     std::vector<T *> get_elem_of()
     {
-        std::vector<T *> r;
-
-        if(auto *me = dynamic_cast<T *>(this))
-            r.push_back(me);
+        return find_all<T>([](const element *) { return true; });
+    }
 
-        for(auto *c : children())
-        {
-            auto kids = c->get_elem_of<T>();
-            r.insert(r.end(), kids.begin(), kids.end());
-        }
-        return r;
+    template <typename T>
+    std::vector<const T *> get_elem_of() const
+    {
+        return find_all<T>([](const element *) { return true; });
     }
 
     template <typename T, typename Predicate>
     std::vector<T *> find_all(Predicate pred)
     {
         std::vector<T *> r;
+        collect<T>(*this, pred, r);
+        return r;
+    }
 
-        if(auto *me = dynamic_cast<T *>(this); me && pred(this))
-            r.push_back(me);
+    template <typename T, typename Predicate>
+    std::vector<const T *> find_all(Predicate pred) const
+    {
+        std::vector<const T *> r;
+        collect<const T>(*this, pred, r);
+        return r;
+    }
+
+    /// The element this is a child of, or nullptr for a root. Kept up to date by nodes::add(),
+    /// add_child(), copies and moves, but not by direct changes to nodes::m_children.
+    element *parent() { return m_parent; }
+    const element *parent() const { return m_parent; }
+
+    /// The path to the root, nearest ancestor first
+    std::vector<element *> ancestors()
+    {
+        std::vector<element *> r;
+        for(auto *p = m_parent; p; p = p->m_parent)
+            r.push_back(p);
+        return r;
+    }
 
-        for(auto *c : children())
-        {
-            auto kids = c->find_all<T>(pred);
-            r.insert(r.end(), kids.begin(), kids.end());
-        }
+    std::vector<const element *> ancestors() const
+    {
+        std::vector<const element *> r;
+        for(const auto *p = m_parent; p; p = p->m_parent)
+            r.push_back(p);
         return r;
     }
+
+    /// This element or its nearest ancestor of type T, or nullptr. For example, the paragraph a
+    /// text node belongs to.
+    template <typename T>
+    T *closest()
+    {
+        for(auto *e = this; e; e = e->m_parent)
+            if(auto *t = dynamic_cast<T *>(e))
+                return t;
+        return nullptr;
+    }
+
+    template <typename T>
+    const T *closest() const
+    {
+        for(const auto *e = this; e; e = e->m_parent)
+            if(const auto *t = dynamic_cast<const T *>(e))
+                return t;
+        return nullptr;
+    }
+
+    /// Report a change to this element to it and each of its ancestors. Done by the library's own
+    /// mutators; call it after changing members such as text::m_text directly.
+    void notify(change_t kind)
+    {
+        for(auto *e = this; e; e = e->m_parent)
+            e->on_change(*this, kind);
+    }
+
+protected:
+    /// Called by notify() for changes to this element or one of its descendants (origin)
+    virtual void on_change(element &origin, change_t kind) {}
+
+private:
+    /// Append the elements of type T in e's subtree that satisfy pred to out, in document order.
+    /// T is const qualified when called through a const element.
+    template <typename T, typename E, typename Predicate>
+    static void collect(E &e, Predicate &pred, std::vector<T *> &out)
+    {
+        if(auto *me = dynamic_cast<T *>(&e); me && pred(&e))
+            out.push_back(me);
+        if(const auto *kids = e.child_list())
+            for(const auto &c : *kids)
+                collect<T>(static_cast<E &>(*c), pred, out);
+    }
+
+    template <typename Derived>
+    friend struct nodes;
+    friend class handle_table;
+
+    element *m_parent{nullptr};
+    std::unique_ptr<handle_link> m_handle;
 };
 
 template <typename Derived, elem_t TypeTag>
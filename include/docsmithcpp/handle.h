@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+
+namespace docsmith
+{
+
+/// A reference to an element that can be kept across edits. Resolving it gives nullptr once the
+/// element has been destroyed, rather than a dangling pointer. Get one from text_doc::get_handle().
+template <typename T = element>
+struct handle
+{
+    std::uint32_t m_index{0};      //!< Slot in the handle_table
+    std::uint64_t m_generation{0}; //!< Must match the slot's; 0 for a null handle
+
+    explicit operator bool() const { return m_generation != 0; }
+    bool operator==(const handle &) const = default;
+};
+
+/// Slots for the elements of one document that handles have been taken to. An element keeps its
+/// slot for its lifetime and its destructor frees it. Generations are unique across all tables,
+/// so a handle can never resolve to a later occupant of its slot, or to an element of another
+/// document.
+///
+/// Taking and resolving handles are O(1). Not thread safe, like edits to the tree itself.
+class handle_table : public std::enable_shared_from_this<handle_table>
+{
+public:
+    /// A handle to e. Repeated calls return the same handle while e lives.
+    template <typename T>
+    handle<T> acquire(T &e)
+    {
+        auto [index, generation] = acquire_slot(e);
+        return {index, generation};
+    }
+
+    /// The element h refers to, or nullptr if it is null, has been destroyed or is from another
+    /// table
+    template <typename T>
+    T *resolve(handle<T> h) const
+    {
+        auto *e = lookup(h.m_index, h.m_generation);
+        if constexpr(std::is_same_v<T, element>)
+            return e;
+        else
+            return e ? dynamic_cast<T *>(e) : nullptr;
+    }
+
+    /// Number of elements with a live handle
+    std::size_t size() const { return m_slots.size() - m_free.size(); }
+
+private:
+    friend class element;
+
+    struct slot
+    {
+        element *m_element;
+        std::uint64_t m_generation;
+    };
+
+    std::pair<std::uint32_t, std::uint64_t> acquire_slot(element &e);
+    element *lookup(std::uint32_t index, std::uint64_t generation) const;
+    void release(std::uint32_t index);
+
+    std::vector<slot> m_slots;
+    std::vector<std::uint32_t> m_free;
+};
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+struct html_options
+{
+    /// Loads the bytes of an image by its URI, so that it can be embedded as a data URI. Images
+    /// it returns nullopt for, and all images when it is empty, are written as references.
+    std::function<std::optional<std::string>(const std::string &uri)> m_load_image;
+
+    std::string m_title; //!< Content of the <title> element
+};
+
+/// Streams a tree as HTML into an output_buffer. Writing a text_doc gives a complete page whose
+/// stylesheet is generated once from the style registry: each style with text or paragraph
+/// properties becomes a class, with the properties of its parent styles folded in, and elements
+/// refer to it by name rather than carrying inline styles. Other elements are written as a
+/// fragment without classes.
+class html_writer : public element_visitor
+{
+public:
+    explicit html_writer(output_buffer &out, html_options options = {});
+
+    void visit(const text_doc &d) override;
+    void visit(const heading &h) override;
+    void visit(const paragraph &p) override;
+    void visit(const span &s) override;
+    void visit(const hyperlink &href) override;
+    void visit(const text &t) override;
+    void visit(const list &l) override;
+    void visit(const list_item &li) override;
+    void visit(const frame &) override;
+    void visit(const image &i) override;
+    void visit(const bookmark &b) override;
+
+    void push() override;
+    void pop() override;
+
+    /// CSS class generated for the style named name, or an empty string if there is none
+    const std::string &class_of(const style_name &name) const;
+
+private:
+    enum class open_t : char
+    {
+        other,
+        block,
+        list
+    };
+    struct open_element
+    {
+        std::string_view m_close; //!< Closing tag, written on pop
+        open_t m_kind{open_t::other};
+    };
+
+    void write_stylesheet(const style_registry &styles);
+    void open_tag(std::string_view tag, const style_name &style);
+    void write_escaped(std::string_view s, bool attribute);
+    void write_image_src(const std::string &uri);
+
+    output_buffer &m_out;
+    html_options m_options;
+    const text_doc *m_doc{nullptr};
+    std::unordered_map<std::string, std::string> m_classes; //!< Style name to CSS class
+    std::vector<open_element> m_open;        //!< Each element between push and pop
+    std::vector<const list_style *> m_lists; //!< Style of each open list, outermost first
+    open_element m_next;                     //!< The element just visited
+    int m_block_depth{0};                    //!< Open paragraphs and headings
+};
+
+/// Write e as HTML into out. Call out.flush() to see write errors.
+void write_html(const element &e, output_buffer &out, html_options options = {});
+
+/// e as an HTML string
+std::string to_html(const element &e, html_options options = {});
+}
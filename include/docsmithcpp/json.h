@@ -0,0 +1,102 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+/// Streams a tree as JSON into an output_buffer, with no intermediate JSON tree.
+///
+/// Schema (version 1). A document is an object
+///
+///     {"docsmith": 1, "styles": [style...], "list_styles": [list style...], "body": [element...]}
+///
+/// A style is {"name", "parent", "text", "paragraph", "graphics"}, where all but "name" are
+/// optional and
+///
+///     "text":      {"font_size": points, "font_style": "normal" | "italic" | "oblique",
+///                   "font_name": string}
+///     "paragraph": {"break_before": break, "break_after": break}, with break one of
+///                  "column" | "page" | "even_page" | "odd_page" | "auto"
+///     "graphics":  {"horiz_pos": "left" | "centre" | "right" | "from_inside" | "from_left" |
+///                   "inside" | "outside",
+///                   "vert_pos": "top" | "middle" | "bottom" | "from_top" | "below"}
+///
+/// A list style is {"name", "levels": [level...]} where each level is one of
+///
+///     {"level": n, "bullet": string, "style": string}
+///     {"level": n, "format": "1" | "a" | "A" | "i" | "I", "prefix": string, "suffix": string,
+///      "start": n, "style": string, "text": text properties}
+///
+/// An element is an object with a "type", and a "style" and "children" for those that have them:
+///
+///     "p", "span", "list", "item", "frame"
+///     "h" with "level": n
+///     "a" with "url": string
+///     "image" with "uri": string (no children)
+///     "bookmark" with "name": string (no children)
+///
+/// A text element is a plain string in "children". Members with empty or default values may be
+/// left out, and readers ignore members they don't know.
+class json_writer : public element_visitor
+{
+public:
+    explicit json_writer(output_buffer &out);
+
+    void visit(const text_doc &d) override;
+    void visit(const heading &h) override;
+    void visit(const paragraph &p) override;
+    void visit(const span &s) override;
+    void visit(const hyperlink &href) override;
+    void visit(const text &t) override;
+    void visit(const list &l) override;
+    void visit(const list_item &) override;
+    void visit(const frame &f) override;
+    void visit(const image &i) override;
+    void visit(const bookmark &b) override;
+
+    void push() override;
+    void pop() override;
+
+private:
+    void begin(std::string_view type);
+    void write_member(std::string_view key, std::string_view value);
+    void write_style(const style_name &s);
+    void write_string(std::string_view s);
+    void write_styles(const text_doc &d);
+
+    output_buffer &m_out;
+    bool m_first{true};                          //!< No element written yet at this level
+    std::string_view m_children_key{"children"}; //!< Key of the element just visited's children
+};
+
+/// Write e as JSON into out. Call out.flush() to see write errors.
+void write_json(const element &e, output_buffer &out);
+
+/// e as a JSON string
+std::string to_json(const element &e);
+
+/// Read a document written by write_json(). Throws std::runtime_error, with the byte offset, if
+/// json isn't valid JSON or doesn't follow the schema.
+text_doc read_json(std::string_view json);
+}
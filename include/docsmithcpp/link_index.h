@@ -0,0 +1,105 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+#include "docsmithcpp/forward_decl.h"
+
+namespace docsmith
+{
+
+/// An internal hyperlink (one whose URL starts with '#') and the bookmark it refers to
+template <typename Element>
+struct basic_internal_link
+{
+    const_like_t<Element, hyperlink> *m_link;
+    std::string m_name;                         //!< Bookmark name from the URL, percent-decoded
+    const_like_t<Element, bookmark> *m_target; //!< nullptr if there is no such bookmark
+};
+
+using internal_link = basic_internal_link<element>;
+using const_internal_link = basic_internal_link<const element>;
+
+/// Bookmarks by name and internal hyperlinks with their targets, found in a single pass over a
+/// document. Lookups are O(1) afterwards.
+///
+/// Links with a LibreOffice target type suffix such as "#Table1|table" or "#1.Intro|outline" point
+/// at objects other than bookmarks, and are skipped.
+///
+/// Element is const element to index a document through a const reference, which gives const
+/// links and bookmarks. Use the link_index and const_link_index aliases.
+template <typename Element>
+class basic_link_index
+{
+public:
+    using bookmark_type = const_like_t<Element, bookmark>;
+    using link_type = basic_internal_link<Element>;
+
+    basic_link_index() = default;
+    explicit basic_link_index(Element &root) { build(root); }
+
+    /// Replace the contents with the links and bookmarks below root
+    void build(Element &root);
+
+    /// The bookmark with the given name, or nullptr. The first one wins if names repeat.
+    bookmark_type *find_bookmark(std::string_view name) const;
+
+    /// The bookmark link refers to, or nullptr if it is dangling or not an internal link
+    bookmark_type *target(const hyperlink &link) const;
+
+    /// All internal links, in document order
+    const std::vector<link_type> &links() const { return m_links; }
+
+    /// Internal links with no matching bookmark, in document order
+    std::vector<const link_type *> dangling() const;
+
+    /// Bookmark names used more than once
+    const std::vector<std::string> &duplicate_bookmarks() const { return m_duplicates; }
+
+    /// Is url a reference to a bookmark in the same document? If so, name is set to the bookmark
+    /// name.
+    static bool parse_internal_url(std::string_view url, std::string &name);
+
+private:
+    void collect(Element &e);
+
+    std::unordered_map<std::string, bookmark_type *> m_bookmarks;
+    std::vector<link_type> m_links;
+    std::unordered_map<const hyperlink *, std::size_t> m_link_index;
+    std::vector<std::string> m_duplicates;
+};
+
+using link_index = basic_link_index<element>;
+using const_link_index = basic_link_index<const element>;
+
+/// The outcome of validating the links of one document
+struct link_report
+{
+    std::vector<std::string> m_dangling;   //!< Names of internal links without a bookmark
+    std::vector<std::string> m_duplicates; //!< Bookmark names used more than once
+    bool ok() const { return m_dangling.empty() && m_duplicates.empty(); }
+};
+
+/// Validate the internal links of many documents on a pool of threads, one report per root in
+/// order. threads = 0 uses one per hardware thread.
+std::vector<link_report> validate_links(const std::vector<element *> &roots, unsigned threads = 0);
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+/// Streams a tree as CommonMark into an output_buffer, so memory use is bounded by the buffer
+/// whatever the size of the document. Headings map to ATX headings (levels past 6 are clamped),
+/// lists to nested bullet or ordered lists, hyperlinks and images to inline links, and spans
+/// whose style is italic to emphasis. List and span styles are looked up in the text_doc being
+/// written; a list without a style of its own continues the style of the list it is nested in.
+///
+/// Markdown only has arabic numbering, so ordered lists keep their start and ')' suffix but
+/// alphabetic and roman formats are written as numbers.
+class markdown_writer : public element_visitor
+{
+public:
+    explicit markdown_writer(output_buffer &out);
+
+    void visit(const text_doc &d) override;
+    void visit(const heading &h) override;
+    void visit(const paragraph &p) override;
+    void visit(const span &s) override;
+    void visit(const hyperlink &href) override;
+    void visit(const text &t) override;
+    void visit(const list &l) override;
+    void visit(const list_item &li) override;
+    void visit(const frame &) override;
+    void visit(const image &i) override;
+
+    void push() override;
+    void pop() override;
+
+private:
+    enum class open_t : char
+    {
+        other,
+        block,
+        list,
+        item,
+        link,
+        emphasis
+    };
+
+    /// An open list. The indents are in columns, as list content must line up with the text
+    /// after its marker for nested blocks to stay in the item.
+    struct list_level
+    {
+        const list_style *m_style{nullptr};
+        bool m_numbered{false};
+        char m_delim{'.'};
+        int m_next{1};                //!< Number of the next item
+        std::size_t m_indent{0};      //!< Column of the marker
+        std::size_t m_content{0};     //!< Column of the item content
+        bool m_marker_pending{false}; //!< The item's first block hasn't started yet
+    };
+
+    void begin_block();
+    void write_indent(std::size_t columns);
+    void write_marker(list_level &l);
+    void write_escaped(std::string_view s);
+    void write_url(std::string_view url);
+
+    output_buffer &m_out;
+    const text_doc *m_doc{nullptr};
+    std::vector<open_t> m_open;               //!< Kind of each element between push and pop
+    std::vector<list_level> m_lists;          //!< Open lists, outermost first
+    std::vector<const hyperlink *> m_links;   //!< Open hyperlinks, for their URLs on pop
+    open_t m_next{open_t::other};             //!< Kind of the element just visited
+    int m_block_depth{0};                     //!< Open paragraphs and headings
+    bool m_line_start{false};                 //!< Nothing but markup written on this line yet
+};
+
+/// Write e as Markdown into out. Call out.flush() to see write errors.
+void write_markdown(const element &e, output_buffer &out);
+
+/// e as a Markdown string
+std::string to_markdown(const element &e);
+}
@@ -90,7 +90,7 @@ struct nodes : virtual element
     {
         std::cout << "copy constructor\n";
         for(const auto &child : other.m_children)
-            m_children.push_back(child->clone());
+            adopt(m_children.emplace_back(child->clone()));
     }
     nodes &operator=(const nodes &other)
     {
@@ -99,17 +99,26 @@ struct nodes : virtual element
         {
             m_children.clear();
             for(const auto &child : other.m_children)
-                m_children.push_back(child->clone());
+                adopt(m_children.emplace_back(child->clone()));
+            notify(change_t::children);
         }
         return *this;
     }
 
-    nodes(nodes &&other) { m_children = std::move(other.m_children); }
+    nodes(nodes &&other)
+    {
+        m_children = std::move(other.m_children);
+        for(auto &child : m_children)
+            adopt(child);
+    }
     nodes &operator=(nodes &&other)
     {
         if(this != &other)
         {
             m_children = std::move(other.m_children);
+            for(auto &child : m_children)
+                adopt(child);
+            notify(change_t::children);
         }
         return *this;
     }
@@ -137,16 +146,17 @@ struct nodes : virtual element
             // Have to copy then use the move constructor, if we use the constructor it will call
             // add which will be recursive...
             auto child_copy = child;
-            m_children.emplace_back(std::make_unique<DecayChild>(std::move(child_copy)));
+            adopt(m_children.emplace_back(std::make_unique<DecayChild>(std::move(child_copy))));
         }
         else if constexpr(std::is_rvalue_reference_v<ChildType>)
         {
             auto p = std::make_unique<DecayChild>(std::forward<Child>(child));
-            m_children.emplace_back(std::move(p));
+            adopt(m_children.emplace_back(std::move(p)));
         }
         else
             static_assert(false, "Unhandled reference type");
 
+        m_children.back()->notify(change_t::added);
         return *static_cast<Derived *>(this);
     }
     template <typename = Derived, typename = std::enable_if_t<is_valid_child_v<Derived, text>>>
@@ -157,6 +167,8 @@ struct nodes : virtual element
 
         // return add(text(t));
         add_text(m_children, t);
+        adopt(m_children.back());
+        m_children.back()->notify(change_t::added);
         return *static_cast<Derived *>(this);
     }
 
@@ -168,18 +180,22 @@ struct nodes : virtual element
 
         // return add(text(t));
         add_text(m_children, t);
+        adopt(m_children.back());
+        m_children.back()->notify(change_t::added);
         return *static_cast<Derived *>(this);
     }
 
     void add_child(std::unique_ptr<element> child) override
     {
         using U = std::remove_reference_t<decltype(*child)>;
-        m_children.push_back(std::move(child));
+        adopt(m_children.emplace_back(std::move(child)));
+        m_children.back()->notify(change_t::added);
     }
 
     auto begin() const { return m_children.begin(); }
     auto end() const { return m_children.end(); }
 
+    using element::children;
     std::list<element *> children()
     {
         std::list<element *> chldrn;
@@ -188,7 +204,12 @@ struct nodes : virtual element
         return chldrn;
     }
 
+    const std::list<std::unique_ptr<element>> *child_list() const override { return &m_children; }
+
     std::list<std::unique_ptr<element>> m_children;
+
+protected:
+    void adopt(const std::unique_ptr<element> &child) { child->m_parent = this; }
 };
 
 // clang-format off
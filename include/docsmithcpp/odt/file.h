@@ -15,13 +15,20 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *****************************************************************************/
+#pragma once
+#include <future>
+#include <memory>
 #include <string>
 
+#include <pugixml.hpp>
+
 #include "docsmithcpp/text_doc.h"
 
 namespace docsmith
 {
 
+/// An ODT document on disk. Files named *.fodt are Flat ODT: a single uncompressed XML file,
+/// which is parsed and saved without any archive (see odt::writer::write_flat).
 class odt_file
 {
 public:
@@ -31,10 +38,24 @@ public:
 
     void save(const text_doc &doc);
 
+    /// Save on background threads, see odt::writer::write_async. doc must outlive the future.
+    std::future<void> async_save(const text_doc &doc);
+
+    /// Save doc back into the archive it was parsed from, regenerating only content.xml. Every
+    /// other part, including ones which are not modelled (styles.xml, meta.xml, settings.xml,
+    /// thumbnails and pictures), is copied as raw compressed bytes without being inflated. For
+    /// Flat ODT only the body is regenerated and the rest of the source document is kept.
+    void save_update(const text_doc &doc);
+
+    /// As above, but leave this file as it is and write the updated archive to filename
+    void save_update(const text_doc &doc, const std::string &filename);
+
     const std::string &filename() const { return m_filename; }
 
     private:
     std::string m_filename;
+    bool m_flat{false};                                   //!< Flat ODT, from the file extension
+    std::shared_ptr<pugi::xml_document> m_source_content; //!< content.xml from parse_text_doc
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <string>
+
+#include "docsmithcpp/docx/reader.h"
+#include "docsmithcpp/zip_writer.h"
+
+namespace docsmith::odt
+{
+
+/// Convert an ODT package to DOCX without building a text_doc. styles.xml and then content.xml
+/// are parsed as they are inflated, and each element is printed straight into word/document.xml
+/// through a docx::document_writer, so the output matches docx::writer's. Memory doesn't grow
+/// with the document: only the styles, the list styles and a stack of open elements are held.
+///
+/// - Paragraph and text styles, and list styles, are mapped as they are read, with the
+///   properties odt::writer writes (font, size, slant, page breaks, numbering formats).
+/// - text:h becomes a heading at its outline level, text:p a paragraph and text:span a run.
+///   Spaces, tabs and line breaks are kept.
+/// - Pictures are copied from the ODT package into word/media, with the size of their frame.
+/// - Tables are flattened into their paragraphs. Notes, annotations and tracked changes are
+///   dropped.
+///
+/// With pipelined, parsing and printing, deflating and writing each run on their own thread.
+/// Throws std::runtime_error if a part isn't well formed or content.xml is missing.
+void convert_to_docx(const docx::part_reader &odt_parts, zip_writer &zip, bool pipelined = true);
+
+/// Convert the ODT file odt_filename to the DOCX file docx_filename
+void convert_to_docx(
+    const std::string &odt_filename, const std::string &docx_filename, bool pipelined = true);
+}
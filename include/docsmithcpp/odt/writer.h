@@ -16,13 +16,18 @@
  * limitations under the License.
  *****************************************************************************/
 #pragma once
+#include <cstddef>
+#include <future>
+#include <ostream>
 #include <set>
 #include <stack>
+#include <vector>
 
 #include <libzippp/libzippp.h>
 #include <pugixml.hpp>
 
 #include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/zip_writer.h"
 
 namespace docsmith::odt
 {
@@ -41,6 +46,39 @@ class writer : private element_visitor
 public:
     static void write(const text_doc &doc, const std::string &filename);
 
+    /// Write the archive to a stream. Output is produced incrementally (content.xml is compressed
+    /// as it is printed), so the first bytes reach the stream before the archive is complete.
+    static void write(const text_doc &doc, std::ostream &os);
+
+    /// Write the archive into memory
+    static std::vector<std::byte> write(const text_doc &doc);
+
+    /// Write the archive on background threads and return straight away. Visiting and printing
+    /// content.xml, deflating it and writing the file run as a bounded pipeline, one thread per
+    /// stage. doc must stay alive and unmodified until the future is ready; errors are reported
+    /// through the future.
+    static std::future<void> write_async(const text_doc &doc, const std::string &filename);
+
+    /// Replace the content.xml of an existing archive with doc. Every other entry is left untouched,
+    /// so libzip copies its compressed bytes over without inflating them. If base_content is given
+    /// (the content.xml the document was parsed from) its declarations and styles are kept and
+    /// only the body is regenerated. Styles in the document's registries replace base styles of
+    /// the same name. The body is written from the model, so paragraph, heading, span and list
+    /// styles survive but body content the model does not hold (tables, fields, direct attributes
+    /// other than the style) is lost.
+    static void update(const text_doc &doc, const std::string &filename,
+        const pugi::xml_document *base_content = nullptr);
+
+    /// Write doc as Flat ODT: a single uncompressed XML file with office:document as its root and
+    /// pictures embedded as base64 office:binary-data. There is no archive, manifest or deflate
+    /// pass. If base is given (the Flat ODT the document was parsed from) everything but the body
+    /// is kept from it, with the same limits as update().
+    static void write_flat(
+        const text_doc &doc, std::ostream &os, const pugi::xml_document *base = nullptr);
+
+    static void write_flat(
+        const text_doc &doc, const std::string &filename, const pugi::xml_document *base = nullptr);
+
 private:
     void visit(const class text &) override;
     void visit(const class span &) override;
@@ -81,12 +119,25 @@ private:
     pugi::xml_document m_manifest;        //!< Content for manifest.xml
     pugi::xml_node m_manifest_files_node; //!< Node containing mainifest file list
     std::set<archive_item> m_pictures;    //!< Pictures to add to the archive
+    bool m_flat{false};                   //!< Embed pictures rather than archiving them
+    bool m_update{false};                 //!< Writing over a parsed base document
 
     std::stack<pugi::xml_node> m_node_stack;
 
     pugi::xml_node m_current;
     pugi::xml_node get_current();
 
-    writer(std::string filename);
+    /// Where to write the style called name. When updating, a declaration of it in the base
+    /// (a tag element in office:styles or office:automatic-styles) is removed and its parent
+    /// returned, so the document's definition replaces it. Otherwise returns parent.
+    pugi::xml_node replace_base_style(
+        const char *tag, const std::string &name, pugi::xml_node parent);
+
+    writer(std::string filename, const pugi::xml_document *base_content = nullptr,
+        bool flat = false);
+
+    /// Visit doc and write all parts of it to the archive. When pipelined, content.xml is produced,
+    /// compressed and written on separate threads.
+    void write_archive(zip_writer &zip, const text_doc &doc, bool pipelined);
 };
 }
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+#include "docsmithcpp/forward_decl.h"
+
+namespace docsmith
+{
+
+/// One heading of a document and the top level blocks it covers
+struct section
+{
+    using block_iterator = std::list<std::unique_ptr<element>>::const_iterator;
+
+    const heading *m_heading;
+    int m_level;
+    std::size_t m_parent;                //!< Index of the enclosing section, or npos at top level
+    std::vector<std::size_t> m_children; //!< Indices of the sections directly below this one
+
+    /// The blocks of the section in text_doc::m_children: from the heading up to the next heading
+    /// of the same or a higher level, so subsections are included.
+    block_iterator m_begin;
+    block_iterator m_end;
+
+    /// The heading text, including any spans
+    std::string title() const;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+};
+
+/// The heading hierarchy of a document, built in one pass over its top level blocks. Tables of
+/// contents and section lookups then cost O(sections) rather than a walk of every node.
+///
+/// Use text_doc::get_outline() for an outline that is cached and rebuilt after edits.
+class outline
+{
+public:
+    explicit outline(const text_doc &doc);
+
+    /// All sections, in document order
+    const std::vector<section> &sections() const { return m_sections; }
+    const section &operator[](std::size_t n) const { return m_sections.at(n); }
+    std::size_t size() const { return m_sections.size(); }
+
+    /// Indices of the sections that have no enclosing section
+    const std::vector<std::size_t> &top_level() const { return m_top_level; }
+
+    /// The section with the given heading, or nullptr
+    const section *find(const heading &h) const;
+
+private:
+    std::vector<section> m_sections;
+    std::vector<std::size_t> m_top_level;
+};
+}
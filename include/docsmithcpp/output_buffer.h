@@ -0,0 +1,78 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace docsmith
+{
+
+/// A reusable growable byte buffer that flushes in large chunks, to a file descriptor or a
+/// callback. Exporters write into it a string at a time without allocating per write.
+class output_buffer
+{
+public:
+    using sink_fn = std::function<void(const char *data, std::size_t size)>;
+
+    /// Flush to sink whenever capacity bytes are buffered
+    explicit output_buffer(sink_fn sink, std::size_t capacity = 1 << 16);
+
+    /// Flush to an open file descriptor, which stays owned by the caller
+    explicit output_buffer(int fd, std::size_t capacity = 1 << 16);
+
+    output_buffer(const output_buffer &) = delete;
+    output_buffer &operator=(const output_buffer &) = delete;
+
+    /// Flushes what is left. Errors are lost here: call flush() first to see them.
+    ~output_buffer();
+
+    void write(std::string_view s)
+    {
+        if(s.size() > m_data.capacity() - m_data.size())
+            return write_slow(s);
+        m_data.insert(m_data.end(), s.begin(), s.end());
+    }
+
+    void put(char c)
+    {
+        if(m_data.size() == m_data.capacity())
+            flush();
+        m_data.push_back(c);
+    }
+
+    /// Last byte written, or '\0' if nothing has been
+    char back() const { return m_data.empty() ? m_last : m_data.back(); }
+
+    /// Pass everything buffered to the sink. Throws std::system_error if writing to a file
+    /// descriptor fails.
+    void flush();
+
+    /// Bytes written so far, including those still buffered
+    std::size_t size() const { return m_flushed + m_data.size(); }
+
+private:
+    void write_slow(std::string_view s);
+
+    sink_fn m_sink;
+    std::vector<char> m_data;
+    std::size_t m_flushed{0};
+    char m_last{'\0'};
+};
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace docsmith
+{
+
+/// Call fn(i) for each i in [0, count) on a pool of threads, with the calling thread taking part.
+/// threads = 0 uses one per hardware thread. The first exception thrown by fn stops the remaining
+/// work and is rethrown once all threads are done.
+///
+/// fn_factory is called once per thread to make that thread's fn, so per thread state (such as a
+/// copy of a cache that isn't thread safe) can be set up.
+template <typename FnFactory>
+void parallel_for(std::size_t count, unsigned threads, FnFactory fn_factory)
+{
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&]
+    {
+        try
+        {
+            auto fn = fn_factory();
+            for(std::size_t i; (i = next++) < count;)
+                fn(i);
+        }
+        catch(...)
+        {
+            std::lock_guard lock(error_mutex);
+            if(!error)
+                error = std::current_exception();
+            next = count;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(work);
+    work();
+    for(auto &t : pool)
+        t.join();
+
+    if(error)
+        std::rethrow_exception(error);
+}
+}
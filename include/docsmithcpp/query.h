@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+
+namespace docsmith
+{
+
+/// A selector compiled into a traversal plan. Compile once and run it against any number of
+/// documents or subtrees, e.g.:
+///
+///     selector top_headings("heading[level<=2]");
+///     selector body_text("list > list_item paragraph[style=\"Text_20_body\"]");
+///     for(auto *p : body_text.select_as<paragraph>(doc)) ...
+///
+/// Grammar:
+///     selector   := compound (combinator compound)*
+///     combinator := whitespace (any descendant) | '>' (direct child)
+///     compound   := type? ('[' attribute op value ']')*
+///     type       := text_doc | heading | paragraph | list | list_item | span | text | hyperlink
+///                   | frame | image | bookmark | '*'
+///     attribute  := style | level | url | uri | name | text
+///     op         := = | != | < | <= | > | >= | ^= (prefix) | $= (suffix) | *= (contains)
+///     value      := "string" | 'string' | integer | bare-word
+///
+/// The plan stops descending once no step of the selector can match further down, so e.g.
+/// "text_doc > heading" only looks at the top level blocks.
+class selector
+{
+public:
+    /// Compile the expression. Throws std::invalid_argument if it is malformed.
+    explicit selector(std::string_view expression);
+
+    /// All elements matching the selector in root's subtree (root included), in document order
+    std::vector<element *> select(element &root) const;
+    std::vector<const element *> select(const element &root) const;
+
+    template <typename T>
+    std::vector<T *> select_as(element &root) const
+    {
+        std::vector<T *> r;
+        for(auto *e : select(root))
+            if(auto *t = dynamic_cast<T *>(e))
+                r.push_back(t);
+        return r;
+    }
+
+    template <typename T>
+    std::vector<const T *> select_as(const element &root) const
+    {
+        std::vector<const T *> r;
+        for(const auto *e : select(root))
+            if(const auto *t = dynamic_cast<const T *>(e))
+                r.push_back(t);
+        return r;
+    }
+
+    /// Does e match the last step of the selector, ignoring its ancestors?
+    bool matches_self(const element &e) const;
+
+private:
+    enum class attribute
+    {
+        style,
+        level,
+        url,
+        uri,
+        name,
+        text
+    };
+
+    enum class comparison
+    {
+        eq,
+        ne,
+        lt,
+        le,
+        gt,
+        ge,
+        prefix,
+        suffix,
+        contains
+    };
+
+    struct predicate
+    {
+        attribute m_attribute;
+        comparison m_comparison;
+        std::string m_value;
+        long long m_number{0};
+        bool m_is_number{false};
+    };
+
+    struct step
+    {
+        std::uint32_t m_types{~0u}; //!< Bit mask of the elem_t values this step accepts
+        std::vector<predicate> m_predicates;
+        bool m_child_only{false}; //!< Combinator before this step is '>'
+    };
+
+    bool matches(const step &s, const element &e) const;
+    void walk(const element &e, std::uint64_t active, std::vector<const element *> &out) const;
+
+    std::vector<step> m_steps;
+    std::uint64_t m_persistent{0}; //!< Steps which stay available to all descendants, not just children
+};
+}
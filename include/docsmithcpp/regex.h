@@ -0,0 +1,152 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+#include "docsmithcpp/text_search.h"
+
+namespace docsmith
+{
+
+/// A regex match within the text of one paragraph or heading. Element is const element for
+/// matches below a const element.
+template <typename Element>
+struct basic_regex_match
+{
+    using hit = basic_text_hit<const_like_t<Element, text>>;
+
+    Element *m_block;    //!< The paragraph or heading
+    std::size_t m_begin; //!< Offset of the match in the block text
+    std::size_t m_end;   //!< Offset one past the match in the block text
+    hit m_first;         //!< Text node and offset of the first matched byte
+    hit m_last;          //!< Text node and offset one past the last matched byte
+    std::string m_text;  //!< The matched text
+};
+
+using regex_match = basic_regex_match<element>;
+using const_regex_match = basic_regex_match<const element>;
+
+/// Regular expressions over document text, matched in time linear in the text length. Patterns
+/// are compiled to an NFA; blocks are first checked with a lazily built DFA, and matches are then
+/// extracted with a Pike VM, so there is no backtracking and no pathological input.
+///
+/// Supported syntax: literals, `.`, classes `[a-z_]` and `[^...]` (ASCII members), escapes
+/// `\d \w \s \D \W \S` and `\t \n \r`, groups `(...)` and `(?:...)`, alternation, the quantifiers
+/// `* + ? {n} {n,} {n,m}`, and the anchors `^ $` for the start and end of a block. Back
+/// references and lazy quantifiers can't be matched in linear time and are rejected.
+///
+/// Matching is by byte on UTF-8 text. `.` and negated classes match a whole character. Matches are
+/// leftmost-longest, as in POSIX. Empty matches are never reported, e.g. `a*` only matches runs
+/// of at least one a.
+///
+/// The DFA is built while matching, so the matching functions aren't const and a regex can't be
+/// shared between threads. Copy it for each thread instead (find_all_parallel does this).
+class regex
+{
+public:
+    /// @throws std::invalid_argument for malformed or unsupported patterns
+    explicit regex(std::string_view pattern, bool case_insensitive = false);
+
+    const std::string &pattern() const { return m_pattern; }
+
+    /// Begin and end of the leftmost-longest non-empty match in s at or after from, if any
+    std::optional<std::pair<std::size_t, std::size_t>> search(
+        std::string_view s, std::size_t from = 0);
+
+    /// Begin and end of each match in s, left to right, as repeated search() calls would give them
+    /// but found in one pass
+    std::vector<std::pair<std::size_t, std::size_t>> search_all(std::string_view s);
+
+    /// Is there any match in s? Faster than search() as it only runs the DFA, unless the pattern
+    /// can match the empty string.
+    bool contains(std::string_view s);
+
+    /// All matches in the paragraphs and headings below root, in document order. A match may span
+    /// text runs (e.g. spans and hyperlinks) within a block.
+    std::vector<regex_match> find_all(element &root);
+    std::vector<const_regex_match> find_all(const element &root);
+
+private:
+    struct nfa_state
+    {
+        enum class kind : std::uint8_t
+        {
+            bytes, //!< Consume a byte in m_bytes, then go to m_next
+            split, //!< Go to both m_next and m_alt
+            begin, //!< Go to m_next at the start of the text
+            end,   //!< Go to m_next at the end of the text
+            match
+        };
+        kind m_kind;
+        std::bitset<256> m_bytes;
+        int m_next{-1};
+        int m_alt{-1};
+    };
+
+    /// A Pike VM thread: an NFA state, and where the match it is following started
+    struct thread
+    {
+        int m_state;
+        std::size_t m_start;
+    };
+
+    /// Start a new round of m_mark, so each NFA state can be entered once more
+    void next_generation();
+    /// Add the threads for state and the states it reaches without consuming a byte
+    void add_thread(std::vector<thread> &list, int state, std::size_t start, bool at_start,
+        bool at_end);
+    template <typename Element>
+    std::vector<basic_regex_match<Element>> find_all_below(Element &root);
+
+    void closure(std::vector<int> &set, bool at_start, bool at_end);
+    int dfa_intern(std::vector<int> set);
+    int dfa_start(bool at_start);
+    int dfa_next(int state, unsigned char byte);
+    bool accepts_at_end(const std::vector<int> &set, bool at_start);
+
+    std::string m_pattern;
+    std::vector<nfa_state> m_nfa;
+    int m_start{-1};
+    bool m_matches_empty{false}; //!< Can the pattern match the empty string somewhere?
+
+    // The lazy DFA. It is unanchored: every state also contains the NFA start, so one pass over
+    // the text finds a match at any position.
+    std::vector<std::vector<int>> m_dfa; //!< Sorted NFA states of each DFA state
+    std::vector<char> m_dfa_match;       //!< Does the DFA state hold a match?
+    std::map<std::vector<int>, int> m_dfa_ids;
+    std::vector<int> m_dfa_next; //!< state * 256 + byte, or -1 if not built yet
+    int m_dfa_starts[2]{-1, -1};  //!< Start states away from and at the text start
+    std::vector<std::uint32_t> m_mark; //!< Scratch for closures
+    std::uint32_t m_generation{0};
+    std::vector<int> m_stack; //!< Scratch for add_thread()
+};
+
+/// Run re over each root on a pool of threads, returning the matches for each root in order.
+/// threads = 0 uses one per hardware thread.
+std::vector<std::vector<regex_match>> find_all_parallel(
+    const regex &re, const std::vector<element *> &roots, unsigned threads = 0);
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+
+namespace docsmith
+{
+
+/// Result of replacer::apply()
+struct replace_result
+{
+    std::vector<std::size_t> m_counts; //!< Replacements made, per rule in construction order
+    std::size_t total() const;
+};
+
+/// Replaces many literal patterns in one pass over a document. Matching runs over the text of
+/// each paragraph or heading as it reads, so a word split over a span boundary still matches.
+///
+/// Matches are chosen leftmost-longest and don't overlap. The replacement is written into the
+/// text node where the match starts, keeping that run's styling, and the matched characters are
+/// removed from the following runs. Those runs are left in place, possibly empty.
+///
+/// The patterns are compiled once into an Aho-Corasick automaton, so apply() costs time linear
+/// in the document text, whatever the number of patterns.
+class replacer
+{
+public:
+    using rule = std::pair<std::string, std::string>; //!< Pattern and replacement
+
+    /// @throws std::invalid_argument for an empty pattern
+    explicit replacer(std::vector<rule> rules, bool case_insensitive = false);
+
+    /// Replace all matches below root
+    replace_result apply(element &root) const;
+
+    std::size_t size() const { return m_rules.size(); }
+
+private:
+    struct match
+    {
+        std::size_t m_begin;
+        std::size_t m_end;
+        std::size_t m_rule;
+    };
+
+    void build();
+    /// Leftmost-longest non-overlapping matches in s, using all as scratch space
+    void find_matches(
+        const std::string &s, std::vector<match> &all, std::vector<match> &chosen) const;
+
+    std::vector<rule> m_rules;
+    bool m_case_insensitive;
+    std::uint8_t m_classes[256]{};    //!< Byte to alphabet class, 0 for bytes in no pattern
+    std::size_t m_num_classes{1};
+    std::vector<std::uint32_t> m_next; //!< Complete transition table, row offset by row + class
+    std::vector<std::int32_t> m_out;    //!< Longest rule ending at each state, or -1
+    std::vector<std::int32_t> m_link;   //!< Next state on the suffix chain with an output, or -1
+    std::vector<std::int32_t> m_report; //!< First state with an output on each suffix chain
+};
+}
@@ -18,7 +18,9 @@
 #pragma once
 #include <optional>
 #include <string>
+#include <type_traits>
 
+#include "docsmithcpp/element.h"
 #include "docsmithcpp/named_registry.h"
 
 namespace docsmith
@@ -268,6 +270,8 @@ public:
     Derived &set_style(style_name sn)
     {
         m_style_name = std::move(sn);
+        if constexpr(std::is_base_of_v<element, Derived>)
+            static_cast<Derived &>(*this).notify(change_t::style);
         return static_cast<Derived &>(*this);
     }
 
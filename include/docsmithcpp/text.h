@@ -17,6 +17,7 @@
  *****************************************************************************/
 #pragma once
 #include <string>
+#include <utility>
 
 #include "docsmithcpp/nodes.h"
 
@@ -31,13 +32,20 @@ public:
     {
     }
 
-    explicit text(const std::string &s) :
-        m_text(s)
+    explicit text(std::string s) :
+        m_text(std::move(s))
     {
     }
 
     bool operator==(const text &other) const { return m_text == other.m_text; }
 
+    /// Replace the text and notify observers such as doc_stats
+    void set_text(std::string s)
+    {
+        m_text = std::move(s);
+        notify(change_t::text);
+    }
+
     std::string m_text;
 };
 }
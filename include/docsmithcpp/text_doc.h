@@ -16,9 +16,11 @@
  * limitations under the License.
  *****************************************************************************/
 #pragma once
+#include <atomic>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -26,13 +28,17 @@
 #include <variant>
 #include <vector>
 
+#include "docsmithcpp/doc_stats.h"
 #include "docsmithcpp/element.h"
 #include "docsmithcpp/forward_decl.h"
+#include "docsmithcpp/handle.h"
 #include "docsmithcpp/list.h"
 #include "docsmithcpp/named_registry.h"
 #include "docsmithcpp/nodes.h"
+#include "docsmithcpp/outline.h"
 #include "docsmithcpp/style.h"
 #include "docsmithcpp/text.h"
+#include "docsmithcpp/text_index.h"
 
 namespace docsmith
 {
@@ -93,7 +99,7 @@ public:
     {
     }
 
-    std::string get_url() const { return m_url; }
+    const std::string &get_url() const { return m_url; }
 
     bool operator==(const hyperlink &rhs) const
     {
@@ -118,7 +124,7 @@ public:
     {
     }
 
-    std::string get_uri() const { return m_uri; }
+    const std::string &get_uri() const { return m_uri; }
 
     bool operator==(const image &rhs) const
     {
@@ -218,9 +224,133 @@ public:
     list_style_registry &list_styles() { return m_list_styles; }
     const list_style_registry &list_styles() const { return m_list_styles; }
 
+    /// The heading hierarchy, built on first use and kept until the top level blocks change
+    /// through add(), add_child() or assignment to the document or one of its blocks. Call
+    /// invalidate_outline() after changing m_children directly.
+    /// Concurrent readers may call this at once: one builds the outline and the others wait for it.
+    const outline &get_outline() const
+    {
+        if(const auto *o = m_outline.m_published.load(std::memory_order_acquire))
+            return *o;
+        std::lock_guard lock(m_outline.m_mutex);
+        if(!m_outline.m_cached)
+        {
+            m_outline.m_cached = std::make_unique<outline>(*this);
+            m_outline.m_published.store(m_outline.m_cached.get(), std::memory_order_release);
+        }
+        return *m_outline.m_cached;
+    }
+    void invalidate_outline() { m_outline.reset(); }
+
+    /// Live statistics, counted on first use and then updated on each change notification
+    doc_stats &stats()
+    {
+        if(!m_stats.m_cached)
+            m_stats.m_cached = std::make_unique<doc_stats>(*this);
+        return *m_stats.m_cached;
+    }
+
+    /// Full-text index, built on first use and then updated on each change notification
+    text_index &index()
+    {
+        if(!m_index.m_cached)
+            m_index.m_cached = std::make_unique<text_index>(*this);
+        return *m_index.m_cached;
+    }
+
+    /// A handle to e, which must be this document or one of its elements. Unlike a pointer it can
+    /// be kept across edits: resolve() returns nullptr once the element is destroyed. Handles don't
+    /// resolve in copies of the document, or after it has been reassigned (e.g. reparsed).
+    template <typename T>
+    handle<T> get_handle(T &e)
+    {
+        auto path = e.ancestors();
+        if(path.empty() ? static_cast<element *>(&e) != this : path.back() != this)
+            throw std::invalid_argument("Element is not part of this document");
+        if(!m_handles.m_cached)
+            m_handles.m_cached = std::make_shared<handle_table>();
+        return m_handles.m_cached->acquire(e);
+    }
+
+    /// Handles for query results such as those of find_all(), so they can be cached across edits
+    template <typename T>
+    std::vector<handle<T>> get_handles(const std::vector<T *> &elements)
+    {
+        std::vector<handle<T>> r;
+        r.reserve(elements.size());
+        for(auto *e : elements)
+            r.push_back(get_handle(*e));
+        return r;
+    }
+
+    /// The element h refers to, or nullptr if it no longer exists in this document
+    template <typename T>
+    T *resolve(handle<T> h)
+    {
+        return m_handles.m_cached ? m_handles.m_cached->resolve(h) : nullptr;
+    }
+
+    template <typename T>
+    const T *resolve(handle<T> h) const
+    {
+        return m_handles.m_cached ? m_handles.m_cached->resolve(h) : nullptr;
+    }
+
+protected:
+    void on_change(element &origin, change_t kind) override
+    {
+        // A top level block added or replaced, or assigned to (e.g. a heading with a new level)
+        if(((kind == change_t::added || kind == change_t::children) && origin.parent() == this) ||
+            (kind == change_t::children && &origin == this))
+            invalidate_outline();
+        if(m_stats.m_cached)
+            m_stats.m_cached->update(origin, kind);
+        if(m_index.m_cached)
+            m_index.m_cached->update(origin, kind);
+    }
+
 private:
+    /// Derived data that points into the tree, so copies of a document start without it
+    template <typename Ptr>
+    struct tree_cache
+    {
+        tree_cache() = default;
+        tree_cache(const tree_cache &) {}
+        tree_cache &operator=(const tree_cache &)
+        {
+            m_cached.reset();
+            return *this;
+        }
+        Ptr m_cached;
+    };
+
+    /// The outline cache, which const readers can fill concurrently. Once built it is published
+    /// through m_published, so reading it doesn't lock.
+    struct outline_cache
+    {
+        outline_cache() = default;
+        outline_cache(const outline_cache &) {}
+        outline_cache &operator=(const outline_cache &)
+        {
+            reset();
+            return *this;
+        }
+        void reset()
+        {
+            m_published.store(nullptr, std::memory_order_relaxed);
+            m_cached.reset();
+        }
+        std::mutex m_mutex;
+        std::atomic<const outline *> m_published{nullptr};
+        std::unique_ptr<outline> m_cached;
+    };
+
     style_registry m_styles;
     list_style_registry m_list_styles;
+    mutable outline_cache m_outline;
+    tree_cache<std::unique_ptr<doc_stats>> m_stats;
+    tree_cache<std::unique_ptr<text_index>> m_index;
+    tree_cache<std::shared_ptr<handle_table>> m_handles;
 };
 
 // clang-format off
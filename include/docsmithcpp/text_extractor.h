@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+/// Writes the plain text of a tree into an output_buffer: the text of each paragraph and
+/// heading followed by a newline. Nothing is allocated per node, so one extractor (and its
+/// buffer) can be reused for any number of documents.
+class text_extractor : public element_visitor
+{
+public:
+    explicit text_extractor(output_buffer &out) :
+        m_out(out)
+    {
+    }
+
+    void visit(const text_doc &) override { m_block = false; }
+    void visit(const heading &) override { m_block = true; }
+    void visit(const paragraph &) override { m_block = true; }
+    void visit(const span &) override { m_block = false; }
+    void visit(const hyperlink &) override { m_block = false; }
+    void visit(const list &) override { m_block = false; }
+    void visit(const list_item &) override { m_block = false; }
+    void visit(const frame &) override { m_block = false; }
+
+    void visit(const text &t) override { m_out.write(t.m_text); }
+
+    void push() override { m_open.push_back(m_block); }
+
+    void pop() override
+    {
+        bool block = m_open.back();
+        m_open.pop_back();
+        // Nested blocks (a paragraph in a frame in a paragraph) don't give blank lines
+        if(block && m_out.size() > 0 && m_out.back() != '\n')
+            m_out.put('\n');
+    }
+
+private:
+    output_buffer &m_out;
+    std::vector<bool> m_open; //!< Whether each open element is a block
+    bool m_block{false};      //!< Whether the element just visited is a block
+};
+
+/// Write the plain text of e into out. Call out.flush() to see write errors.
+void extract_text(const element &e, output_buffer &out);
+
+/// The plain text of e, one line per paragraph or heading
+std::string to_plain_text(const element &e);
+}
@@ -0,0 +1,130 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+#include "docsmithcpp/forward_decl.h"
+
+namespace docsmith
+{
+
+/// Where a term occurs: the text node and the byte offset of the token within its m_text
+template <typename Text>
+struct basic_text_posting
+{
+    Text *m_node;
+    std::size_t m_offset;
+};
+
+using text_posting = basic_text_posting<text>;
+using const_text_posting = basic_text_posting<const text>;
+
+/// Inverted index from normalised terms to their occurrences in a document, for running many
+/// keyword searches against the same document without scanning every text node each time.
+///
+/// Tokens are runs of ASCII letters and digits; bytes of multi-byte UTF-8 characters also count as
+/// word characters, so non-ASCII words are indexed whole. Terms are normalised by ASCII case
+/// folding.
+///
+/// The index holds pointers into the document, which must outlive it. Use text_doc::index(), which
+/// forwards the document's change notifications so that text::set_text() and add() keep it current.
+/// A standalone index, or edits which bypass notify() (assigning m_text, changing m_children
+/// directly), need update() after changing a node's m_text, add() for new nodes and remove()
+/// before a node is destroyed.
+///
+/// Element is const element to index a document through a const reference, with postings to const
+/// text nodes. Use the text_index and const_text_index aliases.
+template <typename Element>
+class basic_text_index
+{
+public:
+    using text_type = const_like_t<Element, text>;
+    using posting = basic_text_posting<text_type>;
+
+    basic_text_index() = default;
+    explicit basic_text_index(Element &root) { build(root); }
+
+    /// Discard the current contents and index every text node below root
+    void build(Element &root);
+
+    /// Occurrences of term, or an empty list if it doesn't occur. They are in document order after
+    /// build(), but not after edits: removing an occurrence moves the last one into its place.
+    const std::vector<posting> &find(std::string_view term) const;
+
+    /// The paragraphs and headings which contain term, each listed once
+    std::vector<Element *> find_blocks(std::string_view term) const;
+
+    /// Index a text node which was added to the document. block is its enclosing paragraph or
+    /// heading, if any.
+    void add(text_type &node, Element *block);
+
+    /// Re-index a text node whose m_text has changed
+    void update(text_type &node);
+
+    /// Apply a change below the root. Called by text_doc for each notification. A text change
+    /// re-indexes every text node of the block, as one notification may cover several edited runs.
+    /// Replaced children re-index the subtree of the element they were replaced in.
+    void update(Element &origin, change_t kind);
+
+    /// Stop indexing a text node
+    void remove(text_type &node);
+
+    /// Number of distinct terms
+    std::size_t size() const { return m_postings.size(); }
+
+    /// The normalised form of a term, as stored in the index
+    static std::string normalise(std::string_view term);
+
+private:
+    struct node_entry
+    {
+        Element *m_block{nullptr};
+        /// The m_postings key and the index in its list of each occurrence in the node, so that
+        /// unindexing doesn't search the lists
+        std::vector<std::pair<const std::string *, std::size_t>> m_postings;
+    };
+
+    /// A child as it was when indexed. It may have been destroyed since, so it is only compared,
+    /// never dereferenced.
+    struct kid
+    {
+        const element *m_element;
+        const text *m_text; //!< The child as a text node, or nullptr
+    };
+
+    void index(Element &e, Element *block);
+    void index_text(text_type &node, node_entry &entry);
+    void unindex_text(node_entry &entry);
+    /// Unindex everything recorded below e, whose children were replaced
+    void forget_below(const element *e);
+
+    std::unordered_map<std::string, std::vector<posting>> m_postings;
+    std::unordered_map<const text *, node_entry> m_nodes;
+    /// The children of each indexed element, for finding the text nodes of replaced subtrees
+    std::unordered_map<const element *, std::vector<kid>> m_kids;
+};
+
+using text_index = basic_text_index<element>;
+using const_text_index = basic_text_index<const element>;
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "docsmithcpp/element.h"
+#include "docsmithcpp/forward_decl.h"
+
+namespace docsmith
+{
+
+struct search_options
+{
+    bool m_case_insensitive{false}; //!< Fold ASCII letters. Other characters must match exactly.
+};
+
+/// A match: the text node and the byte offset of the match within its m_text. Text is const text
+/// for matches below a const element.
+template <typename Text>
+struct basic_text_hit
+{
+    Text *m_node;
+    std::size_t m_offset;
+};
+
+using text_hit = basic_text_hit<text>;
+using const_text_hit = basic_text_hit<const text>;
+
+/// Implementations of find_substring()
+enum class search_kernel
+{
+    scalar,
+    sse2, //!< x86 targets with SSE2
+    avx2, //!< x86 CPUs with AVX2, detected at run time
+};
+
+/// Can kernel run in this build on this machine?
+bool is_supported(search_kernel kernel);
+
+/// Offset of the first occurrence of needle in haystack at or after from, or npos. Uses the
+/// fastest supported kernel: AVX2 if the CPU has it, else SSE2, else a scalar loop.
+std::size_t find_substring(std::string_view haystack, std::string_view needle,
+    std::size_t from = 0, bool case_insensitive = false);
+
+/// find_substring() with a given kernel, e.g. to test or benchmark the kernels against each other
+/// @throws std::invalid_argument if the kernel isn't supported
+std::size_t find_substring(search_kernel kernel, std::string_view haystack,
+    std::string_view needle, std::size_t from = 0, bool case_insensitive = false);
+
+/// Find every occurrence of needle in the text nodes below root, without building an index.
+/// Occurrences within a node don't overlap. Matches never span text nodes.
+///
+/// Text is matched as UTF-8: needle must be valid UTF-8 (std::invalid_argument is thrown
+/// otherwise), which means a match can only start and end on character boundaries.
+std::vector<text_hit> find_text(
+    element &root, std::string_view needle, const search_options &options = {});
+
+std::vector<const_text_hit> find_text(
+    const element &root, std::string_view needle, const search_options &options = {});
+
+/// Does s hold well formed UTF-8?
+bool is_valid_utf8(std::string_view s);
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+/// One published version of a versioned_doc. It never changes once published.
+struct doc_version
+{
+    std::uint64_t m_number; //!< 1 for the initial document, one more for each publish
+    text_doc m_doc;
+};
+
+/// A document that one thread edits while any number of others read it. Readers take a snapshot,
+/// which is the latest published version: O(1), with no copy, and lock-free, so it never waits on
+/// the writer or on other readers. A snapshot stays valid and unchanged for as long as it is held.
+/// Its text_doc can be read from several threads at once, through the const API (see element).
+///
+/// The writer edits a private copy of the latest version, then publishes it in a single atomic
+/// store. A version is freed when the last snapshot of it is dropped, on the thread that drops
+/// it. Writers are serialised by a mutex which readers never touch.
+///
+/// std::atomic<std::shared_ptr> isn't used for this, as common implementations guard it with a
+/// lock. Instead readers copy the shared_ptr that m_latest points to, and count themselves in
+/// m_readers while they do. After publishing, the writer waits until the readers which may still
+/// be copying the previous shared_ptr are done before deleting it.
+class versioned_doc
+{
+public:
+    explicit versioned_doc(text_doc doc = {});
+    ~versioned_doc();
+
+    versioned_doc(const versioned_doc &) = delete;
+    versioned_doc &operator=(const versioned_doc &) = delete;
+
+    /// The latest published version, with its number
+    std::shared_ptr<const doc_version> latest() const;
+
+    /// The document of the latest published version
+    std::shared_ptr<const text_doc> snapshot() const
+    {
+        auto v = latest();
+        return {v, &v->m_doc};
+    }
+
+    /// Copy the latest version, apply edit(text_doc &) to the copy and publish it. Readers keep
+    /// seeing the previous version until then. Returns the new version's number.
+    template <typename Edit>
+    std::uint64_t edit(Edit &&edit)
+    {
+        std::lock_guard lock(m_write_mutex);
+        text_doc draft = latest()->m_doc;
+        std::forward<Edit>(edit)(draft);
+        return publish_locked(std::move(draft));
+    }
+
+    /// Publish doc as the next version and return its number
+    std::uint64_t publish(text_doc doc);
+
+private:
+    using version_ptr = std::shared_ptr<const doc_version>;
+
+    std::uint64_t publish_locked(text_doc doc);
+
+    std::mutex m_write_mutex;
+    std::atomic<const version_ptr *> m_latest;
+    /// Incremented by each publish. Readers count themselves in m_readers[m_epoch % 2].
+    std::atomic<std::uint32_t> m_epoch{0};
+    mutable std::atomic<std::uint32_t> m_readers[2]{}; //!< Readers copying a version_ptr
+
+    static_assert(std::atomic<const version_ptr *>::is_always_lock_free &&
+        std::atomic<std::uint32_t>::is_always_lock_free);
+};
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace docsmith
+{
+
+struct xml_attribute
+{
+    std::string_view m_name;  //!< Qualified name, e.g. "w:val"
+    std::string_view m_value; //!< Value with references replaced
+};
+
+/// The value of the attribute called name, or fallback if there is none
+std::string_view find_attribute(std::span<const xml_attribute> attributes, std::string_view name,
+    std::string_view fallback = {});
+
+/// Receives the events of an xml_parser. The names, attributes and text passed in are only valid
+/// during the call.
+class xml_handler
+{
+public:
+    virtual ~xml_handler() = default;
+
+    virtual void start_element(
+        std::string_view name, std::span<const xml_attribute> attributes) = 0;
+    virtual void end_element(std::string_view name) = 0;
+
+    /// Character data inside an element. A run of text can arrive in more than one call, e.g.
+    /// where it was split between chunks.
+    virtual void characters(std::string_view text) = 0;
+};
+
+/// A non-validating push parser for XML: data is fed in chunks of any size as it arrives (e.g. as
+/// a zip entry is inflated) and events are passed to a handler as soon as they are complete, so no
+/// document tree is built and only an incomplete tag is ever held back. Names are reported with
+/// their prefixes, as in the document; namespace declarations are not resolved. DTDs are skipped.
+class xml_parser
+{
+public:
+    explicit xml_parser(xml_handler &handler);
+
+    /// Parse the next chunk of the document. Throws std::runtime_error if it isn't well formed.
+    void feed(std::string_view data);
+
+    /// End of the document. Throws std::runtime_error if it ended with elements still open.
+    void finish();
+
+private:
+    std::size_t parse(std::string_view data, bool final);
+    void start_tag(std::string_view tag);
+    void end_tag(std::string_view tag);
+    void text(std::string_view raw);
+    void decode(std::string_view raw, std::string &out);
+    [[noreturn]] void fail(std::string_view what, std::size_t pos) const;
+
+    xml_handler &m_handler;
+    std::string m_pending;   //!< Start of a tag or reference that was split between chunks
+    std::size_t m_offset{0}; //!< Bytes of the document before the data being parsed
+    std::string m_text;      //!< Decoded character data
+    std::string m_values;    //!< Decoded attribute values
+    std::vector<std::pair<std::size_t, std::size_t>> m_value_spans; //!< Into m_values
+    std::vector<xml_attribute> m_attributes;
+    std::vector<std::string> m_open; //!< Names of the open elements, reused as the depth changes
+    std::size_t m_depth{0};
+};
+}
@@ -0,0 +1,176 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct z_stream_s;
+
+namespace docsmith
+{
+
+/// Destination for bytes as they are produced
+using byte_sink = std::function<void(const char *data, std::size_t size)>;
+
+/// Produces the data of an archive entry, passing it to the sink in as many pieces as it likes
+using entry_producer = std::function<void(const byte_sink &)>;
+
+/// Compression method of an archive entry, with the values used in the zip headers
+enum class zip_method : std::uint16_t
+{
+    store = 0,
+    deflate = 8,
+};
+
+/// An archive entry that has already been compressed. It can be copied into any number of archives
+/// without compressing it again.
+struct zip_entry
+{
+    std::string m_name;                      //!< Path within the archive
+    zip_method m_method{zip_method::deflate}; //!< How m_data is compressed
+    std::uint32_t m_crc{0};                   //!< CRC-32 of the uncompressed data
+    std::uint64_t m_size{0};                  //!< Uncompressed size
+    std::string m_data;                       //!< Compressed bytes
+};
+
+/// CRC-32 as used by zip. Pass a previous result as crc to continue a running checksum.
+std::uint32_t crc32(std::string_view data, std::uint32_t crc = 0);
+
+/// Compress data as a raw deflate stream (no zlib header), as stored in zip archives
+std::string deflate(std::string_view data);
+
+/// Compress data into an entry which can be added to an archive with zip_writer::add
+zip_entry make_zip_entry(
+    std::string name, std::string_view data, zip_method method = zip_method::deflate);
+
+/// Incremental raw deflate, for compressing an entry in chunks as its data becomes available
+class deflater
+{
+public:
+    deflater();
+    ~deflater();
+    deflater(const deflater &) = delete;
+    deflater &operator=(const deflater &) = delete;
+
+    /// Compress data, passing any compressed output which is ready to out
+    void write(const char *data, std::size_t size, const byte_sink &out);
+
+    /// Flush the remaining output to out and end the stream
+    void finish(const byte_sink &out);
+
+    std::uint32_t crc() const { return m_crc; }   //!< CRC-32 of the data written so far
+    std::uint64_t size() const { return m_size; } //!< Uncompressed bytes written so far
+
+private:
+    void run(int flush, const byte_sink &out);
+
+    std::unique_ptr<z_stream_s> m_stream;
+    std::uint32_t m_crc{0};
+    std::uint64_t m_size{0};
+    std::string m_buffer; //!< Output buffer handed to zlib
+};
+
+/// Writes a zip archive sequentially to a sink. Nothing is ever read back or seeked, so the sink
+/// can be a file, a memory buffer or a socket.
+class zip_writer
+{
+public:
+    using sink = byte_sink;
+
+    explicit zip_writer(sink out);
+
+    /// Compress data with the given method and add it as name
+    void add(const std::string &name, std::string_view data, zip_method method = zip_method::deflate);
+
+    /// Copy an entry which was compressed up front, without compressing it again
+    void add(const zip_entry &entry);
+
+    /// Start an entry whose size is not known up front. Its data is passed to write() in chunks and
+    /// compressed as it arrives; the CRC and sizes follow the data in a data descriptor.
+    void begin_entry(const std::string &name, zip_method method = zip_method::deflate);
+
+    /// Append data to the entry started with begin_entry
+    void write(const char *data, std::size_t size);
+
+    /// Complete the entry started with begin_entry
+    void end_entry();
+
+    /// Add an entry on a three stage pipeline: produce runs on one thread, its output is deflated on
+    /// a second, and the compressed data is written to the sink on the calling thread. At most
+    /// max_chunks chunks wait between stages, so memory stays bounded. Exceptions from any stage
+    /// are rethrown here once all stages have stopped.
+    void add_pipelined(
+        const std::string &name, const entry_producer &produce, std::size_t max_chunks = 8);
+
+    /// Write the central directory. No entries can be added afterwards.
+    void finish();
+
+    /// Total bytes passed to the sink so far
+    std::uint64_t bytes_written() const { return m_offset; }
+
+private:
+    struct central_record
+    {
+        std::string m_name;
+        zip_method m_method;
+        std::uint16_t m_flags;
+        std::uint32_t m_crc;
+        std::uint64_t m_compressed_size;
+        std::uint64_t m_size;
+        std::uint64_t m_offset; //!< Offset of the local file header
+    };
+
+    void begin_streamed(const std::string &name, zip_method method);
+    void end_streamed(std::uint32_t crc, std::uint64_t size);
+    void write_local_header(const central_record &r);
+    void check_can_add() const;
+    void emit(const char *data, std::size_t size);
+    void emit(std::string_view data) { emit(data.data(), data.size()); }
+
+    sink m_out;
+    std::uint64_t m_offset{0};
+    std::uint16_t m_dos_time{0};
+    std::uint16_t m_dos_date{0};
+    bool m_finished{false};
+    std::vector<central_record> m_records;
+    std::optional<central_record> m_open_entry; //!< Entry started with begin_entry
+    std::unique_ptr<deflater> m_deflater;       //!< Compresses the open entry
+    std::uint32_t m_stored_crc{0};              //!< CRC of the open entry when it is stored
+    std::uint64_t m_data_start{0};              //!< Offset of the open entry's data
+
+};
+
+/// Adds the entries of an archive to a zip_writer, finishing it when done
+using archive_filler = std::function<void(zip_writer &)>;
+
+/// Write an archive to filename, creating its parent directories if they don't exist
+void write_zip(const std::string &filename, const archive_filler &fill);
+
+/// Write an archive to a stream as it is produced
+void write_zip(std::ostream &os, const archive_filler &fill);
+
+/// Write an archive into memory
+std::vector<std::byte> write_zip(const archive_filler &fill);
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <exception>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+
+#include <libzippp/libzippp.h>
+
+#include "docsmithcpp/archive_reader.h"
+
+namespace docsmith
+{
+namespace
+{
+/// Passes everything written to it on to a sink, so that an entry can be inflated in chunks.
+/// std::ostream swallows exceptions from its buffer, so the first one is kept for rethrow() and
+/// the write fails, which stops libzippp reading.
+class sink_streambuf : public std::streambuf
+{
+public:
+    explicit sink_streambuf(const byte_sink &sink) :
+        m_sink(sink)
+    {
+    }
+
+    void rethrow() const
+    {
+        if(m_error)
+            std::rethrow_exception(m_error);
+    }
+
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        if(m_error)
+            return 0;
+        try
+        {
+            m_sink(s, static_cast<std::size_t>(n));
+        }
+        catch(...)
+        {
+            m_error = std::current_exception();
+            return 0;
+        }
+        return n;
+    }
+
+    int_type overflow(int_type c) override
+    {
+        if(traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        char ch = traits_type::to_char_type(c);
+        return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+    }
+
+private:
+    const byte_sink &m_sink;
+    std::exception_ptr m_error;
+};
+}
+
+archive_reader::archive_reader(const std::string &filename) :
+    m_zip(std::make_unique<libzippp::ZipArchive>(filename))
+{
+    if(!m_zip->open(libzippp::ZipArchive::ReadOnly))
+        throw std::runtime_error("Could not open archive");
+}
+
+archive_reader::~archive_reader() { m_zip->close(); }
+
+bool archive_reader::read(const std::string &name, const byte_sink &sink) const
+{
+    auto entry = m_zip->getEntry(name);
+    if(entry.isNull())
+        return false;
+    sink_streambuf buf(sink);
+    std::ostream os(&buf);
+    auto result = entry.readContent(os, libzippp::ZipArchive::Current, 1 << 16);
+    buf.rethrow();
+    if(result != LIBZIPPP_OK)
+        throw std::runtime_error("Could not read " + name);
+    return true;
+}
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/text.h"
+
+namespace docsmith
+{
+namespace
+{
+bool is_block(const element &e) { return e.is_type(elem_t::p) || e.is_type(elem_t::h); }
+}
+
+template <typename Element>
+basic_block_text<Element>::basic_block_text(Element &block)
+{
+    assign(block);
+}
+
+template <typename Element>
+void basic_block_text<Element>::assign(Element &block)
+{
+    m_block = &block;
+    m_str.clear();
+    m_runs.clear();
+    if(auto *kids = block.child_list())
+        for(const auto &child : *kids)
+            collect(*child);
+}
+
+template <typename Element>
+void basic_block_text<Element>::collect(Element &e)
+{
+    if(is_block(e))
+        return;
+    if(e.is_type(elem_t::t))
+    {
+        auto *t = dynamic_cast<text_type *>(&e);
+        m_runs.push_back({t, m_str.size()});
+        m_str += t->m_text;
+    }
+    if(auto *kids = e.child_list())
+        for(const auto &child : *kids)
+            collect(*child);
+}
+
+template <typename Element>
+std::size_t basic_block_text<Element>::run_index(std::size_t offset) const
+{
+    // The last run starting at or before offset. An empty run starts where the run after it
+    // does, so it is never the last one and a match start isn't written into it.
+    auto it = std::upper_bound(m_runs.begin(), m_runs.end(), offset,
+        [](std::size_t off, const run &r) { return off < r.m_start; });
+    return static_cast<std::size_t>(it - m_runs.begin()) - 1;
+}
+
+template <typename Element>
+basic_text_hit<typename basic_block_text<Element>::text_type> basic_block_text<Element>::locate(
+    std::size_t offset) const
+{
+    const auto &r = m_runs[run_index(offset)];
+    return {r.m_node, offset - r.m_start};
+}
+
+template class basic_block_text<element>;
+template class basic_block_text<const element>;
+
+void for_each_block(element &root, const std::function<void(element &)> &fn)
+{
+    for_each_block(static_cast<const element &>(root),
+        [&fn](const element &block) { fn(const_cast<element &>(block)); });
+}
+
+void for_each_block(const element &root, const std::function<void(const element &)> &fn)
+{
+    if(is_block(root))
+        fn(root);
+    if(auto *kids = root.child_list())
+        for(const auto &child : *kids)
+            for_each_block(static_cast<const element &>(*child), fn);
+}
+}
@@ -0,0 +1,207 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/doc_stats.h"
+#include "docsmithcpp/style.h"
+
+namespace docsmith
+{
+namespace
+{
+bool is_block(const element &e) { return e.is_type(elem_t::p) || e.is_type(elem_t::h); }
+
+/// Is e given an entry in the cache? Text counts with its block, as does everything inside one
+/// other than a nested block.
+bool is_cached(const element &e, bool inside_block)
+{
+    return !e.is_type(elem_t::t) && (is_block(e) || !inside_block);
+}
+
+bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+/// Words and characters of one block's own text
+text_counts count_text(const std::string &s)
+{
+    text_counts c;
+    bool in_word = false;
+    for(char ch : s)
+    {
+        if((static_cast<unsigned char>(ch) & 0xc0) != 0x80) // Not a UTF-8 continuation byte
+            ++c.m_chars;
+        bool space = is_space(ch);
+        if(!space && !in_word)
+            ++c.m_words;
+        in_word = !space;
+    }
+    return c;
+}
+
+element *nearest_block(element &e)
+{
+    for(auto *p = &e; p; p = p->parent())
+        if(is_block(*p))
+            return p;
+    return nullptr;
+}
+
+void subtract(std::map<std::string, text_counts> &from, const std::map<std::string, text_counts> &x)
+{
+    for(const auto &[style, counts] : x)
+        if(auto it = from.find(style); it != from.end())
+        {
+            it->second -= counts;
+            if(it->second == text_counts{})
+                from.erase(it);
+        }
+}
+
+void add(std::map<std::string, text_counts> &to, const std::map<std::string, text_counts> &x)
+{
+    for(const auto &[style, counts] : x)
+        to[style] += counts;
+}
+}
+
+text_counts &text_counts::operator+=(const text_counts &rhs)
+{
+    m_words += rhs.m_words;
+    m_chars += rhs.m_chars;
+    m_paragraphs += rhs.m_paragraphs;
+    m_headings += rhs.m_headings;
+    return *this;
+}
+
+text_counts &text_counts::operator-=(const text_counts &rhs)
+{
+    m_words -= rhs.m_words;
+    m_chars -= rhs.m_chars;
+    m_paragraphs -= rhs.m_paragraphs;
+    m_headings -= rhs.m_headings;
+    return *this;
+}
+
+doc_stats::doc_stats(element &root) :
+    m_root(&root)
+{
+    rebuild();
+}
+
+void doc_stats::rebuild()
+{
+    m_cache.clear();
+    compute(*m_root, false);
+    m_root_aggregate = &m_cache[m_root];
+}
+
+doc_stats::aggregate doc_stats::compute(element &e, bool inside_block)
+{
+    aggregate a;
+    if(e.is_type(elem_t::t))
+        return a; // Counted with its block
+
+    bool block = is_block(e);
+    if(block)
+    {
+        auto counts = count_text(block_text(e).str());
+        (e.is_type(elem_t::h) ? counts.m_headings : counts.m_paragraphs) = 1;
+        std::string style;
+        if(auto *st = dynamic_cast<const styled_base *>(&e))
+            style = st->style().get_name();
+        a.m_totals = counts;
+        a.m_by_style[style] = counts;
+    }
+
+    // Only nested blocks add to a block's counts, but they have to be found
+    if(auto *kids = e.child_list())
+        for(const auto &child : *kids)
+        {
+            auto c = compute(*child, inside_block || block);
+            a.m_totals += c.m_totals;
+            add(a.m_by_style, c.m_by_style);
+            if(is_cached(*child, inside_block || block))
+                a.m_below.push_back(child.get());
+            else
+                a.m_below.insert(a.m_below.end(), c.m_below.begin(), c.m_below.end());
+        }
+
+    if(is_cached(e, inside_block))
+        m_cache[&e] = a;
+    return a;
+}
+
+void doc_stats::forget_below(const element *e)
+{
+    auto it = m_cache.find(e);
+    if(it == m_cache.end())
+        return;
+    auto below = std::move(it->second.m_below);
+    it->second.m_below.clear();
+    for(const auto *b : below)
+    {
+        forget_below(b);
+        m_cache.erase(b);
+    }
+}
+
+void doc_stats::apply(element &target, const aggregate &old, const aggregate &now)
+{
+    if(&target == m_root)
+        return;
+    for(auto *p = target.parent(); p; p = p->parent())
+    {
+        auto &a = m_cache[p];
+        a.m_totals -= old.m_totals;
+        a.m_totals += now.m_totals;
+        subtract(a.m_by_style, old.m_by_style);
+        add(a.m_by_style, now.m_by_style);
+        if(p == m_root)
+            break;
+    }
+}
+
+void doc_stats::update(element &origin, change_t kind)
+{
+    auto *block = nearest_block(origin);
+    if(!block && (kind == change_t::text || kind == change_t::style))
+        return; // Only the text and style of blocks count
+
+    // The block is recounted as a whole, so words joined across the edit stay right
+    auto &target = block ? *block : origin;
+    aggregate old;
+    if(!(kind == change_t::added && &target == &origin))
+        if(auto it = m_cache.find(&target); it != m_cache.end())
+            old = it->second;
+
+    // The old children are destroyed, and everything below target is counted again
+    if(kind == change_t::children)
+        forget_below(&target);
+    auto now = compute(target, block && block != &target);
+    apply(target, old, now);
+    if(kind == change_t::added && &target == &origin && is_cached(origin, false))
+        if(auto it = m_cache.find(origin.parent()); it != m_cache.end())
+            it->second.m_below.push_back(&origin);
+    m_root_aggregate = &m_cache[m_root];
+}
+
+text_counts doc_stats::of(element &e)
+{
+    if(auto it = m_cache.find(&e); it != m_cache.end())
+        return it->second.m_totals;
+    return compute(e, true).m_totals;
+}
+}
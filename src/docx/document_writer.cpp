@@ -0,0 +1,640 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "docsmithcpp/docx/document_writer.h"
+
+namespace docsmith::docx
+{
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr const char *xml_declaration =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+constexpr const char *w_ns = "http://schemas.openxmlformats.org/wordprocessingml/2006/main";
+constexpr const char *rel_type_base =
+    "http://schemas.openxmlformats.org/officeDocument/2006/relationships/";
+
+/// Image extensions covered by the cached [Content_Types].xml
+const std::map<std::string, std::string, std::less<>> image_types = {{".png", "image/png"},
+    {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"}, {".gif", "image/gif"},
+    {".bmp", "image/bmp"}, {".tif", "image/tiff"}, {".tiff", "image/tiff"},
+    {".svg", "image/svg+xml"}, {".emf", "image/x-emf"}, {".wmf", "image/x-wmf"}};
+
+const char *docx_content_types_end{R"(<Override PartName="/word/document.xml" ContentType="application/vnd.openxmlformats-officedocument.wordprocessingml.document.main+xml"/><Override PartName="/word/styles.xml" ContentType="application/vnd.openxmlformats-officedocument.wordprocessingml.styles+xml"/><Override PartName="/word/numbering.xml" ContentType="application/vnd.openxmlformats-officedocument.wordprocessingml.numbering+xml"/><Override PartName="/docProps/app.xml" ContentType="application/vnd.openxmlformats-officedocument.extended-properties+xml"/></Types>)"};
+
+const char *docx_package_rels{R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships"><Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="word/document.xml"/><Relationship Id="rId2" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/extended-properties" Target="docProps/app.xml"/></Relationships>)"};
+
+const char *docx_app{R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Properties xmlns="http://schemas.openxmlformats.org/officeDocument/2006/extended-properties"><Application>DocSmithCpp</Application></Properties>)"};
+
+const char *docx_document_start{R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<w:document xmlns:w="http://schemas.openxmlformats.org/wordprocessingml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships" xmlns:wp="http://schemas.openxmlformats.org/drawingml/2006/wordprocessingDrawing" xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" xmlns:pic="http://schemas.openxmlformats.org/drawingml/2006/picture"><w:body>)"};
+
+/// [Content_Types].xml with a Default for each extension in extensions besides rels and xml
+std::string content_types(const std::map<std::string, std::string, std::less<>> &extensions)
+{
+    std::string r = xml_declaration;
+    r += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+         "<Default Extension=\"rels\" "
+         "ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+         "<Default Extension=\"xml\" ContentType=\"application/xml\"/>";
+    for(const auto &[extension, type] : extensions)
+        r += "<Default Extension=\"" + extension.substr(1) + "\" ContentType=\"" + type + "\"/>";
+    return r + docx_content_types_end;
+}
+
+/// Package parts which are identical for every document, compressed once
+struct static_parts
+{
+    zip_entry m_content_types; //!< For documents whose images all have a known extension
+    zip_entry m_package_rels;
+    zip_entry m_app;
+};
+
+const static_parts &cached_parts()
+{
+    static const static_parts parts{
+        make_zip_entry("[Content_Types].xml", content_types(image_types)),
+        make_zip_entry("_rels/.rels", docx_package_rels),
+        make_zip_entry("docProps/app.xml", docx_app)};
+    return parts;
+}
+
+/// 0: written as is, 1: escaped, 2: escaped in attributes only, 3: not allowed in XML
+constexpr auto special = []
+{
+    std::array<char, 256> r{};
+    for(int c = 0; c < 0x20; ++c)
+        r[c] = 3;
+    r['&'] = r['<'] = r['>'] = 1;
+    r['"'] = r['\t'] = r['\n'] = 2;
+    return r;
+}();
+
+std::string_view num_format(list_enum format)
+{
+    switch(format)
+    {
+    case list_enum::lower_alpha: return "lowerLetter";
+    case list_enum::upper_alpha: return "upperLetter";
+    case list_enum::lower_roman: return "lowerRoman";
+    case list_enum::upper_roman: return "upperRoman";
+    case list_enum::arabic: break;
+    }
+    return "decimal";
+}
+}
+
+void document_writer::begin_package(zip_writer &zip)
+{
+    const auto &parts = cached_parts();
+    zip.add(parts.m_package_rels);
+    zip.add(parts.m_app);
+}
+
+void document_writer::begin_document(output_buffer &out)
+{
+    m_out = &out;
+    m_out->write(docx_document_start);
+}
+
+void document_writer::end_document()
+{
+    m_out->write("</w:body></w:document>");
+    m_out = nullptr;
+}
+
+void document_writer::begin_block(std::string_view style, int outline_level)
+{
+    if(m_block_depth++ > 0)
+        return; // A block within a block is written inline
+
+    std::string heading_style;
+    if(outline_level >= 0)
+    {
+        auto level = std::clamp(outline_level + 1, 1, 9);
+        outline_level = level - 1;
+        if(style.empty())
+        {
+            m_heading_levels.insert(level);
+            heading_style = "Heading" + std::to_string(level);
+            style = heading_style;
+        }
+    }
+    if(heading_style.empty() && !style.empty() &&
+        m_block_styles.find(style) == m_block_styles.end())
+        m_block_styles.emplace(style);
+
+    m_out->write("<w:p>");
+    if(!style.empty() || !m_lists.empty() || outline_level >= 0)
+    {
+        m_out->write("<w:pPr>");
+        if(!style.empty())
+        {
+            m_out->write("<w:pStyle w:val=\"");
+            write_escaped(style, true);
+            m_out->write("\"/>");
+        }
+        if(!m_lists.empty())
+        {
+            // The first block of an item carries its number, later ones line up with it
+            auto depth = static_cast<int>(std::min<std::size_t>(m_lists.size(), 9));
+            auto &current = m_lists.back();
+            if(!current.m_item_numbered)
+            {
+                m_out->write("<w:numPr><w:ilvl w:val=\"");
+                write_number(depth - 1);
+                m_out->write("\"/><w:numId w:val=\"");
+                write_number(current.m_num_id);
+                m_out->write("\"/></w:numPr>");
+                current.m_item_numbered = true;
+            }
+            else
+            {
+                m_out->write("<w:ind w:left=\"");
+                write_number(720 * depth);
+                m_out->write("\"/>");
+            }
+        }
+        if(outline_level >= 0)
+        {
+            m_out->write("<w:outlineLvl w:val=\"");
+            write_number(outline_level);
+            m_out->write("\"/>");
+        }
+        m_out->write("</w:pPr>");
+    }
+}
+
+void document_writer::end_block()
+{
+    if(--m_block_depth == 0)
+        m_out->write("</w:p>");
+}
+
+void document_writer::begin_list(const list_style *style)
+{
+    if(m_lists.empty())
+    {
+        auto [it, added] = m_numbering_def_index.try_emplace(style, m_numbering_defs.size());
+        if(added)
+            m_numbering_defs.push_back({style});
+        m_nums.push_back({it->second, !added});
+        m_lists.push_back({static_cast<int>(m_nums.size()), false});
+    }
+    else
+    {
+        // Nested lists are further levels of the outermost list's numbering
+        auto num = m_lists.back().m_num_id;
+        m_lists.push_back({num, false});
+        auto depth = static_cast<int>(std::min<std::size_t>(m_lists.size(), 9));
+        auto &def = m_numbering_defs[m_nums[num - 1].m_def];
+        def.m_levels = std::max(def.m_levels, depth);
+    }
+}
+
+void document_writer::end_list() { m_lists.pop_back(); }
+
+void document_writer::begin_item()
+{
+    if(!m_lists.empty())
+        m_lists.back().m_item_numbered = false;
+}
+
+void document_writer::begin_span(std::string_view style)
+{
+    if(m_span_depth == m_spans.size())
+        m_spans.emplace_back();
+    m_spans[m_span_depth++].assign(style);
+    if(!style.empty() && m_character_styles.find(style) == m_character_styles.end())
+        m_character_styles.emplace(style);
+}
+
+void document_writer::end_span() { --m_span_depth; }
+
+void document_writer::begin_run()
+{
+    m_out->write("<w:r>");
+
+    // Runs don't nest, so text takes the style of its innermost styled span
+    for(auto i = m_span_depth; i-- > 0;)
+    {
+        if(m_spans[i].empty())
+            continue;
+        m_out->write("<w:rPr><w:rStyle w:val=\"");
+        write_escaped(m_spans[i], true);
+        m_out->write("\"/></w:rPr>");
+        break;
+    }
+}
+
+void document_writer::text(std::string_view s)
+{
+    if(s.empty())
+        return;
+
+    begin_run();
+    bool in_t = false;
+    while(!s.empty())
+    {
+        auto end = std::min(s.find_first_of("\t\n"), s.size());
+        if(end > 0)
+        {
+            if(!in_t)
+                m_out->write("<w:t xml:space=\"preserve\">");
+            in_t = true;
+            write_escaped(s.substr(0, end));
+        }
+        if(end == s.size())
+            break;
+        if(in_t)
+            m_out->write("</w:t>");
+        in_t = false;
+        m_out->write(s[end] == '\t' ? "<w:tab/>" : "<w:br/>");
+        s.remove_prefix(end + 1);
+    }
+    if(in_t)
+        m_out->write("</w:t>");
+    m_out->write("</w:r>");
+}
+
+void document_writer::begin_hyperlink(std::string_view url)
+{
+    m_out->write("<w:hyperlink");
+    if(url.starts_with('#'))
+    {
+        m_out->write(" w:anchor=\"");
+        write_escaped(url.substr(1), true);
+        m_out->put('"');
+    }
+    else if(!url.empty())
+    {
+        auto [it, added] = m_link_ids.try_emplace(std::string(url));
+        if(added)
+            it->second = add_relationship({"hyperlink", std::string(url), true});
+        m_out->write(" r:id=\"");
+        m_out->write(it->second);
+        m_out->put('"');
+    }
+    m_out->put('>');
+}
+
+void document_writer::end_hyperlink() { m_out->write("</w:hyperlink>"); }
+
+void document_writer::bookmark(std::string_view name)
+{
+    auto id = m_bookmarks++;
+    m_out->write("<w:bookmarkStart w:id=\"");
+    write_number(id);
+    m_out->write("\" w:name=\"");
+    write_escaped(name, true);
+    m_out->write("\"/><w:bookmarkEnd w:id=\"");
+    write_number(id);
+    m_out->write("\"/>");
+}
+
+void document_writer::image(const std::string &uri, extent size)
+{
+    auto [it, added] = m_media_ids.try_emplace(uri);
+    if(added)
+    {
+        auto extension = fs::path(uri).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        auto target = "media/image" + std::to_string(m_media.size() + 1) + extension;
+        m_media.push_back({uri, "word/" + target});
+        it->second = add_relationship({"image", target, false});
+    }
+    auto id = ++m_drawings;
+
+    // A picture outside a paragraph gets one of its own
+    if(m_block_depth == 0)
+        m_out->write("<w:p>");
+    m_out->write("<w:r><w:drawing><wp:inline><wp:extent cx=\"");
+    write_number(size.m_cx);
+    m_out->write("\" cy=\"");
+    write_number(size.m_cy);
+    m_out->write("\"/><wp:docPr id=\"");
+    write_number(id);
+    m_out->write("\" name=\"Picture ");
+    write_number(id);
+    m_out->write("\"/><a:graphic><a:graphicData "
+                 "uri=\"http://schemas.openxmlformats.org/drawingml/2006/picture\"><pic:pic>"
+                 "<pic:nvPicPr><pic:cNvPr id=\"");
+    write_number(id);
+    m_out->write("\" name=\"\"/><pic:cNvPicPr/></pic:nvPicPr><pic:blipFill><a:blip r:embed=\"");
+    m_out->write(it->second);
+    m_out->write("\"/><a:stretch><a:fillRect/></a:stretch></pic:blipFill><pic:spPr><a:xfrm>"
+                 "<a:off x=\"0\" y=\"0\"/><a:ext cx=\"");
+    write_number(size.m_cx);
+    m_out->write("\" cy=\"");
+    write_number(size.m_cy);
+    m_out->write("\"/></a:xfrm><a:prstGeom prst=\"rect\"><a:avLst/></a:prstGeom></pic:spPr>"
+                 "</pic:pic></a:graphicData></a:graphic></wp:inline></w:drawing></w:r>");
+    if(m_block_depth == 0)
+        m_out->write("</w:p>");
+}
+
+void document_writer::end_package(
+    zip_writer &zip, const style_registry &styles, const media_reader &read_media)
+{
+    // These depend on what the document uses, so they follow it:
+    write_part(zip, "word/styles.xml", [&] { write_styles(styles); });
+    write_part(zip, "word/numbering.xml", [this] { write_numbering(); });
+    write_part(zip, "word/_rels/document.xml.rels", [this] { write_relationships(); });
+
+    bool known_types = std::all_of(m_media.begin(), m_media.end(), [](const media_item &m)
+        { return image_types.count(fs::path(m.m_dest).extension().string()) > 0; });
+    if(known_types)
+        zip.add(cached_parts().m_content_types);
+    else
+        write_part(zip, "[Content_Types].xml", [this] { write_content_types(); });
+
+    for(const auto &item : m_media)
+    {
+        // Pictures are already compressed, deflating them again gains nothing:
+        zip.begin_entry(item.m_dest, zip_method::store);
+        if(!read_media(item.m_source,
+               [&zip](const char *data, std::size_t size) { zip.write(data, size); }))
+            throw std::runtime_error("Could not add file to archive");
+        zip.end_entry();
+    }
+
+    zip.finish();
+}
+
+void document_writer::write_part(
+    zip_writer &zip, const std::string &name, const std::function<void()> &print)
+{
+    zip.begin_entry(name);
+    output_buffer out([&zip](const char *data, std::size_t size) { zip.write(data, size); });
+    m_out = &out;
+    print();
+    out.flush();
+    m_out = nullptr;
+    zip.end_entry();
+}
+
+std::string document_writer::add_relationship(relationship r)
+{
+    m_relationships.push_back(std::move(r));
+    return "rId" + std::to_string(m_relationships.size());
+}
+
+void document_writer::write_styles(const style_registry &styles)
+{
+    m_out->write(xml_declaration);
+    m_out->write("<w:styles xmlns:w=\"");
+    m_out->write(w_ns);
+    m_out->write("\"><w:docDefaults><w:rPrDefault><w:rPr><w:sz w:val=\"22\"/></w:rPr>"
+                 "</w:rPrDefault></w:docDefaults>");
+
+    if(!styles.find("Normal"))
+        m_out->write("<w:style w:type=\"paragraph\" w:default=\"1\" w:styleId=\"Normal\">"
+                     "<w:name w:val=\"Normal\"/><w:qFormat/></w:style>");
+
+    for(auto level : m_heading_levels)
+    {
+        if(styles.find("Heading" + std::to_string(level)))
+            continue;
+        static constexpr std::array<int, 9> sizes = {32, 28, 26, 24, 22, 22, 22, 22, 22};
+        m_out->write("<w:style w:type=\"paragraph\" w:styleId=\"Heading");
+        write_number(level);
+        m_out->write("\"><w:name w:val=\"heading ");
+        write_number(level);
+        m_out->write("\"/><w:basedOn w:val=\"Normal\"/><w:next w:val=\"Normal\"/><w:qFormat/>"
+                     "<w:pPr><w:keepNext/><w:spacing w:before=\"240\" w:after=\"60\"/>"
+                     "<w:outlineLvl w:val=\"");
+        write_number(level - 1);
+        m_out->write("\"/></w:pPr><w:rPr><w:b/><w:sz w:val=\"");
+        write_number(sizes[level - 1]);
+        m_out->write("\"/></w:rPr></w:style>");
+    }
+
+    for(const auto &[name, s] : styles)
+    {
+        bool character = m_character_styles.count(name) > 0 && m_block_styles.count(name) == 0;
+        m_out->write(character ? "<w:style w:type=\"character\" w:styleId=\""
+                               : "<w:style w:type=\"paragraph\" w:styleId=\"");
+        write_escaped(name, true);
+        m_out->write("\"><w:name w:val=\"");
+        write_escaped(name, true);
+        m_out->write("\"/>");
+        if(!s.m_parent_style.is_empty())
+        {
+            m_out->write("<w:basedOn w:val=\"");
+            write_escaped(s.m_parent_style.get_name(), true);
+            m_out->write("\"/>");
+        }
+
+        const auto &before = s.m_paragraph_props ? s.m_paragraph_props->m_break_before
+                                                 : std::optional<break_before>{};
+        if(!character && before &&
+            (before->m_break_type == break_type::page ||
+                before->m_break_type == break_type::even_page ||
+                before->m_break_type == break_type::odd_page))
+            m_out->write("<w:pPr><w:pageBreakBefore/></w:pPr>");
+
+        if(const auto &tp = s.m_text_props)
+        {
+            m_out->write("<w:rPr>");
+            if(tp->m_font_name)
+            {
+                for(const char *attribute : {"<w:rFonts w:ascii=\"", "\" w:hAnsi=\"", "\" w:cs=\""})
+                {
+                    m_out->write(attribute);
+                    write_escaped(tp->m_font_name->get_name(), true);
+                }
+                m_out->write("\"/>");
+            }
+            if(tp->m_font_style)
+                m_out->write(*tp->m_font_style == font_style::normal ? "<w:i w:val=\"0\"/>"
+                                                                     : "<w:i/>");
+            if(tp->m_font_size)
+            {
+                // In half points
+                m_out->write("<w:sz w:val=\"");
+                write_number(std::lround(tp->m_font_size->m_points * 2));
+                m_out->write("\"/>");
+            }
+            m_out->write("</w:rPr>");
+        }
+        m_out->write("</w:style>");
+    }
+    m_out->write("</w:styles>");
+}
+
+void document_writer::write_numbering()
+{
+    m_out->write(xml_declaration);
+    m_out->write("<w:numbering xmlns:w=\"");
+    m_out->write(w_ns);
+    m_out->write("\">");
+
+    // Level styles of each definition by ilvl
+    std::vector<std::map<int, const list_style::level_style *>> levels(m_numbering_defs.size());
+    for(std::size_t i = 0; i < m_numbering_defs.size(); ++i)
+    {
+        const auto &def = m_numbering_defs[i];
+        if(def.m_style)
+            for(const auto &level_style : def.m_style->m_level_styles)
+            {
+                auto level = std::visit([](const auto &ls) { return ls.m_level; }, level_style);
+                levels[i].emplace(std::clamp(level, 1, 9) - 1, &level_style);
+            }
+        // Levels which are used but not styled are bulleted
+        for(int ilvl = 0; ilvl < def.m_levels; ++ilvl)
+            levels[i].emplace(ilvl, nullptr);
+
+        m_out->write("<w:abstractNum w:abstractNumId=\"");
+        write_number(static_cast<long long>(i));
+        m_out->write("\"><w:multiLevelType w:val=\"hybridMultilevel\"/>");
+        for(const auto &[ilvl, level_style] : levels[i])
+        {
+            m_out->write("<w:lvl w:ilvl=\"");
+            write_number(ilvl);
+            m_out->write("\">");
+            const auto *num = level_style ? std::get_if<list_style_num>(level_style) : nullptr;
+            if(num)
+            {
+                m_out->write("<w:start w:val=\"");
+                write_number(num->m_start_from);
+                m_out->write("\"/><w:numFmt w:val=\"");
+                m_out->write(num_format(num->m_format));
+                m_out->write("\"/><w:lvlText w:val=\"");
+                write_escaped(num->m_num_prefix, true);
+                m_out->put('%');
+                write_number(ilvl + 1);
+                write_escaped(num->m_num_suffix, true);
+            }
+            else
+            {
+                const auto *bullet =
+                    level_style ? std::get_if<list_style_bullet>(level_style) : nullptr;
+                m_out->write("<w:numFmt w:val=\"bullet\"/><w:lvlText w:val=\"");
+                write_escaped(bullet ? std::string_view(bullet->m_bullet_char) : "•", true);
+            }
+            m_out->write("\"/><w:lvlJc w:val=\"left\"/><w:pPr><w:ind w:left=\"");
+            write_number(720 * (ilvl + 1));
+            m_out->write("\" w:hanging=\"360\"/></w:pPr></w:lvl>");
+        }
+        m_out->write("</w:abstractNum>");
+    }
+
+    for(std::size_t n = 0; n < m_nums.size(); ++n)
+    {
+        m_out->write("<w:num w:numId=\"");
+        write_number(static_cast<long long>(n + 1));
+        m_out->write("\"><w:abstractNumId w:val=\"");
+        write_number(static_cast<long long>(m_nums[n].m_def));
+        m_out->write("\"/>");
+        if(m_nums[n].m_restart)
+        {
+            // Later lists with the same style start counting again
+            for(const auto &[ilvl, level_style] : levels[m_nums[n].m_def])
+            {
+                const auto *num = level_style ? std::get_if<list_style_num>(level_style) : nullptr;
+                if(!num)
+                    continue;
+                m_out->write("<w:lvlOverride w:ilvl=\"");
+                write_number(ilvl);
+                m_out->write("\"><w:startOverride w:val=\"");
+                write_number(num->m_start_from);
+                m_out->write("\"/></w:lvlOverride>");
+            }
+        }
+        m_out->write("</w:num>");
+    }
+    m_out->write("</w:numbering>");
+}
+
+void document_writer::write_relationships()
+{
+    m_out->write(xml_declaration);
+    m_out->write(
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">");
+    for(std::size_t i = 0; i < m_relationships.size(); ++i)
+    {
+        const auto &r = m_relationships[i];
+        m_out->write("<Relationship Id=\"rId");
+        write_number(static_cast<long long>(i + 1));
+        m_out->write("\" Type=\"");
+        m_out->write(rel_type_base);
+        m_out->write(r.m_type);
+        m_out->write("\" Target=\"");
+        write_escaped(r.m_target, true);
+        m_out->write(r.m_external ? "\" TargetMode=\"External\"/>" : "\"/>");
+    }
+    m_out->write("</Relationships>");
+}
+
+void document_writer::write_content_types()
+{
+    auto extensions = image_types;
+    for(const auto &item : m_media)
+    {
+        auto extension = fs::path(item.m_dest).extension().string();
+        if(!extension.empty())
+            extensions.emplace(extension, "application/octet-stream");
+    }
+    m_out->write(content_types(extensions));
+}
+
+void document_writer::write_escaped(std::string_view s, bool attribute)
+{
+    std::size_t from = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        auto kind = special[static_cast<unsigned char>(s[i])];
+        if(kind == 0 || (kind == 2 && !attribute))
+            continue;
+        m_out->write(s.substr(from, i - from));
+        switch(s[i])
+        {
+        case '&': m_out->write("&amp;"); break;
+        case '<': m_out->write("&lt;"); break;
+        case '>': m_out->write("&gt;"); break;
+        case '"': m_out->write("&quot;"); break;
+        case '\t': m_out->write("&#9;"); break;
+        case '\n': m_out->write("&#10;"); break;
+        default: break; // Control characters can't be represented in XML 1.0
+        }
+        from = i + 1;
+    }
+    m_out->write(s.substr(from));
+}
+
+void document_writer::write_number(long long n)
+{
+    std::array<char, 24> buf;
+    auto end = std::to_chars(buf.data(), buf.data() + buf.size(), n).ptr;
+    m_out->write({buf.data(), static_cast<std::size_t>(end - buf.data())});
+}
+}
@@ -0,0 +1,43 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include "docsmithcpp/archive_reader.h"
+#include "docsmithcpp/docx/file.h"
+#include "docsmithcpp/docx/reader.h"
+#include "docsmithcpp/docx/writer.h"
+
+namespace docsmith
+{
+docx_file::docx_file(const std::string &filename) :
+    m_filename(filename)
+{
+}
+
+text_doc docx_file::parse_text_doc()
+{
+    archive_reader zip(m_filename);
+    return docx::read(
+        [&zip](const std::string &name, const byte_sink &sink) { return zip.read(name, sink); });
+}
+
+void docx_file::save(const text_doc &doc) { docx::writer::write(doc, m_filename); }
+
+std::future<void> docx_file::async_save(const text_doc &doc)
+{
+    return docx::writer::write_async(doc, m_filename);
+}
+}
@@ -0,0 +1,588 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <charconv>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "docsmithcpp/docx/reader.h"
+#include "docsmithcpp/xml_parser.h"
+
+namespace docsmith::docx
+{
+namespace
+{
+struct relationship
+{
+    std::string m_target; //!< Package path, or the URL of an external target
+    std::string m_type;
+    bool m_external{false};
+};
+using relationships = std::unordered_map<std::string, relationship>;
+
+int to_int(std::string_view s, int fallback = 0)
+{
+    int v = fallback;
+    std::from_chars(s.data(), s.data() + s.size(), v);
+    return v;
+}
+
+/// Value of an on/off property such as <w:i/> or <w:i w:val="false"/>
+bool is_on(std::span<const xml_attribute> attributes)
+{
+    auto v = find_attribute(attributes, "w:val", "true");
+    return v != "0" && v != "false" && v != "off";
+}
+
+/// Parse a part as it streams in. Returns false if there is no such part.
+bool parse_part(const part_reader &parts, const std::string &name, xml_handler &handler)
+{
+    xml_parser parser(handler);
+    if(!parts(name, [&](const char *data, std::size_t size) { parser.feed({data, size}); }))
+        return false;
+    parser.finish();
+    return true;
+}
+
+/// The package path of target, relative to the directory dir (which ends with '/' unless empty)
+std::string resolve_target(std::string_view dir, std::string_view target)
+{
+    std::string path = target.starts_with('/') ? std::string(target.substr(1))
+                                               : std::string(dir) + std::string(target);
+    std::string r;
+    for(std::size_t pos = 0; pos <= path.size();)
+    {
+        auto slash = std::min(path.find('/', pos), path.size());
+        auto segment = std::string_view(path).substr(pos, slash - pos);
+        if(segment == "..")
+        {
+            if(!r.empty())
+            {
+                r.pop_back();
+                auto prev = r.rfind('/');
+                r.erase(prev == std::string::npos ? 0 : prev + 1);
+            }
+        }
+        else if(!segment.empty() && segment != ".")
+        {
+            r += segment;
+            if(slash < path.size())
+                r += '/';
+        }
+        pos = slash + 1;
+    }
+    return r;
+}
+
+std::string_view directory_of(std::string_view part)
+{
+    auto slash = part.rfind('/');
+    return slash == std::string_view::npos ? std::string_view{} : part.substr(0, slash + 1);
+}
+
+class relationships_handler : public xml_handler
+{
+public:
+    relationships_handler(relationships &rels, std::string_view dir) :
+        m_rels(rels), m_dir(dir)
+    {
+    }
+
+    void start_element(std::string_view name, std::span<const xml_attribute> attributes) override
+    {
+        if(name != "Relationship")
+            return;
+        relationship r;
+        r.m_type = find_attribute(attributes, "Type");
+        r.m_external = find_attribute(attributes, "TargetMode") == "External";
+        auto target = find_attribute(attributes, "Target");
+        r.m_target = r.m_external ? std::string(target) : resolve_target(m_dir, target);
+        m_rels[std::string(find_attribute(attributes, "Id"))] = std::move(r);
+    }
+    void end_element(std::string_view) override { }
+    void characters(std::string_view) override { }
+
+private:
+    relationships &m_rels;
+    std::string_view m_dir;
+};
+
+/// Reads styles.xml into the style registry, noting the outline level of heading styles
+class styles_handler : public xml_handler
+{
+public:
+    styles_handler(style_registry &styles, std::unordered_map<std::string, int> &outline_levels) :
+        m_styles(styles), m_outline_levels(outline_levels)
+    {
+    }
+
+    void start_element(std::string_view name, std::span<const xml_attribute> attributes) override
+    {
+        if(name == "w:style")
+        {
+            auto type = find_attribute(attributes, "w:type");
+            m_in_style = type == "paragraph" || type == "character";
+            if(m_in_style)
+                m_style = style{style_name(std::string(find_attribute(attributes, "w:styleId")))};
+            return;
+        }
+        if(!m_in_style)
+            return;
+
+        auto val = find_attribute(attributes, "w:val");
+        if(name == "w:basedOn")
+            m_style.m_parent_style = style_name(std::string(val));
+        else if(name == "w:outlineLvl")
+            m_outline_levels[m_style.m_name.get_name()] = to_int(val, 9);
+        else if(name == "w:pageBreakBefore" && is_on(attributes))
+            m_style.set(paragraph_props{break_before{break_type::page}});
+        else if(name == "w:i")
+            text().set(is_on(attributes) ? font_style::italic : font_style::normal);
+        else if(name == "w:sz")
+            text().set(font_size{static_cast<float>(to_int(val)) / 2}); // In half points
+        else if(name == "w:rFonts" && !find_attribute(attributes, "w:ascii").empty())
+            text().set(font_name{std::string(find_attribute(attributes, "w:ascii"))});
+    }
+
+    void end_element(std::string_view name) override
+    {
+        if(name == "w:style" && m_in_style)
+        {
+            m_styles.add(m_style);
+            m_in_style = false;
+        }
+    }
+
+    void characters(std::string_view) override { }
+
+private:
+    text_props &text()
+    {
+        if(!m_style.m_text_props)
+            m_style.m_text_props.emplace();
+        return *m_style.m_text_props;
+    }
+
+    style_registry &m_styles;
+    std::unordered_map<std::string, int> &m_outline_levels;
+    style m_style;
+    bool m_in_style{false};
+};
+
+/// Reads numbering.xml into a list style per numbering instance
+class numbering_handler : public xml_handler
+{
+public:
+    void start_element(std::string_view name, std::span<const xml_attribute> attributes) override
+    {
+        auto val = find_attribute(attributes, "w:val");
+        if(name == "w:abstractNum")
+            m_abstract_id = find_attribute(attributes, "w:abstractNumId");
+        else if(name == "w:num")
+            m_num_id = find_attribute(attributes, "w:numId");
+        else if(name == "w:abstractNumId" && !m_num_id.empty())
+            m_nums[m_num_id] = val;
+        else if(name == "w:lvl" && m_num_id.empty())
+            m_level = &m_abstract[m_abstract_id][to_int(find_attribute(attributes, "w:ilvl"))];
+        else if(!m_level)
+            return;
+        else if(name == "w:start")
+            m_level->m_start = to_int(val, 1);
+        else if(name == "w:numFmt")
+            m_level->m_format = val;
+        else if(name == "w:lvlText")
+            m_level->m_text = val;
+    }
+
+    void end_element(std::string_view name) override
+    {
+        if(name == "w:lvl")
+            m_level = nullptr;
+        else if(name == "w:num")
+            m_num_id.clear();
+    }
+
+    void characters(std::string_view) override { }
+
+    void add_list_styles(list_style_registry &list_styles) const
+    {
+        for(const auto &[num_id, abstract_id] : m_nums)
+        {
+            auto it = m_abstract.find(abstract_id);
+            if(it == m_abstract.end())
+                continue;
+            list_style ls(style_name("WWNum" + num_id), {});
+            for(const auto &[ilvl, def] : it->second)
+                ls.m_level_styles.push_back(def.to_level_style(ilvl + 1));
+            list_styles.add(ls);
+        }
+    }
+
+private:
+    struct level
+    {
+        int m_start{1};
+        std::string m_format{"decimal"};
+        std::string m_text; //!< e.g. "%1." or a bullet character
+
+        list_style::level_style to_level_style(int level) const
+        {
+            if(m_format == "bullet" || m_format == "none")
+                return list_style_bullet(style{}, level, m_text);
+
+            static const std::map<std::string_view, list_enum> formats = {
+                {"lowerLetter", list_enum::lower_alpha},
+                {"upperLetter", list_enum::upper_alpha},
+                {"lowerRoman", list_enum::lower_roman},
+                {"upperRoman", list_enum::upper_roman}};
+            auto format = formats.find(m_format);
+
+            // Text around the level numbers, e.g. "(" and ")" in "(%1)"
+            auto first = m_text.find('%');
+            auto last = m_text.rfind('%');
+            std::string prefix = m_text.substr(0, first);
+            std::string suffix =
+                last == std::string::npos ? "" : m_text.substr(std::min(last + 2, m_text.size()));
+            return list_style_num(style{}, level,
+                format == formats.end() ? list_enum::arabic : format->second, suffix, m_start,
+                prefix);
+        }
+    };
+
+    std::unordered_map<std::string, std::map<int, level>> m_abstract; //!< By abstractNumId
+    std::map<std::string, std::string> m_nums; //!< numId to abstractNumId
+    std::string m_abstract_id;
+    std::string m_num_id; //!< Set inside <w:num>
+    level *m_level{nullptr};
+};
+
+/// Builds the tree from document.xml
+class document_handler : public xml_handler
+{
+public:
+    document_handler(text_doc &doc, const relationships &rels,
+        const std::unordered_map<std::string, int> &outline_levels) :
+        m_doc(doc), m_rels(rels), m_outline_levels(outline_levels)
+    {
+    }
+
+    void start_element(std::string_view name, std::span<const xml_attribute> attributes) override
+    {
+        if(m_skip > 0 || name == "mc:Fallback" || name == "w:txbxContent" ||
+            name == "w:pPrChange" || name == "w:rPrChange")
+        {
+            // Skipped: the fallback of alternate content (the choice is read), text boxes, and
+            // the old properties of tracked changes
+            ++m_skip;
+            return;
+        }
+
+        auto val = find_attribute(attributes, "w:val");
+        if(name == "w:p")
+        {
+            m_para = {};
+            m_in_para = true;
+        }
+        else if(!m_in_para)
+            return;
+        else if(name == "w:pStyle")
+            m_para.m_style = val;
+        else if(name == "w:outlineLvl")
+            m_para.m_outline_level = to_int(val, 9);
+        else if(name == "w:numId")
+            m_para.m_num_id = val;
+        else if(name == "w:ilvl")
+            m_para.m_ilvl = to_int(val);
+        else if(name == "w:pPr")
+            m_in_ppr = true;
+        else if(m_in_ppr)
+            return; // Nothing else in the paragraph properties is read, nor the mark's run
+        else if(name == "w:r")
+        {
+            begin_block();
+            m_run_style.clear();
+        }
+        else if(name == "w:rStyle")
+            m_run_style = val;
+        else if(name == "w:t")
+            m_in_t = true;
+        else if(name == "w:tab")
+            m_run_text += '\t';
+        else if(name == "w:br" || name == "w:cr")
+        {
+            if(find_attribute(attributes, "w:type", "textWrapping") == "textWrapping")
+                m_run_text += '\n';
+        }
+        else if(name == "w:hyperlink")
+        {
+            begin_block();
+            flush_run();
+            auto anchor = find_attribute(attributes, "w:anchor");
+            std::string url;
+            if(auto it = m_rels.find(std::string(find_attribute(attributes, "r:id")));
+                it != m_rels.end())
+                url = it->second.m_target;
+            if(!anchor.empty())
+                (url += '#') += anchor;
+            auto link = std::make_unique<hyperlink>(url);
+            m_inline.push_back(link.get());
+            m_inline[m_inline.size() - 2]->add_child(std::move(link));
+        }
+        else if(name == "w:bookmarkStart")
+        {
+            auto bookmark_name = find_attribute(attributes, "w:name");
+            if(bookmark_name != "_GoBack")
+            {
+                begin_block();
+                flush_run();
+                m_inline.back()->add_child(std::make_unique<bookmark>(std::string(bookmark_name)));
+            }
+        }
+        else if(name == "a:blip" || name == "v:imagedata")
+        {
+            auto id = find_attribute(attributes, name == "a:blip" ? "r:embed" : "r:id");
+            if(auto it = m_rels.find(std::string(id)); it != m_rels.end())
+            {
+                // Frames belong to the paragraph, not the run
+                begin_block();
+                flush_run();
+                auto f = std::make_unique<frame>();
+                f->add_child(std::make_unique<image>(it->second.m_target));
+                m_inline.front()->add_child(std::move(f));
+            }
+        }
+    }
+
+    void end_element(std::string_view name) override
+    {
+        if(m_skip > 0)
+        {
+            --m_skip;
+            return;
+        }
+        if(!m_in_para)
+            return;
+        if(name == "w:pPr")
+            m_in_ppr = false;
+        else if(name == "w:t")
+            m_in_t = false;
+        else if(name == "w:r")
+            flush_run();
+        else if(name == "w:hyperlink" && m_inline.size() > 1)
+        {
+            flush_run();
+            m_inline.pop_back();
+        }
+        else if(name == "w:p")
+        {
+            begin_block();
+            flush_run();
+            place_block();
+            m_in_para = false;
+        }
+    }
+
+    void characters(std::string_view text) override
+    {
+        if(m_in_t && m_skip == 0)
+            m_run_text += text;
+    }
+
+private:
+    struct paragraph_state
+    {
+        std::string m_style;
+        int m_outline_level{9}; //!< 0 to 8 for headings, 9 for body text
+        std::string m_num_id;   //!< Numbering instance, empty or "0" if not numbered
+        int m_ilvl{0};
+    };
+
+    /// An open list, and its last item which nested lists go in
+    struct open_list
+    {
+        list *m_list;
+        list_item *m_item;
+    };
+
+    int outline_level(const std::string &style_id) const
+    {
+        // Inherited through the basedOn chain
+        const std::string *id = &style_id;
+        for(int depth = 0; depth < 16 && !id->empty(); ++depth)
+        {
+            if(auto it = m_outline_levels.find(*id); it != m_outline_levels.end())
+                return it->second;
+            const auto *s = m_doc.styles().find(*id);
+            if(!s)
+                break;
+            id = &s->m_parent_style.get_name();
+        }
+        return 9;
+    }
+
+    /// Make the block once the paragraph properties are known, i.e. at its first content
+    void begin_block()
+    {
+        if(m_block)
+            return;
+        auto level = m_para.m_outline_level < 9 ? m_para.m_outline_level
+                                                : outline_level(m_para.m_style);
+        if(level < 9)
+        {
+            auto h = std::make_unique<heading>(level + 1);
+            if(!m_para.m_style.empty())
+                h->set_style(style_name(m_para.m_style));
+            m_block = std::move(h);
+        }
+        else
+        {
+            auto p = std::make_unique<paragraph>();
+            if(!m_para.m_style.empty())
+                p->set_style(style_name(m_para.m_style));
+            m_block = std::move(p);
+        }
+        m_inline.assign(1, m_block.get());
+    }
+
+    /// Add the text of the current run, if any, as a span
+    void flush_run()
+    {
+        if(m_run_text.empty())
+            return;
+        auto s = std::make_unique<span>();
+        if(!m_run_style.empty())
+            s->set_style(style_name(m_run_style));
+        s->add_child(std::make_unique<text>(std::move(m_run_text)));
+        m_run_text.clear();
+        m_inline.back()->add_child(std::move(s));
+    }
+
+    /// Add the completed block to the document, or to the list its numbering puts it in
+    void place_block()
+    {
+        m_inline.clear();
+        auto block = std::move(m_block);
+        if(m_para.m_num_id.empty() || m_para.m_num_id == "0")
+        {
+            m_lists.clear();
+            m_doc.add_child(std::move(block));
+            return;
+        }
+        if(m_para.m_num_id != m_list_num_id)
+        {
+            m_lists.clear();
+            m_list_num_id = m_para.m_num_id;
+        }
+
+        auto depth = static_cast<std::size_t>(std::clamp(m_para.m_ilvl, 0, 8)) + 1;
+        if(m_lists.size() > depth)
+            m_lists.resize(depth);
+        while(m_lists.size() < depth)
+        {
+            auto l = std::make_unique<list>();
+            auto *raw = l.get();
+            if(m_lists.empty())
+            {
+                l->set_style(style_name("WWNum" + m_list_num_id));
+                m_doc.add_child(std::move(l));
+            }
+            else
+            {
+                // Skipped levels get an empty item to hold the nested list
+                auto &parent = m_lists.back();
+                if(!parent.m_item)
+                    parent.m_item = add_item(*parent.m_list);
+                parent.m_item->add_child(std::move(l));
+            }
+            m_lists.push_back({raw, nullptr});
+        }
+        m_lists.back().m_item = add_item(*m_lists.back().m_list);
+        m_lists.back().m_item->add_child(std::move(block));
+    }
+
+    static list_item *add_item(list &l)
+    {
+        auto item = std::make_unique<list_item>();
+        auto *raw = item.get();
+        l.add_child(std::move(item));
+        return raw;
+    }
+
+    text_doc &m_doc;
+    const relationships &m_rels;
+    const std::unordered_map<std::string, int> &m_outline_levels;
+
+    int m_skip{0}; //!< Depth inside a skipped element
+    bool m_in_para{false};
+    bool m_in_ppr{false};
+    bool m_in_t{false};
+    paragraph_state m_para;
+    std::unique_ptr<element> m_block; //!< The paragraph or heading being read
+    std::vector<element *> m_inline;  //!< The block, then any hyperlink open inside it
+    std::string m_run_style;
+    std::string m_run_text;
+
+    std::vector<open_list> m_lists; //!< Open lists, outermost first
+    std::string m_list_num_id;      //!< Numbering instance of the open lists
+};
+}
+
+text_doc read(const part_reader &parts)
+{
+    // The main document is found through the package relationships
+    relationships package_rels;
+    relationships_handler package_handler(package_rels, {});
+    parse_part(parts, "_rels/.rels", package_handler);
+    std::string main_part = "word/document.xml";
+    for(const auto &[id, rel] : package_rels)
+        if(rel.m_type.ends_with("/officeDocument"))
+            main_part = rel.m_target;
+
+    auto dir = std::string(directory_of(main_part));
+    auto file = main_part.substr(dir.size());
+    relationships rels;
+    relationships_handler rels_handler(rels, dir);
+    parse_part(parts, dir + "_rels/" + file + ".rels", rels_handler);
+
+    text_doc doc;
+    std::unordered_map<std::string, int> outline_levels;
+    for(const auto &[id, rel] : rels)
+    {
+        if(rel.m_type.ends_with("/styles"))
+        {
+            styles_handler handler(doc.styles(), outline_levels);
+            parse_part(parts, rel.m_target, handler);
+        }
+        else if(rel.m_type.ends_with("/numbering"))
+        {
+            numbering_handler handler;
+            parse_part(parts, rel.m_target, handler);
+            handler.add_list_styles(doc.list_styles());
+        }
+    }
+
+    document_handler handler(doc, rels, outline_levels);
+    if(!parse_part(parts, main_part, handler))
+        throw std::runtime_error("Could not find " + main_part);
+    return doc;
+}
+}
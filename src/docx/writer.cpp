@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "docsmithcpp/docx/writer.h"
+
+namespace docsmith::docx
+{
+namespace
+{
+constexpr long long emu_per_pixel = 9525;      // At 96 dpi
+constexpr long long max_image_width = 5486400; // 6 inches, the width of a page's text
+
+/// Size of an image in EMU, from the header of a PNG or a default square for anything else
+extent image_extent(const std::string &path)
+{
+    std::array<unsigned char, 24> header{};
+    std::ifstream in(path, std::ios::binary);
+    if(!in.read(reinterpret_cast<char *>(header.data()), header.size()) ||
+        std::string_view(reinterpret_cast<const char *>(header.data() + 12), 4) != "IHDR")
+        return default_image_extent;
+
+    auto be32 = [&](std::size_t i)
+    {
+        return (static_cast<long long>(header[i]) << 24) | (header[i + 1] << 16) |
+               (header[i + 2] << 8) | header[i + 3];
+    };
+    long long cx = be32(16) * emu_per_pixel;
+    long long cy = be32(20) * emu_per_pixel;
+    if(cx <= 0 || cy <= 0)
+        return default_image_extent;
+    if(cx > max_image_width)
+    {
+        cy = cy * max_image_width / cx;
+        cx = max_image_width;
+    }
+    return {cx, cy};
+}
+
+/// Pictures are read from the filesystem
+bool read_file(const std::string &path, const byte_sink &sink)
+{
+    std::ifstream in(path, std::ios::binary);
+    if(!in)
+        return false;
+    std::vector<char> buf(1 << 16);
+    while(in.read(buf.data(), static_cast<std::streamsize>(buf.size())) || in.gcount() > 0)
+        sink(buf.data(), static_cast<std::size_t>(in.gcount()));
+    return true;
+}
+}
+
+void writer::write(const text_doc &doc, const std::string &filename)
+{
+    write_zip(filename,
+        [&doc](zip_writer &zip)
+        {
+            writer w;
+            w.write_archive(zip, doc, false);
+        });
+}
+
+void writer::write(const text_doc &doc, std::ostream &os)
+{
+    write_zip(os,
+        [&doc](zip_writer &zip)
+        {
+            writer w;
+            w.write_archive(zip, doc, false);
+        });
+}
+
+std::vector<std::byte> writer::write(const text_doc &doc)
+{
+    return write_zip(
+        [&doc](zip_writer &zip)
+        {
+            writer w;
+            w.write_archive(zip, doc, false);
+        });
+}
+
+std::future<void> writer::write_async(const text_doc &doc, const std::string &filename)
+{
+    return std::async(std::launch::async,
+        [&doc, filename]
+        {
+            write_zip(filename,
+                [&](zip_writer &zip)
+                {
+                    writer w;
+                    w.write_archive(zip, doc, true);
+                });
+        });
+}
+
+void writer::write_archive(zip_writer &zip, const text_doc &doc, bool pipelined)
+{
+    document_writer::begin_package(zip);
+
+    // Add the main document, compressing it as it is printed:
+    auto print = [this, &doc](const byte_sink &sink)
+    {
+        output_buffer out(sink);
+        m_document.begin_document(out);
+        doc.accept(*this);
+        m_document.end_document();
+        out.flush();
+    };
+    if(pipelined)
+    {
+        // Visiting and printing, deflating and writing each get their own thread:
+        zip.add_pipelined("word/document.xml", print);
+    }
+    else
+    {
+        zip.begin_entry("word/document.xml");
+        print([&zip](const char *data, std::size_t size) { zip.write(data, size); });
+        zip.end_entry();
+    }
+
+    m_document.end_package(zip, doc.styles(), read_file);
+}
+
+void writer::visit(const text_doc &d) { m_doc = &d; }
+
+void writer::visit(const heading &h)
+{
+    m_document.begin_block(h.get_style().get_name(), std::clamp(h.level(), 1, 9) - 1);
+    m_next = open_t::block;
+}
+
+void writer::visit(const paragraph &p)
+{
+    m_document.begin_block(p.get_style().get_name());
+    m_next = open_t::block;
+}
+
+void writer::visit(const span &s)
+{
+    m_document.begin_span(s.get_style().get_name());
+    m_next = open_t::span;
+}
+
+void writer::visit(const text &t) { m_document.text(t.m_text); }
+
+void writer::visit(const hyperlink &h)
+{
+    m_document.begin_hyperlink(h.get_url());
+    m_next = open_t::hyperlink;
+}
+
+void writer::visit(const list &l)
+{
+    m_document.begin_list(m_doc ? m_doc->list_styles().find(l.get_style().get_name()) : nullptr);
+    m_next = open_t::list;
+}
+
+void writer::visit(const list_item &) { m_document.begin_item(); }
+
+void writer::visit(const frame &) { }
+
+void writer::visit(const image &v) { m_document.image(v.get_uri(), image_extent(v.get_uri())); }
+
+void writer::visit(const bookmark &b) { m_document.bookmark(b.m_name); }
+
+void writer::push()
+{
+    m_open.push_back(m_next);
+    m_next = open_t::other;
+}
+
+void writer::pop()
+{
+    auto closed = m_open.back();
+    m_open.pop_back();
+    switch(closed)
+    {
+    case open_t::block: m_document.end_block(); break;
+    case open_t::span: m_document.end_span(); break;
+    case open_t::hyperlink: m_document.end_hyperlink(); break;
+    case open_t::list: m_document.end_list(); break;
+    case open_t::other: break;
+    }
+}
+}
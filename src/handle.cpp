@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <atomic>
+#include <stdexcept>
+
+#include "docsmithcpp/handle.h"
+
+namespace docsmith
+{
+namespace
+{
+std::atomic<std::uint64_t> next_generation{1};
+}
+
+std::pair<std::uint32_t, std::uint64_t> handle_table::acquire_slot(element &e)
+{
+    if(e.m_handle)
+    {
+        auto table = e.m_handle->m_table.lock();
+        if(table.get() == this)
+            return {e.m_handle->m_index, m_slots[e.m_handle->m_index].m_generation};
+        // Moved here from another document: handles from there stop resolving
+        if(table)
+            table->release(e.m_handle->m_index);
+    }
+
+    std::uint32_t index;
+    if(!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        if(m_slots.size() == UINT32_MAX)
+            throw std::length_error("Too many element handles");
+        index = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    auto generation = next_generation++;
+    m_slots[index] = {&e, generation};
+    e.m_handle = std::make_unique<handle_link>(handle_link{weak_from_this(), index});
+    return {index, generation};
+}
+
+element *handle_table::lookup(std::uint32_t index, std::uint64_t generation) const
+{
+    if(generation == 0 || index >= m_slots.size() || m_slots[index].m_generation != generation)
+        return nullptr;
+    return m_slots[index].m_element;
+}
+
+void handle_table::release(std::uint32_t index)
+{
+    m_slots[index] = {nullptr, 0};
+    m_free.push_back(index);
+}
+}
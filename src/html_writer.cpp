@@ -0,0 +1,435 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <variant>
+
+#include "docsmithcpp/base64.h"
+#include "docsmithcpp/html_writer.h"
+
+namespace docsmith
+{
+namespace
+{
+/// Characters replaced by entities, in text and (with '"') in attribute values
+constexpr auto special = [] {
+    std::array<char, 256> r{};
+    r['&'] = r['<'] = r['>'] = r['\n'] = 1;
+    r['"'] = 2;
+    return r;
+}();
+
+/// A class name for a style name. Letters, digits and '_' are kept and anything else is written
+/// as '-' and two hex digits, so distinct names always give distinct classes.
+std::string class_name(const std::string &name)
+{
+    constexpr const char *hex = "0123456789ABCDEF";
+    std::string r = "ds-";
+    for(unsigned char c : name)
+    {
+        if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
+            r += static_cast<char>(c);
+        else
+        {
+            r += '-';
+            r += hex[c >> 4];
+            r += hex[c & 15];
+        }
+    }
+    return r;
+}
+
+std::string_view css_break(break_type b)
+{
+    switch(b)
+    {
+    case break_type::column:
+        return "column";
+    case break_type::page:
+        return "page";
+    case break_type::even_page:
+        return "left";
+    case break_type::odd_page:
+        return "right";
+    case break_type::automatic:
+        break;
+    }
+    return "auto";
+}
+
+/// The declarations of s with those of its parents folded in, or "" if it has none
+std::string css_declarations(const style_registry &styles, const style &s)
+{
+    std::optional<font_size> size;
+    std::optional<font_style> slant;
+    std::optional<font_name> family;
+    std::optional<break_before> before;
+    std::optional<break_after> after;
+
+    // Nearest style first, so only properties which are still unset are inherited
+    const style *current = &s;
+    for(int depth = 0; current && depth < 16; ++depth)
+    {
+        if(const auto &t = current->m_text_props)
+        {
+            if(!size)
+                size = t->m_font_size;
+            if(!slant)
+                slant = t->m_font_style;
+            if(!family)
+                family = t->m_font_name;
+        }
+        if(const auto &p = current->m_paragraph_props)
+        {
+            if(!before)
+                before = p->m_break_before;
+            if(!after)
+                after = p->m_break_after;
+        }
+        if(current->m_parent_style.is_empty())
+            break;
+        current = styles.find(current->m_parent_style.get_name());
+    }
+
+    std::string r;
+    if(size)
+    {
+        std::array<char, 32> buf;
+        auto end = std::to_chars(buf.data(), buf.data() + buf.size(), size->m_points).ptr;
+        r += "font-size:";
+        r.append(buf.data(), end);
+        r += "pt;";
+    }
+    if(slant)
+        r += *slant == font_style::italic  ? "font-style:italic;"
+             : *slant == font_style::oblique ? "font-style:oblique;"
+                                             : "font-style:normal;";
+    if(family)
+    {
+        // A CSS string, which must not be able to end the <style> element either
+        r += "font-family:\"";
+        for(char c : family->get_name())
+        {
+            if(c == '"' || c == '\\' || c == '<')
+                r += c == '"' ? "\\22 " : c == '\\' ? "\\5C " : "\\3C ";
+            else
+                r += c;
+        }
+        r += "\";";
+    }
+    if(before)
+        (r += "break-before:") += css_break(before->m_break_type), r += ';';
+    if(after)
+        (r += "break-after:") += css_break(after->m_break_type), r += ';';
+    if(!r.empty())
+        r.pop_back();
+    return r;
+}
+
+std::string_view mime_type(std::string_view uri)
+{
+    auto dot = uri.rfind('.');
+    std::string ext;
+    if(dot != std::string_view::npos)
+        for(char c : uri.substr(dot + 1))
+            ext += static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    if(ext == "png")
+        return "image/png";
+    if(ext == "jpg" || ext == "jpeg")
+        return "image/jpeg";
+    if(ext == "gif")
+        return "image/gif";
+    if(ext == "svg")
+        return "image/svg+xml";
+    if(ext == "webp")
+        return "image/webp";
+    if(ext == "bmp")
+        return "image/bmp";
+    return "application/octet-stream";
+}
+}
+
+html_writer::html_writer(output_buffer &out, html_options options) :
+    m_out(out), m_options(std::move(options))
+{
+}
+
+void html_writer::visit(const text_doc &d)
+{
+    m_doc = &d;
+    m_out.write("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>");
+    write_escaped(m_options.m_title, false);
+    m_out.write("</title>\n");
+    write_stylesheet(d.styles());
+    m_out.write("</head>\n<body>\n");
+    m_next = {"</body>\n</html>\n", open_t::other};
+}
+
+void html_writer::visit(const heading &h)
+{
+    static constexpr std::string_view tags[] = {"h1", "h2", "h3", "h4", "h5", "h6"};
+    static constexpr std::string_view closes[] = {
+        "</h1>\n", "</h2>\n", "</h3>\n", "</h4>\n", "</h5>\n", "</h6>\n"};
+    if(m_block_depth > 0)
+    {
+        open_tag("span", h.get_style());
+        m_next = {"</span>", open_t::other};
+        return;
+    }
+    auto level = std::clamp(h.level(), 1, 6) - 1;
+    open_tag(tags[level], h.get_style());
+    m_next = {closes[level], open_t::block};
+}
+
+void html_writer::visit(const paragraph &p)
+{
+    // Paragraphs can be nested in headings, where they can't be <p>
+    if(m_block_depth > 0)
+    {
+        open_tag("span", p.get_style());
+        m_next = {"</span>", open_t::other};
+        return;
+    }
+    open_tag("p", p.get_style());
+    m_next = {"</p>\n", open_t::block};
+}
+
+void html_writer::visit(const span &s)
+{
+    open_tag("span", s.get_style());
+    m_next = {"</span>", open_t::other};
+}
+
+void html_writer::visit(const hyperlink &href)
+{
+    m_out.write("<a href=\"");
+    write_escaped(href.get_url(), true);
+    m_out.write("\">");
+    m_next = {"</a>", open_t::other};
+}
+
+void html_writer::visit(const text &t) { write_escaped(t.m_text, false); }
+
+void html_writer::visit(const list &l)
+{
+    const list_style *style = m_lists.empty() ? nullptr : m_lists.back();
+    if(m_doc && !l.get_style().is_empty())
+        style = m_doc->list_styles().find(l.get_style().get_name());
+    m_lists.push_back(style);
+
+    const list_style_num *num = nullptr;
+    if(style)
+    {
+        auto depth = static_cast<int>(m_lists.size());
+        for(const auto &ls : style->m_level_styles)
+        {
+            if(std::visit([](const auto &s) { return s.m_level; }, ls) == depth)
+            {
+                num = std::get_if<list_style_num>(&ls);
+                break;
+            }
+        }
+    }
+    if(!num)
+    {
+        m_out.write("<ul>\n");
+        m_next = {"</ul>\n", open_t::list};
+        return;
+    }
+    m_out.write("<ol");
+    if(num->m_format != list_enum::arabic)
+    {
+        m_out.write(" type=\"");
+        m_out.put(static_cast<char>(num->m_format));
+        m_out.put('"');
+    }
+    if(num->m_start_from != 1)
+    {
+        std::array<char, 16> buf;
+        auto end = std::to_chars(buf.data(), buf.data() + buf.size(), num->m_start_from).ptr;
+        m_out.write(" start=\"");
+        m_out.write({buf.data(), static_cast<std::size_t>(end - buf.data())});
+        m_out.put('"');
+    }
+    m_out.write(">\n");
+    m_next = {"</ol>\n", open_t::list};
+}
+
+void html_writer::visit(const list_item &)
+{
+    m_out.write("<li>");
+    m_next = {"</li>\n", open_t::other};
+}
+
+void html_writer::visit(const frame &) { m_next = {}; }
+
+void html_writer::visit(const image &i)
+{
+    m_out.write("<img src=\"");
+    write_image_src(i.get_uri());
+    m_out.write("\" alt=\"\">");
+}
+
+void html_writer::visit(const bookmark &b)
+{
+    m_out.write("<a id=\"");
+    write_escaped(b.m_name, true);
+    m_out.write("\"></a>");
+}
+
+void html_writer::push()
+{
+    m_open.push_back(m_next);
+    if(m_next.m_kind == open_t::block)
+        ++m_block_depth;
+}
+
+void html_writer::pop()
+{
+    auto open = m_open.back();
+    m_open.pop_back();
+    if(open.m_kind == open_t::block)
+        --m_block_depth;
+    else if(open.m_kind == open_t::list)
+        m_lists.pop_back();
+    m_out.write(open.m_close);
+}
+
+const std::string &html_writer::class_of(const style_name &name) const
+{
+    static const std::string none;
+    auto it = m_classes.find(name.get_name());
+    return it != m_classes.end() ? it->second : none;
+}
+
+void html_writer::write_stylesheet(const style_registry &styles)
+{
+    // Sorted so that the same document always gives the same page
+    std::vector<const style *> sorted;
+    for(const auto &[name, s] : styles)
+        sorted.push_back(&s);
+    std::sort(sorted.begin(), sorted.end(),
+        [](const style *a, const style *b) { return a->m_name.get_name() < b->m_name.get_name(); });
+
+    m_classes.clear();
+    m_out.write("<style>\n");
+    for(const auto *s : sorted)
+    {
+        auto declarations = css_declarations(styles, *s);
+        if(declarations.empty())
+            continue;
+        const auto &cls =
+            m_classes.emplace(s->m_name.get_name(), class_name(s->m_name.get_name())).first->second;
+        m_out.put('.');
+        m_out.write(cls);
+        m_out.put('{');
+        m_out.write(declarations);
+        m_out.write("}\n");
+    }
+    m_out.write("</style>\n");
+}
+
+void html_writer::open_tag(std::string_view tag, const style_name &style)
+{
+    m_out.put('<');
+    m_out.write(tag);
+    if(!style.is_empty())
+    {
+        if(const auto &cls = class_of(style); !cls.empty())
+        {
+            m_out.write(" class=\"");
+            m_out.write(cls);
+            m_out.put('"');
+        }
+    }
+    m_out.put('>');
+}
+
+void html_writer::write_escaped(std::string_view s, bool attribute)
+{
+    std::size_t from = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        auto kind = special[static_cast<unsigned char>(s[i])];
+        if(kind == 0 || (kind == 2 && !attribute))
+            continue;
+        m_out.write(s.substr(from, i - from));
+        switch(s[i])
+        {
+        case '&':
+            m_out.write("&amp;");
+            break;
+        case '<':
+            m_out.write("&lt;");
+            break;
+        case '>':
+            m_out.write("&gt;");
+            break;
+        case '"':
+            m_out.write("&quot;");
+            break;
+        case '\n':
+            m_out.write(attribute ? "&#10;" : "<br>");
+            break;
+        }
+        from = i + 1;
+    }
+    m_out.write(s.substr(from));
+}
+
+void html_writer::write_image_src(const std::string &uri)
+{
+    std::optional<std::string> bytes;
+    if(m_options.m_load_image)
+        bytes = m_options.m_load_image(uri);
+    if(!bytes)
+        return write_escaped(uri, true);
+
+    m_out.write("data:");
+    m_out.write(mime_type(uri));
+    m_out.write(";base64,");
+
+    // Encoded a chunk at a time, through a fixed buffer rather than a second copy of the image
+    constexpr std::size_t chunk = 3 * 1024;
+    std::array<char, base64_size(chunk)> encoded;
+    std::string_view in = *bytes;
+    for(std::size_t pos = 0; pos < in.size(); pos += chunk)
+    {
+        auto *end = base64_encode(in.substr(pos, chunk), encoded.data());
+        m_out.write({encoded.data(), static_cast<std::size_t>(end - encoded.data())});
+    }
+}
+
+void write_html(const element &e, output_buffer &out, html_options options)
+{
+    html_writer writer(out, std::move(options));
+    e.accept(writer);
+}
+
+std::string to_html(const element &e, html_options options)
+{
+    std::string r;
+    {
+        output_buffer out([&](const char *data, std::size_t size) { r.append(data, size); });
+        write_html(e, out, std::move(options));
+        out.flush();
+    }
+    return r;
+}
+}
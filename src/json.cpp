@@ -0,0 +1,838 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <deque>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+#include "docsmithcpp/json.h"
+
+namespace docsmith
+{
+namespace
+{
+constexpr int version = 1;
+
+constexpr std::string_view font_styles[] = {"normal", "italic", "oblique"};
+constexpr std::string_view breaks[] = {"column", "page", "even_page", "odd_page", "auto"};
+constexpr std::string_view horiz_positions[] = {
+    "left", "centre", "right", "from_inside", "from_left", "inside", "outside"};
+constexpr std::string_view vert_positions[] = {"top", "middle", "bottom", "from_top", "below"};
+
+template <typename E, std::size_t N>
+std::string_view name_of(E e, const std::string_view (&names)[N])
+{
+    return names[static_cast<std::size_t>(e)];
+}
+
+/// Characters which must be escaped in a JSON string
+constexpr auto needs_escape = [] {
+    std::array<bool, 256> r{};
+    for(int c = 0; c < 0x20; ++c)
+        r[c] = true;
+    r['"'] = r['\\'] = true;
+    return r;
+}();
+
+template <typename T>
+std::string_view format_number(T value, std::array<char, 32> &buf)
+{
+    auto end = std::to_chars(buf.data(), buf.data() + buf.size(), value).ptr;
+    return {buf.data(), static_cast<std::size_t>(end - buf.data())};
+}
+
+/// Recursive descent reader that builds the document as it goes
+class json_reader
+{
+public:
+    explicit json_reader(std::string_view s) :
+        m_s(s)
+    {
+    }
+
+    text_doc read_doc()
+    {
+        text_doc doc;
+        read_object([&](const std::string &key) {
+            if(key == "docsmith")
+            {
+                if(read_int() != version)
+                    fail("unsupported version");
+            }
+            else if(key == "styles")
+                read_array([&] { doc.styles().add(read_style()); });
+            else if(key == "list_styles")
+                read_array([&] { doc.list_styles().add(read_list_style()); });
+            else if(key == "body")
+                read_array([&] { doc.add_child(read_element(1)); });
+            else
+                skip_value(0);
+        });
+        skip_ws();
+        if(m_pos != m_s.size())
+            fail("unexpected data after the document");
+        return doc;
+    }
+
+private:
+    static constexpr int max_depth = 512;
+
+    [[noreturn]] void fail(std::string_view what) const
+    {
+        throw std::runtime_error(
+            "Invalid JSON document at offset " + std::to_string(m_pos) + ": " + std::string(what));
+    }
+
+    void skip_ws()
+    {
+        while(m_pos < m_s.size() &&
+            (m_s[m_pos] == ' ' || m_s[m_pos] == '\n' || m_s[m_pos] == '\r' || m_s[m_pos] == '\t'))
+            ++m_pos;
+    }
+
+    char peek()
+    {
+        skip_ws();
+        return m_pos < m_s.size() ? m_s[m_pos] : '\0';
+    }
+
+    bool consume(char c)
+    {
+        if(peek() != c)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    void expect(char c)
+    {
+        if(!consume(c))
+            fail(std::string("expected '") + c + "'");
+    }
+
+    template <typename OnMember>
+    void read_object(OnMember &&on_member)
+    {
+        expect('{');
+        if(consume('}'))
+            return;
+        std::string key;
+        do
+        {
+            read_string(key);
+            expect(':');
+            on_member(key);
+        } while(consume(','));
+        expect('}');
+    }
+
+    template <typename OnItem>
+    void read_array(OnItem &&on_item)
+    {
+        expect('[');
+        if(consume(']'))
+            return;
+        do
+            on_item();
+        while(consume(','));
+        expect(']');
+    }
+
+    void read_string(std::string &out)
+    {
+        expect('"');
+        out.clear();
+        while(true)
+        {
+            // Copy the run up to the next quote or escape in one go
+            auto end = m_s.find_first_of("\"\\", m_pos);
+            if(end == std::string_view::npos)
+                fail("unterminated string");
+            out.append(m_s.data() + m_pos, end - m_pos);
+            m_pos = end + 1;
+            if(m_s[end] == '"')
+                return;
+            if(m_pos >= m_s.size())
+                fail("unterminated string");
+            switch(char c = m_s[m_pos++])
+            {
+            case '"':
+            case '\\':
+            case '/':
+                out += c;
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+                append_utf8(out, read_code_point());
+                break;
+            default:
+                fail("invalid escape");
+            }
+        }
+    }
+
+    std::string read_string()
+    {
+        std::string r;
+        read_string(r);
+        return r;
+    }
+
+    unsigned read_hex4()
+    {
+        unsigned v = 0;
+        if(m_pos + 4 > m_s.size() ||
+            std::from_chars(m_s.data() + m_pos, m_s.data() + m_pos + 4, v, 16).ptr !=
+                m_s.data() + m_pos + 4)
+            fail("invalid \\u escape");
+        m_pos += 4;
+        return v;
+    }
+
+    char32_t read_code_point()
+    {
+        auto cp = read_hex4();
+        if(cp >= 0xD800 && cp < 0xDC00)
+        {
+            // A surrogate pair
+            if(m_s.substr(m_pos, 2) != "\\u")
+                fail("unpaired surrogate");
+            m_pos += 2;
+            auto low = read_hex4();
+            if(low < 0xDC00 || low >= 0xE000)
+                fail("unpaired surrogate");
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else if(cp >= 0xDC00 && cp < 0xE000)
+            fail("unpaired surrogate");
+        return cp;
+    }
+
+    static void append_utf8(std::string &out, char32_t cp)
+    {
+        if(cp < 0x80)
+            out += static_cast<char>(cp);
+        else if(cp < 0x800)
+        {
+            out += static_cast<char>(0xC0 | cp >> 6);
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if(cp < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | cp >> 12);
+            out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | cp >> 18);
+            out += static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+            out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    template <typename T>
+    T read_number()
+    {
+        skip_ws();
+        T v{};
+        auto [end, ec] = std::from_chars(m_s.data() + m_pos, m_s.data() + m_s.size(), v);
+        if(ec != std::errc())
+            fail("expected a number");
+        m_pos = static_cast<std::size_t>(end - m_s.data());
+        return v;
+    }
+
+    int read_int() { return read_number<int>(); }
+
+    template <typename E, std::size_t N>
+    E read_enum(const std::string_view (&names)[N])
+    {
+        auto s = read_string();
+        auto it = std::find(std::begin(names), std::end(names), s);
+        if(it == std::end(names))
+            fail("unknown value \"" + s + "\"");
+        return static_cast<E>(it - std::begin(names));
+    }
+
+    void skip_value(int depth)
+    {
+        if(depth > max_depth)
+            fail("nesting too deep");
+        switch(peek())
+        {
+        case '{':
+            read_object([&](const std::string &) { skip_value(depth + 1); });
+            break;
+        case '[':
+            read_array([&] { skip_value(depth + 1); });
+            break;
+        case '"':
+            read_string(m_scratch);
+            break;
+        case 't':
+        case 'f':
+        case 'n':
+            for(std::string_view word : {"true", "false", "null"})
+            {
+                if(m_s.substr(m_pos, word.size()) == word)
+                {
+                    m_pos += word.size();
+                    return;
+                }
+            }
+            fail("invalid literal");
+        default:
+            read_number<double>();
+        }
+    }
+
+    text_props read_text_props()
+    {
+        text_props props;
+        read_object([&](const std::string &key) {
+            if(key == "font_size")
+                props.set(font_size{read_number<float>()});
+            else if(key == "font_style")
+                props.set(read_enum<font_style>(font_styles));
+            else if(key == "font_name")
+                props.set(font_name{read_string()});
+            else
+                skip_value(0);
+        });
+        return props;
+    }
+
+    style read_style()
+    {
+        style s;
+        read_object([&](const std::string &key) {
+            if(key == "name")
+                s.m_name = style_name(read_string());
+            else if(key == "parent")
+                s.m_parent_style = style_name(read_string());
+            else if(key == "text")
+                s.set(read_text_props());
+            else if(key == "paragraph")
+            {
+                paragraph_props props;
+                read_object([&](const std::string &key) {
+                    if(key == "break_before")
+                        props.set(break_before{read_enum<break_type>(breaks)});
+                    else if(key == "break_after")
+                        props.set(break_after{read_enum<break_type>(breaks)});
+                    else
+                        skip_value(0);
+                });
+                s.set(props);
+            }
+            else if(key == "graphics")
+            {
+                graphics_props props;
+                read_object([&](const std::string &key) {
+                    if(key == "horiz_pos")
+                        props.set(read_enum<align_horiz>(horiz_positions));
+                    else if(key == "vert_pos")
+                        props.set(read_enum<align_vert>(vert_positions));
+                    else
+                        skip_value(0);
+                });
+                s.set(props);
+            }
+            else
+                skip_value(0);
+        });
+        if(s.m_name.is_empty())
+            fail("style without a name");
+        return s;
+    }
+
+    list_style read_list_style()
+    {
+        list_style ls(style_name{}, {});
+        read_object([&](const std::string &key) {
+            if(key == "name")
+                ls.m_name = style_name(read_string());
+            else if(key == "levels")
+                read_array([&] { ls.m_level_styles.push_back(read_list_level()); });
+            else
+                skip_value(0);
+        });
+        if(ls.m_name.is_empty())
+            fail("list style without a name");
+        return ls;
+    }
+
+    list_style::level_style read_list_level()
+    {
+        int level = 1, start = 1;
+        std::optional<std::string> bullet;
+        std::string format = "1", prefix, suffix = ".", text_style;
+        std::optional<text_props> props;
+        read_object([&](const std::string &key) {
+            if(key == "level")
+                level = read_int();
+            else if(key == "bullet")
+                bullet = read_string();
+            else if(key == "format")
+                format = read_string();
+            else if(key == "prefix")
+                prefix = read_string();
+            else if(key == "suffix")
+                suffix = read_string();
+            else if(key == "start")
+                start = read_int();
+            else if(key == "style")
+                text_style = read_string();
+            else if(key == "text")
+                props = read_text_props();
+            else
+                skip_value(0);
+        });
+
+        if(bullet)
+            return list_style_bullet(style{style_name(text_style)}, level, *bullet);
+        constexpr std::string_view formats = "1aAiI";
+        if(format.size() != 1 || formats.find(format[0]) == std::string_view::npos)
+            fail("unknown list format \"" + format + "\"");
+        list_style_num num(style{style_name(text_style)}, level, static_cast<list_enum>(format[0]),
+            suffix, start, prefix);
+        num.m_text_props = props;
+        return num;
+    }
+
+    template <typename T>
+    static std::unique_ptr<element> with_style(std::unique_ptr<T> e, const std::string &style)
+    {
+        if(!style.empty())
+            e->set_style(style_name(style));
+        return e;
+    }
+
+    std::unique_ptr<element> read_element(int depth)
+    {
+        if(depth > max_depth)
+            fail("nesting too deep");
+        if(peek() == '"')
+            return std::make_unique<text>(read_string());
+
+        // Children are collected first, since the element can't be made until its type and
+        // attributes are known. The vectors are kept per depth and reused.
+        if(m_children.size() <= static_cast<std::size_t>(depth))
+            m_children.resize(depth + 1);
+        auto &children = m_children[depth];
+        children.clear();
+
+        std::string type, style, attribute;
+        int level = 1;
+        bool has_children = false;
+        auto start = m_pos;
+        read_object([&](const std::string &key) {
+            if(key == "type")
+                read_string(type);
+            else if(key == "style")
+                read_string(style);
+            else if(key == "level")
+                level = read_int();
+            else if(key == "url" || key == "uri" || key == "name")
+                read_string(attribute);
+            else if(key == "children")
+            {
+                has_children = true;
+                read_array([&] { children.push_back(read_element(depth + 1)); });
+            }
+            else
+                skip_value(depth);
+        });
+
+        std::unique_ptr<element> e;
+        if(type == "p")
+            e = with_style(std::make_unique<paragraph>(), style);
+        else if(type == "h")
+            e = with_style(std::make_unique<heading>(level), style);
+        else if(type == "span")
+            e = with_style(std::make_unique<span>(), style);
+        else if(type == "a")
+            e = std::make_unique<hyperlink>(attribute);
+        else if(type == "list")
+            e = with_style(std::make_unique<list>(), style);
+        else if(type == "item")
+            e = std::make_unique<list_item>();
+        else if(type == "frame")
+            e = with_style(std::make_unique<frame>(), style);
+        else if(type == "image" || type == "bookmark")
+        {
+            if(has_children)
+            {
+                m_pos = start;
+                fail("\"" + type + "\" can't have children");
+            }
+            if(type == "image")
+                return std::make_unique<image>(attribute);
+            return std::make_unique<bookmark>(attribute);
+        }
+        else
+        {
+            m_pos = start;
+            fail(type.empty() ? "element without a type" : "unknown element type \"" + type + "\"");
+        }
+
+        for(auto &child : children)
+            e->add_child(std::move(child));
+        children.clear();
+        return e;
+    }
+
+    std::string_view m_s;
+    std::size_t m_pos{0};
+    std::string m_scratch;
+    std::deque<std::vector<std::unique_ptr<element>>> m_children; //!< Reused per depth
+};
+}
+
+json_writer::json_writer(output_buffer &out) :
+    m_out(out)
+{
+}
+
+void json_writer::visit(const text_doc &d)
+{
+    write_styles(d);
+    m_children_key = "body";
+}
+
+void json_writer::visit(const heading &h)
+{
+    begin("h");
+    std::array<char, 32> buf;
+    m_out.write(",\"level\":");
+    m_out.write(format_number(h.level(), buf));
+    write_style(h.get_style());
+}
+
+void json_writer::visit(const paragraph &p)
+{
+    begin("p");
+    write_style(p.get_style());
+}
+
+void json_writer::visit(const span &s)
+{
+    begin("span");
+    write_style(s.get_style());
+}
+
+void json_writer::visit(const hyperlink &href)
+{
+    begin("a");
+    write_member("url", href.get_url());
+}
+
+void json_writer::visit(const text &t)
+{
+    if(!m_first)
+        m_out.put(',');
+    m_first = false;
+    write_string(t.m_text);
+}
+
+void json_writer::visit(const list &l)
+{
+    begin("list");
+    write_style(l.get_style());
+}
+
+void json_writer::visit(const list_item &) { begin("item"); }
+
+void json_writer::visit(const frame &f)
+{
+    begin("frame");
+    write_style(f.get_style());
+}
+
+void json_writer::visit(const image &i)
+{
+    begin("image");
+    write_member("uri", i.get_uri());
+    m_out.put('}');
+}
+
+void json_writer::visit(const bookmark &b)
+{
+    begin("bookmark");
+    write_member("name", b.m_name);
+    m_out.put('}');
+}
+
+void json_writer::push()
+{
+    m_out.write(",\"");
+    m_out.write(m_children_key);
+    m_out.write("\":[");
+    m_first = true;
+}
+
+void json_writer::pop()
+{
+    m_out.write("]}");
+    m_first = false;
+}
+
+void json_writer::begin(std::string_view type)
+{
+    if(!m_first)
+        m_out.put(',');
+    m_first = false;
+    m_children_key = "children";
+    m_out.write("{\"type\":\"");
+    m_out.write(type);
+    m_out.put('"');
+}
+
+void json_writer::write_member(std::string_view key, std::string_view value)
+{
+    m_out.write(",\"");
+    m_out.write(key);
+    m_out.write("\":");
+    write_string(value);
+}
+
+void json_writer::write_style(const style_name &s)
+{
+    if(!s.is_empty())
+        write_member("style", s.get_name());
+}
+
+void json_writer::write_string(std::string_view s)
+{
+    m_out.put('"');
+    std::size_t from = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        auto c = static_cast<unsigned char>(s[i]);
+        if(!needs_escape[c])
+            continue;
+        m_out.write(s.substr(from, i - from));
+        from = i + 1;
+        m_out.put('\\');
+        switch(c)
+        {
+        case '"':
+        case '\\':
+            m_out.put(static_cast<char>(c));
+            break;
+        case '\n':
+            m_out.put('n');
+            break;
+        case '\r':
+            m_out.put('r');
+            break;
+        case '\t':
+            m_out.put('t');
+            break;
+        default:
+            constexpr const char *hex = "0123456789abcdef";
+            m_out.write("u00");
+            m_out.put(hex[c >> 4]);
+            m_out.put(hex[c & 15]);
+        }
+    }
+    m_out.write(s.substr(from));
+    m_out.put('"');
+}
+
+void json_writer::write_styles(const text_doc &d)
+{
+    std::array<char, 32> buf;
+    auto text = [&](const text_props &t) {
+        char sep = '{';
+        if(t.m_font_size)
+        {
+            m_out.put(sep);
+            m_out.write("\"font_size\":");
+            m_out.write(format_number(t.m_font_size->m_points, buf));
+            sep = ',';
+        }
+        if(t.m_font_style)
+        {
+            m_out.put(sep);
+            m_out.write("\"font_style\":");
+            write_string(name_of(*t.m_font_style, font_styles));
+            sep = ',';
+        }
+        if(t.m_font_name)
+        {
+            m_out.put(sep);
+            m_out.write("\"font_name\":");
+            write_string(t.m_font_name->get_name());
+            sep = ',';
+        }
+        if(sep == '{')
+            m_out.put('{');
+        m_out.put('}');
+    };
+
+    // Sorted, so that the same document always gives the same output
+    std::vector<const style *> styles;
+    for(const auto &[name, s] : d.styles())
+        styles.push_back(&s);
+    std::sort(styles.begin(), styles.end(),
+        [](const style *a, const style *b) { return a->m_name.get_name() < b->m_name.get_name(); });
+
+    m_out.write("{\"docsmith\":");
+    m_out.write(format_number(version, buf));
+    m_out.write(",\"styles\":[");
+    for(const auto *s : styles)
+    {
+        if(s != styles.front())
+            m_out.put(',');
+        m_out.write("{\"name\":");
+        write_string(s->m_name.get_name());
+        if(!s->m_parent_style.is_empty())
+            write_member("parent", s->m_parent_style.get_name());
+        if(s->m_text_props)
+        {
+            m_out.write(",\"text\":");
+            text(*s->m_text_props);
+        }
+        if(const auto &p = s->m_paragraph_props)
+        {
+            m_out.write(",\"paragraph\":{");
+            if(p->m_break_before)
+            {
+                m_out.write("\"break_before\":");
+                write_string(name_of(p->m_break_before->m_break_type, breaks));
+            }
+            if(p->m_break_after)
+            {
+                m_out.write(p->m_break_before ? ",\"break_after\":" : "\"break_after\":");
+                write_string(name_of(p->m_break_after->m_break_type, breaks));
+            }
+            m_out.put('}');
+        }
+        if(const auto &g = s->m_graphics_props)
+        {
+            m_out.write(",\"graphics\":{");
+            if(g->m_horiz_pos)
+            {
+                m_out.write("\"horiz_pos\":");
+                write_string(name_of(*g->m_horiz_pos, horiz_positions));
+            }
+            if(g->m_vert_pos)
+            {
+                m_out.write(g->m_horiz_pos ? ",\"vert_pos\":" : "\"vert_pos\":");
+                write_string(name_of(*g->m_vert_pos, vert_positions));
+            }
+            m_out.put('}');
+        }
+        m_out.put('}');
+    }
+
+    std::vector<const list_style *> list_styles;
+    for(const auto &[name, ls] : d.list_styles())
+        list_styles.push_back(&ls);
+    std::sort(list_styles.begin(), list_styles.end(), [](const list_style *a, const list_style *b) {
+        return a->m_name.get_name() < b->m_name.get_name();
+    });
+
+    m_out.write("],\"list_styles\":[");
+    for(const auto *ls : list_styles)
+    {
+        if(ls != list_styles.front())
+            m_out.put(',');
+        m_out.write("{\"name\":");
+        write_string(ls->m_name.get_name());
+        m_out.write(",\"levels\":[");
+        bool first = true;
+        for(const auto &level : ls->m_level_styles)
+        {
+            if(!first)
+                m_out.put(',');
+            first = false;
+            std::visit(
+                [&](const auto &s) {
+                    m_out.write("{\"level\":");
+                    m_out.write(format_number(s.m_level, buf));
+                    write_style(s.m_style_name);
+                },
+                level);
+            if(const auto *b = std::get_if<list_style_bullet>(&level))
+                write_member("bullet", b->m_bullet_char);
+            else if(const auto *n = std::get_if<list_style_num>(&level))
+            {
+                char format = static_cast<char>(n->m_format);
+                write_member("format", {&format, 1});
+                if(!n->m_num_prefix.empty())
+                    write_member("prefix", n->m_num_prefix);
+                if(n->m_num_suffix != ".")
+                    write_member("suffix", n->m_num_suffix);
+                if(n->m_start_from != 1)
+                {
+                    m_out.write(",\"start\":");
+                    m_out.write(format_number(n->m_start_from, buf));
+                }
+                if(n->m_text_props)
+                {
+                    m_out.write(",\"text\":");
+                    text(*n->m_text_props);
+                }
+            }
+            m_out.put('}');
+        }
+        m_out.write("]}");
+    }
+    m_out.put(']');
+}
+
+void write_json(const element &e, output_buffer &out)
+{
+    json_writer writer(out);
+    e.accept(writer);
+}
+
+std::string to_json(const element &e)
+{
+    std::string r;
+    {
+        output_buffer out([&](const char *data, std::size_t size) { r.append(data, size); });
+        write_json(e, out);
+        out.flush();
+    }
+    return r;
+}
+
+text_doc read_json(std::string_view json) { return json_reader(json).read_doc(); }
+}
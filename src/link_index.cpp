@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include "docsmithcpp/link_index.h"
+#include "docsmithcpp/parallel.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+namespace
+{
+int hex_value(char c)
+{
+    if(c >= '0' && c <= '9')
+        return c - '0';
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+}
+
+template <typename Element>
+bool basic_link_index<Element>::parse_internal_url(std::string_view url, std::string &name)
+{
+    if(url.empty() || url.front() != '#' || url.find('|') != std::string_view::npos)
+        return false;
+
+    name.clear();
+    for(std::size_t i = 1; i < url.size(); ++i)
+    {
+        int hi, lo;
+        if(url[i] == '%' && i + 2 < url.size() && (hi = hex_value(url[i + 1])) >= 0 &&
+            (lo = hex_value(url[i + 2])) >= 0)
+        {
+            name += static_cast<char>(hi * 16 + lo);
+            i += 2;
+        }
+        else
+            name += url[i];
+    }
+    return true;
+}
+
+template <typename Element>
+void basic_link_index<Element>::build(Element &root)
+{
+    m_bookmarks.clear();
+    m_links.clear();
+    m_link_index.clear();
+    m_duplicates.clear();
+
+    collect(root);
+
+    // Links may point forwards, so resolve them once every bookmark is known
+    for(auto &l : m_links)
+        l.m_target = find_bookmark(l.m_name);
+}
+
+template <typename Element>
+void basic_link_index<Element>::collect(Element &e)
+{
+    if(e.is_type(elem_t::bookmark))
+    {
+        auto *b = dynamic_cast<bookmark_type *>(&e);
+        if(!m_bookmarks.try_emplace(b->m_name, b).second)
+            m_duplicates.push_back(b->m_name);
+    }
+    else if(e.is_type(elem_t::href))
+    {
+        auto *h = dynamic_cast<const_like_t<Element, hyperlink> *>(&e);
+        std::string name;
+        if(parse_internal_url(h->get_url(), name))
+        {
+            m_link_index.emplace(h, m_links.size());
+            m_links.push_back({h, std::move(name), nullptr});
+        }
+    }
+
+    if(auto *kids = e.child_list())
+        for(const auto &child : *kids)
+            collect(*child);
+}
+
+template <typename Element>
+typename basic_link_index<Element>::bookmark_type *basic_link_index<Element>::find_bookmark(
+    std::string_view name) const
+{
+    auto it = m_bookmarks.find(std::string(name));
+    return it == m_bookmarks.end() ? nullptr : it->second;
+}
+
+template <typename Element>
+typename basic_link_index<Element>::bookmark_type *basic_link_index<Element>::target(
+    const hyperlink &link) const
+{
+    auto it = m_link_index.find(&link);
+    return it == m_link_index.end() ? nullptr : m_links[it->second].m_target;
+}
+
+template <typename Element>
+std::vector<const typename basic_link_index<Element>::link_type *>
+basic_link_index<Element>::dangling() const
+{
+    std::vector<const link_type *> r;
+    for(const auto &l : m_links)
+        if(!l.m_target)
+            r.push_back(&l);
+    return r;
+}
+
+template class basic_link_index<element>;
+template class basic_link_index<const element>;
+
+std::vector<link_report> validate_links(const std::vector<element *> &roots, unsigned threads)
+{
+    std::vector<link_report> reports(roots.size());
+    parallel_for(roots.size(), threads,
+        [&]
+        {
+            return [&, index = const_link_index()](std::size_t i) mutable
+            {
+                index.build(*roots[i]);
+                for(const auto *l : index.dangling())
+                    reports[i].m_dangling.push_back(l->m_name);
+                reports[i].m_duplicates = index.duplicate_bookmarks();
+            };
+        });
+    return reports;
+}
+}
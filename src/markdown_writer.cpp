@@ -0,0 +1,337 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string_view>
+#include <variant>
+
+#include "docsmithcpp/markdown_writer.h"
+
+namespace docsmith
+{
+namespace
+{
+/// Characters escaped wherever they appear in text: those that start inline markup, and newlines
+constexpr auto special = [] {
+    std::array<bool, 256> r{};
+    for(unsigned char c : std::string_view("\\`*_[]<>#|&~\n"))
+        r[c] = true;
+    return r;
+}();
+
+bool is_italic(const style_registry &styles, const style_name &name)
+{
+    // Follow the parent chain, with a limit in case of a cycle
+    const auto *s = styles.find(name.get_name());
+    for(int depth = 0; s && depth < 16; ++depth)
+    {
+        if(s->m_text_props && s->m_text_props->m_font_style)
+            return *s->m_text_props->m_font_style != font_style::normal;
+        if(s->m_parent_style.is_empty())
+            break;
+        s = styles.find(s->m_parent_style.get_name());
+    }
+    return false;
+}
+}
+
+markdown_writer::markdown_writer(output_buffer &out) :
+    m_out(out)
+{
+}
+
+void markdown_writer::visit(const text_doc &d)
+{
+    m_doc = &d;
+    m_next = open_t::other;
+}
+
+void markdown_writer::visit(const heading &h)
+{
+    if(m_block_depth > 0)
+    {
+        m_next = open_t::other;
+        return;
+    }
+    begin_block();
+    for(int i = 0; i < std::clamp(h.level(), 1, 6); ++i)
+        m_out.put('#');
+    m_out.put(' ');
+    m_line_start = false;
+    m_next = open_t::block;
+}
+
+void markdown_writer::visit(const paragraph &p)
+{
+    if(m_block_depth > 0)
+    {
+        m_next = open_t::other;
+        return;
+    }
+    begin_block();
+    m_next = open_t::block;
+}
+
+void markdown_writer::visit(const span &s)
+{
+    m_next = open_t::other;
+    if(m_doc && !s.get_style().is_empty() && is_italic(m_doc->styles(), s.get_style()))
+    {
+        m_out.put('*');
+        m_line_start = false;
+        m_next = open_t::emphasis;
+    }
+}
+
+void markdown_writer::visit(const hyperlink &href)
+{
+    m_out.put('[');
+    m_line_start = false;
+    m_links.push_back(&href);
+    m_next = open_t::link;
+}
+
+void markdown_writer::visit(const text &t) { write_escaped(t.m_text); }
+
+void markdown_writer::visit(const list &l)
+{
+    list_level level;
+    if(!m_lists.empty())
+    {
+        level.m_style = m_lists.back().m_style;
+        level.m_indent = m_lists.back().m_content;
+    }
+    if(m_doc && !l.get_style().is_empty())
+        level.m_style = m_doc->list_styles().find(l.get_style().get_name());
+
+    if(level.m_style)
+    {
+        auto depth = static_cast<int>(m_lists.size()) + 1;
+        for(const auto &ls : level.m_style->m_level_styles)
+        {
+            const auto *num = std::get_if<list_style_num>(&ls);
+            if(std::visit([](const auto &s) { return s.m_level; }, ls) != depth)
+                continue;
+            if(num)
+            {
+                level.m_numbered = true;
+                level.m_next = num->m_start_from;
+                level.m_delim = num->m_num_suffix == ")" ? ')' : '.';
+            }
+            break;
+        }
+    }
+
+    // A list needs a blank line before it at the top level, and an ordered list only
+    // interrupts a paragraph if it starts from 1
+    if(m_lists.empty() ? m_out.size() > 0
+                       : level.m_numbered && level.m_next != 1 && !m_lists.back().m_marker_pending)
+        m_out.put('\n');
+
+    m_lists.push_back(level);
+    m_next = open_t::list;
+}
+
+void markdown_writer::visit(const list_item &li)
+{
+    m_next = open_t::other;
+    if(m_lists.empty())
+        return;
+    m_lists.back().m_marker_pending = true;
+    m_next = open_t::item;
+}
+
+void markdown_writer::visit(const frame &) { m_next = open_t::other; }
+
+void markdown_writer::visit(const image &i)
+{
+    bool own_line = m_block_depth == 0;
+    if(own_line)
+        begin_block();
+    m_out.write("![](");
+    write_url(i.get_uri());
+    m_out.put(')');
+    m_line_start = false;
+    if(own_line)
+        m_out.put('\n');
+}
+
+void markdown_writer::push() { m_open.push_back(m_next); }
+
+void markdown_writer::pop()
+{
+    auto kind = m_open.back();
+    m_open.pop_back();
+    switch(kind)
+    {
+    case open_t::block:
+        --m_block_depth;
+        m_out.put('\n');
+        break;
+    case open_t::list:
+        m_lists.pop_back();
+        break;
+    case open_t::item:
+        // An item without blocks still gets its marker, so the numbering stays right
+        if(m_lists.back().m_marker_pending)
+        {
+            write_marker(m_lists.back());
+            m_out.put('\n');
+        }
+        break;
+    case open_t::link:
+        m_out.write("](");
+        write_url(m_links.back()->get_url());
+        m_out.put(')');
+        m_links.pop_back();
+        break;
+    case open_t::emphasis:
+        m_out.put('*');
+        break;
+    case open_t::other:
+        break;
+    }
+}
+
+void markdown_writer::begin_block()
+{
+    if(m_lists.empty())
+    {
+        if(m_out.size() > 0)
+            m_out.put('\n');
+    }
+    else if(auto &l = m_lists.back(); l.m_marker_pending)
+        write_marker(l);
+    else
+    {
+        // A further block in the same item
+        m_out.put('\n');
+        write_indent(l.m_content);
+    }
+    ++m_block_depth;
+    m_line_start = true;
+}
+
+void markdown_writer::write_indent(std::size_t columns)
+{
+    constexpr std::string_view spaces = "                                ";
+    for(; columns > spaces.size(); columns -= spaces.size())
+        m_out.write(spaces);
+    m_out.write(spaces.substr(0, columns));
+}
+
+void markdown_writer::write_marker(list_level &l)
+{
+    write_indent(l.m_indent);
+    std::array<char, 16> marker;
+    auto *end = marker.data();
+    if(l.m_numbered)
+    {
+        end = std::to_chars(marker.data(), marker.data() + 12, l.m_next++).ptr;
+        *end++ = l.m_delim;
+    }
+    else
+        *end++ = '-';
+    *end++ = ' ';
+    auto len = static_cast<std::size_t>(end - marker.data());
+    m_out.write({marker.data(), len});
+    l.m_content = l.m_indent + len;
+    l.m_marker_pending = false;
+}
+
+void markdown_writer::write_escaped(std::string_view s)
+{
+    if(m_line_start)
+    {
+        // Leading whitespace is insignificant, or worse starts a code block
+        while(!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+            s.remove_prefix(1);
+        if(s.empty())
+            return;
+        m_line_start = false;
+
+        // Text that would read as a list marker or thematic break
+        if(s.front() == '-' || s.front() == '+')
+            m_out.put('\\');
+        auto digits = s.find_first_not_of("0123456789");
+        if(digits > 0 && digits < 10 && digits != std::string_view::npos &&
+            (s[digits] == '.' || s[digits] == ')'))
+        {
+            m_out.write(s.substr(0, digits));
+            m_out.put('\\');
+            s.remove_prefix(digits);
+        }
+    }
+
+    std::size_t from = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        if(!special[static_cast<unsigned char>(s[i])])
+            continue;
+        m_out.write(s.substr(from, i - from));
+        m_out.put('\\');
+        if(s[i] == '\n')
+        {
+            // A hard line break, continued at the indent of the enclosing list item
+            m_out.put('\n');
+            write_indent(m_lists.empty() ? 0 : m_lists.back().m_content);
+        }
+        else
+            m_out.put(s[i]);
+        from = i + 1;
+    }
+    m_out.write(s.substr(from));
+}
+
+void markdown_writer::write_url(std::string_view url)
+{
+    // Destinations with spaces or parentheses must be in angle brackets, which can't contain
+    // angle brackets themselves
+    if(url.find_first_of(" ()<>") == std::string_view::npos)
+        return m_out.write(url);
+    m_out.put('<');
+    for(char c : url)
+    {
+        if(c == '<')
+            m_out.write("%3C");
+        else if(c == '>')
+            m_out.write("%3E");
+        else
+            m_out.put(c);
+    }
+    m_out.put('>');
+}
+
+void write_markdown(const element &e, output_buffer &out)
+{
+    markdown_writer writer(out);
+    e.accept(writer);
+}
+
+std::string to_markdown(const element &e)
+{
+    std::string r;
+    {
+        output_buffer out([&](const char *data, std::size_t size) { r.append(data, size); });
+        write_markdown(e, out);
+        out.flush();
+    }
+    return r;
+}
+}
@@ -16,12 +16,20 @@
  * limitations under the License.
  *****************************************************************************/
 
+#include "docsmithcpp/handle.h"
 #include "docsmithcpp/nodes.h"
 #include "docsmithcpp/text.h"
 
 namespace docsmith
 {
 
+element::~element()
+{
+    if(m_handle)
+        if(auto table = m_handle->m_table.lock())
+            table->release(m_handle->m_index);
+}
+
 void add_text(std::list<std::unique_ptr<element>> &dest, std::string t)
 {
     dest.emplace_back(std::make_unique<text>(t));
@@ -15,6 +15,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *****************************************************************************/
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
 #include <iostream>
 #include <map>
 #include <optional>
@@ -59,7 +62,7 @@ heading make_heading(pugi::xml_node &node)
 {
     int level = node.attribute("text:outline-level").as_int();
     style_name sn(node.attribute("text:style-name").as_string());
-    return heading(level);
+    return heading(level).set_style(sn);
 }
 
 list make_list(pugi::xml_node &node)
@@ -78,9 +81,23 @@ frame make_frame(pugi::xml_node &node)
 
 image make_image(pugi::xml_node &node)
 {
+    std::string uri(node.attribute("xlink:href").as_string());
+    if(auto data = node.child("office:binary-data"); uri.empty() && data)
+    {
+        // Embedded in a Flat ODT, kept as a data URI:
+        uri = "data:";
+        uri += node.attribute("draw:mime-type").as_string("application/octet-stream");
+        uri += ";base64,";
+        for(const char *c = data.child_value(); *c; ++c)
+            if(!std::isspace(static_cast<unsigned char>(*c)))
+                uri += *c;
+    }
+    return image(uri);
+}
 
-    image i(node.attribute("xlink:href").as_string());
-    return i;
+bookmark make_bookmark(pugi::xml_node &node)
+{
+    return bookmark(node.attribute("text:name").as_string());
 }
 
 template <typename T>
@@ -99,11 +116,25 @@ block_factory factory = {
     {"text:list-item", wrap_factory<list_item>(make_list_item)},
     {"draw:frame", wrap_factory<frame>(make_frame)},
     {"draw:image", wrap_factory<image>(make_image)},
+    {"text:bookmark", wrap_factory<bookmark>(make_bookmark)},
+    {"text:bookmark-start", wrap_factory<bookmark>(make_bookmark)},
 };
 }
 
+namespace
+{
+/// Flat ODT is chosen by the extension of the filename
+bool is_flat(const std::string &filename)
+{
+    auto extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".fodt";
+}
+}
+
 odt_file::odt_file(const std::string &filename) :
-    m_filename(filename)
+    m_filename(filename), m_flat(is_flat(filename))
 {
 }
 const char *node_types[] = {
@@ -122,7 +153,8 @@ struct parser
             handle_node(child);
         }
     }
-    text_doc get() { return m_doc; }
+    /// Hand over the parsed tree. The parser is done with it, so it is moved rather than copied.
+    text_doc get() { return std::move(m_doc); }
 
 private:
     void handle_node(pugi::xml_node &node)
@@ -171,6 +203,20 @@ private:
 
 text_doc odt_file::parse_text_doc()
 {
+    if(m_flat)
+    {
+        // The whole document is one XML file, read without inflating anything:
+        auto xml = std::make_shared<pugi::xml_document>();
+        if(!xml->load_file(m_filename.c_str()))
+            throw std::runtime_error("Failed to parse " + m_filename);
+
+        auto doc_node = xml->child("office:document").child("office:body").child("office:text");
+        parser p(odt::factory);
+        p.traverse(doc_node);
+        m_source_content = std::move(xml);
+        return p.get();
+    }
+
     libzippp::ZipArchive zip(m_filename);
     if(!zip.open(libzippp::ZipArchive::ReadOnly))
         throw std::runtime_error("Could not open archive");
@@ -182,22 +228,71 @@ text_doc odt_file::parse_text_doc()
 
     auto content_xml = content.readAsText();
 
-    pugi::xml_document xml;
-    if(!xml.load_string(content_xml.c_str()))
+    auto xml = std::make_shared<pugi::xml_document>();
+    if(!xml->load_string(content_xml.c_str()))
         throw std::runtime_error("Failed to parse the content.xml");
 
-    auto doc_node = xml.child("office:document-content").child("office:body").child("office:text");
+    auto doc_node = xml->child("office:document-content").child("office:body").child("office:text");
 
     doc_node.children();
 
     parser p(odt::factory);
     p.traverse(doc_node);
 
+    // Keep the source content.xml so that save_update can preserve its automatic styles:
+    m_source_content = std::move(xml);
+
     return p.get();
 }
 
 void odt_file::save(const text_doc &doc)
 {
-    odt::writer::write(doc, m_filename);
+    if(m_flat)
+        odt::writer::write_flat(doc, m_filename);
+    else
+        odt::writer::write(doc, m_filename);
+}
+
+std::future<void> odt_file::async_save(const text_doc &doc)
+{
+    if(m_flat)
+    {
+        // Nothing is compressed, so there is no pipeline to overlap with printing:
+        return std::async(std::launch::async,
+            [&doc, filename = m_filename] { odt::writer::write_flat(doc, filename); });
+    }
+    return odt::writer::write_async(doc, m_filename);
+}
+
+void odt_file::save_update(const text_doc &doc) { save_update(doc, m_filename); }
+
+void odt_file::save_update(const text_doc &doc, const std::string &filename)
+{
+    namespace fs = std::filesystem;
+    if(!fs::exists(m_filename))
+        throw std::runtime_error("Cannot update " + m_filename + ", it does not exist");
+
+    if(m_flat)
+    {
+        // Everything but the body is kept from the source document, read now if it wasn't parsed
+        auto source = m_source_content;
+        if(!source)
+        {
+            source = std::make_shared<pugi::xml_document>();
+            if(!source->load_file(m_filename.c_str()))
+                throw std::runtime_error("Failed to parse " + m_filename);
+        }
+        odt::writer::write_flat(doc, filename, source.get());
+        return;
+    }
+
+    if(!fs::exists(filename) || !fs::equivalent(m_filename, filename))
+    {
+        fs::path parent_path = fs::path(filename).parent_path();
+        if(!parent_path.empty() && !fs::exists(parent_path))
+            fs::create_directories(parent_path);
+        fs::copy_file(m_filename, filename, fs::copy_options::overwrite_existing);
+    }
+    odt::writer::update(doc, filename, m_source_content.get());
 }
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "docsmithcpp/archive_reader.h"
+#include "docsmithcpp/docx/document_writer.h"
+#include "docsmithcpp/odt/to_docx.h"
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/xml_parser.h"
+
+namespace docsmith::odt
+{
+namespace
+{
+int to_int(std::string_view s, int fallback)
+{
+    int v = fallback;
+    std::from_chars(s.data(), s.data() + s.size(), v);
+    return v;
+}
+
+/// An ODF length such as "2.5cm" in points, or nothing if it has no absolute unit
+std::optional<double> to_points(std::string_view length)
+{
+    double v = 0;
+    auto [end, ec] = std::from_chars(length.data(), length.data() + length.size(), v);
+    if(ec != std::errc{})
+        return std::nullopt;
+    std::string_view unit(end, static_cast<std::size_t>(length.data() + length.size() - end));
+    if(unit == "pt")
+        return v;
+    if(unit == "in")
+        return v * 72;
+    if(unit == "cm")
+        return v * 72 / 2.54;
+    if(unit == "mm")
+        return v * 72 / 25.4;
+    if(unit == "pc")
+        return v * 12;
+    if(unit == "px")
+        return v * 0.75;
+    return std::nullopt;
+}
+
+std::optional<break_type> to_break_type(std::string_view s)
+{
+    if(s == "page")
+        return break_type::page;
+    if(s == "column")
+        return break_type::column;
+    if(s == "even-page")
+        return break_type::even_page;
+    if(s == "odd-page")
+        return break_type::odd_page;
+    if(s == "auto")
+        return break_type::automatic;
+    return std::nullopt;
+}
+
+/// Prints the body of content.xml through a document_writer as its events arrive, and reads the
+/// styles and list styles of either styles.xml or content.xml into registries on the way.
+class content_handler : public xml_handler
+{
+public:
+    content_handler(
+        docx::document_writer &out, style_registry &styles, list_style_registry &list_styles) :
+        m_out(out),
+        m_styles(styles),
+        m_list_styles(list_styles)
+    {
+    }
+
+    void start_element(std::string_view name, std::span<const xml_attribute> attributes) override;
+    void end_element(std::string_view name) override;
+    void characters(std::string_view text) override;
+
+private:
+    enum class open_t : char
+    {
+        other,
+        body,
+        style,
+        list_style,
+        block,
+        span,
+        hyperlink,
+        list
+    };
+
+    void start_body_element(std::string_view name, std::span<const xml_attribute> attributes);
+    void read_style_properties(std::string_view name, std::span<const xml_attribute> attributes);
+    void read_list_level(std::string_view name, std::span<const xml_attribute> attributes);
+
+    /// Print the text gathered since the last element as one run
+    void flush_text();
+
+    docx::document_writer &m_out;
+    style_registry &m_styles;
+    list_style_registry &m_list_styles;
+
+    std::vector<open_t> m_open;             //!< Each open element outside skipped content
+    int m_skipped{0};                       //!< Depth within content which is dropped
+    bool m_in_body{false};                  //!< Within office:text
+    int m_blocks{0};                        //!< Open paragraphs and headings
+    std::optional<style> m_style;           //!< The style:style being read
+    std::optional<list_style> m_list_style; //!< The text:list-style being read
+    docx::extent m_frame{docx::default_image_extent}; //!< Size of the innermost draw:frame
+    std::string m_text;                     //!< Text of the current run
+};
+
+void content_handler::start_element(
+    std::string_view name, std::span<const xml_attribute> attributes)
+{
+    if(m_skipped > 0)
+    {
+        ++m_skipped;
+        return;
+    }
+
+    // Spaces, tabs and line breaks are part of the run around them:
+    if(m_in_body && m_blocks > 0)
+    {
+        if(name == "text:s")
+        {
+            m_text.append(static_cast<std::size_t>(
+                              std::max(to_int(find_attribute(attributes, "text:c"), 1), 1)),
+                ' ');
+            m_open.push_back(open_t::other);
+            return;
+        }
+        if(name == "text:tab" || name == "text:line-break")
+        {
+            m_text += name == "text:tab" ? '\t' : '\n';
+            m_open.push_back(open_t::other);
+            return;
+        }
+    }
+    flush_text();
+
+    if(name == "style:style")
+    {
+        auto family = find_attribute(attributes, "style:family");
+        if(family == "paragraph" || family == "text")
+        {
+            m_style.emplace(style_name(std::string(find_attribute(attributes, "style:name"))));
+            m_style->m_parent_style =
+                style_name(std::string(find_attribute(attributes, "style:parent-style-name")));
+            m_open.push_back(open_t::style);
+            return;
+        }
+    }
+    else if(name == "text:list-style")
+    {
+        m_list_style.emplace(
+            list_style(style_name(std::string(find_attribute(attributes, "style:name"))), {}));
+        m_open.push_back(open_t::list_style);
+        return;
+    }
+    else if(m_style)
+        read_style_properties(name, attributes);
+    else if(m_list_style)
+        read_list_level(name, attributes);
+    else if(name == "office:text")
+    {
+        m_in_body = true;
+        m_open.push_back(open_t::body);
+        return;
+    }
+    else if(m_in_body)
+    {
+        start_body_element(name, attributes);
+        return;
+    }
+    m_open.push_back(open_t::other);
+}
+
+void content_handler::start_body_element(
+    std::string_view name, std::span<const xml_attribute> attributes)
+{
+    auto style = [&] { return find_attribute(attributes, "text:style-name"); };
+    auto kind = open_t::other;
+
+    if(name == "text:p")
+    {
+        m_out.begin_block(style());
+        ++m_blocks;
+        kind = open_t::block;
+    }
+    else if(name == "text:h")
+    {
+        m_out.begin_block(style(), to_int(find_attribute(attributes, "text:outline-level"), 1) - 1);
+        ++m_blocks;
+        kind = open_t::block;
+    }
+    else if(name == "text:span")
+    {
+        m_out.begin_span(style());
+        kind = open_t::span;
+    }
+    else if(name == "text:a")
+    {
+        m_out.begin_hyperlink(find_attribute(attributes, "xlink:href"));
+        kind = open_t::hyperlink;
+    }
+    else if(name == "text:list")
+    {
+        // Only the outermost list's style is used, see document_writer::begin_list
+        auto s = style();
+        m_out.begin_list(s.empty() ? nullptr : m_list_styles.find(std::string(s)));
+        kind = open_t::list;
+    }
+    else if(name == "text:list-item" || name == "text:list-header")
+        m_out.begin_item();
+    else if(name == "text:bookmark" || name == "text:bookmark-start")
+        m_out.bookmark(find_attribute(attributes, "text:name"));
+    else if(name == "draw:frame")
+    {
+        auto cx = to_points(find_attribute(attributes, "svg:width"));
+        auto cy = to_points(find_attribute(attributes, "svg:height"));
+        m_frame = cx && cy && *cx > 0 && *cy > 0
+                      ? docx::extent{std::llround(*cx * 12700), std::llround(*cy * 12700)}
+                      : docx::default_image_extent;
+    }
+    else if(name == "draw:image")
+    {
+        // Pictures embedded as office:binary-data have no part to copy, so they are dropped
+        auto href = find_attribute(attributes, "xlink:href");
+        if(!href.empty())
+            m_out.image(std::string(href.starts_with("./") ? href.substr(2) : href), m_frame);
+    }
+    else if(name == "office:annotation" || name == "text:note" || name == "text:tracked-changes")
+    {
+        m_skipped = 1;
+        return;
+    }
+    m_open.push_back(kind);
+}
+
+void content_handler::read_style_properties(
+    std::string_view name, std::span<const xml_attribute> attributes)
+{
+    if(name == "style:text-properties")
+    {
+        text_props props;
+        if(auto size = to_points(find_attribute(attributes, "fo:font-size")))
+            props.set(font_size(static_cast<float>(*size)));
+        auto slant = find_attribute(attributes, "fo:font-style");
+        if(slant == "italic")
+            props.set(font_style::italic);
+        else if(slant == "oblique")
+            props.set(font_style::oblique);
+        else if(slant == "normal")
+            props.set(font_style::normal);
+        if(auto font = find_attribute(attributes, "style:font-name"); !font.empty())
+            props.set(font_name(std::string(font)));
+        if(props.m_font_size || props.m_font_style || props.m_font_name)
+            m_style->set(props);
+    }
+    else if(name == "style:paragraph-properties")
+    {
+        paragraph_props props;
+        if(auto b = to_break_type(find_attribute(attributes, "fo:break-before")))
+            props.set(break_before{*b});
+        if(auto b = to_break_type(find_attribute(attributes, "fo:break-after")))
+            props.set(break_after{*b});
+        if(props.m_break_before || props.m_break_after)
+            m_style->set(props);
+    }
+}
+
+void content_handler::read_list_level(
+    std::string_view name, std::span<const xml_attribute> attributes)
+{
+    auto level = to_int(find_attribute(attributes, "text:level"), 1);
+    style text_style{style_name(std::string(find_attribute(attributes, "text:style-name")))};
+
+    if(name == "text:list-level-style-bullet")
+    {
+        m_list_style->m_level_styles.push_back(list_style_bullet(
+            text_style, level, std::string(find_attribute(attributes, "text:bullet-char", "•"))));
+    }
+    else if(name == "text:list-level-style-number")
+    {
+        constexpr std::string_view formats = "1aAiI";
+        auto format = find_attribute(attributes, "style:num-format");
+        if(format.size() != 1 || formats.find(format[0]) == std::string_view::npos)
+        {
+            // Unnumbered levels (num-format="") are written as bullets without a bullet
+            m_list_style->m_level_styles.push_back(list_style_bullet(text_style, level, ""));
+            return;
+        }
+        m_list_style->m_level_styles.push_back(list_style_num(text_style, level,
+            static_cast<list_enum>(format[0]),
+            std::string(find_attribute(attributes, "style:num-suffix")),
+            to_int(find_attribute(attributes, "text:start-value"), 1),
+            std::string(find_attribute(attributes, "style:num-prefix"))));
+    }
+}
+
+void content_handler::end_element(std::string_view)
+{
+    if(m_skipped > 0)
+    {
+        --m_skipped;
+        return;
+    }
+    auto closed = m_open.back();
+    m_open.pop_back();
+    if(closed != open_t::other)
+        flush_text();
+
+    switch(closed)
+    {
+    case open_t::body: m_in_body = false; break;
+    case open_t::style:
+        m_styles.add(*m_style);
+        m_style.reset();
+        break;
+    case open_t::list_style:
+        m_list_styles.add(*m_list_style);
+        m_list_style.reset();
+        break;
+    case open_t::block:
+        m_out.end_block();
+        --m_blocks;
+        break;
+    case open_t::span: m_out.end_span(); break;
+    case open_t::hyperlink: m_out.end_hyperlink(); break;
+    case open_t::list: m_out.end_list(); break;
+    case open_t::other: break;
+    }
+}
+
+void content_handler::characters(std::string_view text)
+{
+    if(m_skipped == 0 && m_in_body && m_blocks > 0)
+        m_text += text;
+}
+
+void content_handler::flush_text()
+{
+    if(m_text.empty())
+        return;
+    m_out.text(m_text);
+    m_text.clear();
+}
+
+/// Parse a part as it streams in. Returns false if there is no such part.
+bool parse_part(const docx::part_reader &parts, const std::string &name, xml_handler &handler)
+{
+    xml_parser parser(handler);
+    if(!parts(name, [&](const char *data, std::size_t size) { parser.feed({data, size}); }))
+        return false;
+    parser.finish();
+    return true;
+}
+}
+
+void convert_to_docx(const docx::part_reader &odt_parts, zip_writer &zip, bool pipelined)
+{
+    docx::document_writer out;
+    style_registry styles;
+    list_style_registry list_styles;
+
+    // Common styles and list styles come first, so that the body can refer to them:
+    content_handler style_handler(out, styles, list_styles);
+    parse_part(odt_parts, "styles.xml", style_handler);
+
+    docx::document_writer::begin_package(zip);
+    auto print = [&](const byte_sink &sink)
+    {
+        output_buffer buffer(sink);
+        out.begin_document(buffer);
+        content_handler handler(out, styles, list_styles);
+        if(!parse_part(odt_parts, "content.xml", handler))
+            throw std::runtime_error("Missing content.xml");
+        out.end_document();
+        buffer.flush();
+    };
+    if(pipelined)
+    {
+        // Inflating, parsing and printing on one thread, deflating on another:
+        zip.add_pipelined("word/document.xml", print);
+    }
+    else
+    {
+        zip.begin_entry("word/document.xml");
+        print([&zip](const char *data, std::size_t size) { zip.write(data, size); });
+        zip.end_entry();
+    }
+
+    out.end_package(zip, styles, odt_parts);
+}
+
+void convert_to_docx(
+    const std::string &odt_filename, const std::string &docx_filename, bool pipelined)
+{
+    archive_reader odt(odt_filename);
+    write_zip(docx_filename,
+        [&odt, pipelined](zip_writer &zip)
+        {
+            convert_to_docx([&odt](const std::string &name, const byte_sink &sink)
+                { return odt.read(name, sink); },
+                zip, pipelined);
+        });
+}
+}
@@ -17,9 +17,13 @@
  *****************************************************************************/
 #include <filesystem>
 #include <fmt/format.h>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 
+#include "docsmithcpp/base64.h"
 #include "docsmithcpp/iostream_writer.h"
 #include "docsmithcpp/odt/writer.h"
 #include "docsmithcpp/text_doc.h"
@@ -43,9 +47,9 @@ std::string to_string(font_weight fw);
 std::string to_string(text_align ta);
 std::string to_string(break_type b);
 
-writer::writer(std::string filename)
+namespace
 {
-    std::string odt_base_content{R"~~(
+const char *odt_base_content{R"~~(
 <?xml version="1.0" encoding="UTF-8"?>
 <office:document-content
     xmlns:draw="urn:oasis:names:tc:opendocument:xmlns:drawing:1.0"
@@ -67,76 +71,351 @@ writer::writer(std::string filename)
 </office:document-content>
 )~~"};
 
-    m_content.load_string(odt_base_content.c_str());
-
-    auto find_node = [this](std::string name)
-    {
-        return m_content.find_node([name](const pugi::xml_node &node) { //
-            return std::string(node.name()) == name;
-        });
-    };
-
-    auto office_body = find_node("office:body");
-    m_node_stack.push(office_body);
-    m_current = m_node_stack.top();
-    m_automatic_styles = find_node("office:automatic-styles");
-    m_styles = find_node("office:styles");
-
-    std::string manifest_xml{R"(
+const char *odt_base_manifest{R"(
 <?xml version="1.0" encoding="UTF-8"?>
 <manifest:manifest xmlns:manifest="urn:oasis:names:tc:opendocument:xmlns:manifest:1.0" manifest:version="1.2">
   <manifest:file-entry manifest:media-type="application/vnd.oasis.opendocument.text" manifest:full-path="/"/>
   <manifest:file-entry manifest:media-type="text/xml" manifest:full-path="content.xml"/>
+  <manifest:file-entry manifest:media-type="text/xml" manifest:full-path="styles.xml"/>
+  <manifest:file-entry manifest:media-type="text/xml" manifest:full-path="meta.xml"/>
 </manifest:manifest>)"};
 
-    m_manifest.load_string(manifest_xml.c_str());
-    m_manifest_files_node = m_manifest.root().child("manifest:manifest");
+const char *odt_mimetype{"application/vnd.oasis.opendocument.text"};
+
+const char *fodt_base_document{R"~~(
+<?xml version="1.0" encoding="UTF-8"?>
+<office:document
+    xmlns:draw="urn:oasis:names:tc:opendocument:xmlns:drawing:1.0"
+    xmlns:office="urn:oasis:names:tc:opendocument:xmlns:office:1.0"
+    xmlns:table="urn:oasis:names:tc:opendocument:xmlns:table:1.0"
+    xmlns:text="urn:oasis:names:tc:opendocument:xmlns:text:1.0"
+    xmlns:style="urn:oasis:names:tc:opendocument:xmlns:style:1.0"
+    xmlns:svg="urn:oasis:names:tc:opendocument:xmlns:svg-compatible:1.0"
+    xmlns:fo="urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0"
+    xmlns:dc="http://purl.org/dc/elements/1.1/"
+    xmlns:meta="urn:oasis:names:tc:opendocument:xmlns:meta:1.0"
+    xmlns:xlink="http://www.w3.org/1999/xlink"
+    xmlns:loext="urn:org:documentfoundation:names:experimental:office:xmlns:loext:1.0"
+    office:version="1.2"
+    office:mimetype="application/vnd.oasis.opendocument.text">
+    <office:meta>
+        <meta:generator>DocSmithCpp</meta:generator>
+    </office:meta>
+    <office:styles>
+    </office:styles>
+    <office:automatic-styles>
+    </office:automatic-styles>
+    <office:body>
+    </office:body>
+</office:document>
+)~~"};
+
+const char *odt_base_styles{R"(<?xml version="1.0" encoding="UTF-8"?>
+<office:document-styles xmlns:office="urn:oasis:names:tc:opendocument:xmlns:office:1.0" office:version="1.2">
+  <office:styles/>
+</office:document-styles>
+)"};
+
+const char *odt_base_meta{R"(<?xml version="1.0" encoding="UTF-8"?>
+<office:document-meta xmlns:office="urn:oasis:names:tc:opendocument:xmlns:office:1.0" xmlns:meta="urn:oasis:names:tc:opendocument:xmlns:meta:1.0" office:version="1.2">
+  <office:meta>
+    <meta:generator>DocSmithCpp</meta:generator>
+  </office:meta>
+</office:document-meta>
+)"};
+
+/// Parse an XML template once. The result is shared read-only by all writers, which copy it with
+/// xml_document::reset instead of parsing the text again.
+std::unique_ptr<pugi::xml_document> parse_skeleton(const char *xml)
+{
+    auto doc = std::make_unique<pugi::xml_document>();
+    if(!doc->load_string(xml))
+        throw std::logic_error("Failed to parse the odt writer skeleton");
+    return doc;
+}
+
+const pugi::xml_document &content_skeleton()
+{
+    static const auto skeleton = parse_skeleton(odt_base_content);
+    return *skeleton;
+}
+
+const pugi::xml_document &flat_skeleton()
+{
+    static const auto skeleton = parse_skeleton(fodt_base_document);
+    return *skeleton;
+}
+
+const pugi::xml_document &manifest_skeleton()
+{
+    static const auto skeleton = parse_skeleton(odt_base_manifest);
+    return *skeleton;
+}
+
+/// Forwards pugixml output to a byte_sink, such as the open entry of a zip_writer
+class sink_xml_writer : public pugi::xml_writer
+{
+public:
+    explicit sink_xml_writer(byte_sink sink) :
+        m_sink(std::move(sink))
+    {
+    }
+    void write(const void *data, size_t size) override
+    {
+        m_sink(static_cast<const char *>(data), size);
+    }
+
+private:
+    byte_sink m_sink;
+};
+
+/// Archive parts which are identical for every document. They are compressed and their CRCs
+/// computed once, then copied verbatim into each archive.
+struct static_parts
+{
+    zip_entry m_mimetype;
+    zip_entry m_styles;
+    zip_entry m_meta;
+    zip_entry m_manifest; //!< Manifest for documents without pictures
+};
+
+const static_parts &cached_parts()
+{
+    static const static_parts parts = []
+    {
+        std::ostringstream manifest_stream;
+        manifest_skeleton().print(manifest_stream);
+
+        return static_parts{make_zip_entry("mimetype", odt_mimetype, zip_method::store),
+            make_zip_entry("styles.xml", odt_base_styles),
+            make_zip_entry("meta.xml", odt_base_meta),
+            make_zip_entry("META-INF/manifest.xml", manifest_stream.str())};
+    }();
+    return parts;
+}
+}
+
+writer::writer(std::string filename, const pugi::xml_document *base_content, bool flat) :
+    m_flat(flat), m_update(base_content != nullptr)
+{
+    m_content.reset(base_content ? *base_content : flat ? flat_skeleton() : content_skeleton());
+
+    // The skeleton layout is fixed, so walk straight to the nodes rather than searching for them.
+    // The root is office:document-content, or office:document for Flat ODT:
+    auto document_content = m_content.document_element();
+    auto office_body = document_content.child("office:body");
+    m_automatic_styles = document_content.child("office:automatic-styles");
+    m_styles = document_content.child("office:styles");
+
+    if(base_content)
+    {
+        // A parsed content.xml need not have every node the skeleton has:
+        if(!office_body)
+            office_body = document_content.append_child("office:body");
+        if(!m_automatic_styles)
+            m_automatic_styles = document_content.insert_child_before(
+                "office:automatic-styles", office_body);
+        if(!m_styles)
+            m_styles = document_content.insert_child_before("office:styles", m_automatic_styles);
+
+        // The body is regenerated from the document:
+        office_body.remove_children();
+    }
+    m_node_stack.push(office_body);
+    m_current = m_node_stack.top();
+
+    m_manifest.reset(manifest_skeleton());
+    m_manifest_files_node = m_manifest.child("manifest:manifest");
 }
 
 void writer::write(const text_doc &doc, const std::string &filename)
 {
-    writer w(filename);
+    write_zip(filename,
+        [&doc](zip_writer &zip)
+        {
+            writer w(std::string{});
+            w.write_archive(zip, doc, false);
+        });
+}
 
-    fs::path parent_path = fs::path(filename).parent_path();
-    if(!parent_path.empty() && !fs::exists(parent_path))
-        fs::create_directories(parent_path);
+void writer::write(const text_doc &doc, std::ostream &os)
+{
+    write_zip(os,
+        [&doc](zip_writer &zip)
+        {
+            writer w(std::string{});
+            w.write_archive(zip, doc, false);
+        });
+}
+
+std::vector<std::byte> writer::write(const text_doc &doc)
+{
+    return write_zip(
+        [&doc](zip_writer &zip)
+        {
+            writer w(std::string{});
+            w.write_archive(zip, doc, false);
+        });
+}
+
+std::future<void> writer::write_async(const text_doc &doc, const std::string &filename)
+{
+    return std::async(std::launch::async,
+        [&doc, filename]
+        {
+            write_zip(filename,
+                [&](zip_writer &zip)
+                {
+                    writer w(filename);
+                    w.write_archive(zip, doc, true);
+                });
+        });
+}
 
+void writer::update(
+    const text_doc &doc, const std::string &filename, const pugi::xml_document *base_content)
+{
+    writer w(filename, base_content);
     doc.accept(w);
-    std::string content_xml, manifest_xml;
 
     lzpp::ZipArchive zip(filename);
-    if(!zip.open(lzpp::ZipArchive::New))
-        throw std::runtime_error("Unable to create odt zip archive for writing");
-
-    // Add the mimetype, must be uncompressed and first:
-    zip.setCompressionMethod(lzpp::CompressionMethod::STORE);
-    std::string m_mimetype = std::string{"application/vnd.oasis.opendocument.text"};
-    if(!zip.addData("mimetype", m_mimetype.data(), m_mimetype.length()))
-        throw std::runtime_error("Could not create mimetype");
+    if(!zip.open(lzpp::ZipArchive::Write))
+        throw std::runtime_error("Unable to open odt zip archive for updating");
 
-    // Add the content.xml:
+    // libzippp reads added data when the archive is closed, so it must outlive zip.close():
     std::ostringstream content_stream;
     w.m_content.print(content_stream, "  ");
-    content_xml = content_stream.str();
-    zip.addData("content.xml", content_xml.data(), content_xml.size());
-
-    // Add the manifest:
-
+    std::string content_xml = content_stream.str();
+    zip.deleteEntry("content.xml");
+    if(!zip.addData("content.xml", content_xml.data(), content_xml.size()))
+        throw std::runtime_error("Could not replace content.xml");
+
+    // Pictures which were parsed from the archive refer to it and are kept as they are. Only
+    // pictures from the filesystem are added:
+    pugi::xml_document manifest;
+    pugi::xml_node manifest_files_node;
     for(auto &picture : w.m_pictures)
     {
+        if(picture.m_source == picture.m_dest && zip.hasEntry(picture.m_dest))
+            continue;
+
+        zip.deleteEntry(picture.m_dest);
         if(!zip.addFile(picture.m_dest, picture.m_source))
             throw std::runtime_error("Could not add file to archive");
-        auto manifest_entry = w.m_manifest_files_node.append_child("manifest:file-entry");
-        manifest_entry.append_attribute("manifest:full-path").set_value(picture.m_dest);
-        manifest_entry.append_attribute("manifest:media-type").set_value(picture.m_type);
+
+        if(!manifest_files_node)
+        {
+            auto manifest_entry = zip.getEntry("META-INF/manifest.xml");
+            if(manifest_entry.isNull() || !manifest.load_string(manifest_entry.readAsText().c_str()))
+                manifest.reset(manifest_skeleton());
+            manifest_files_node = manifest.child("manifest:manifest");
+        }
+        if(!manifest_files_node.find_child_by_attribute(
+               "manifest:file-entry", "manifest:full-path", picture.m_dest.c_str()))
+        {
+            auto manifest_entry = manifest_files_node.append_child("manifest:file-entry");
+            manifest_entry.append_attribute("manifest:full-path").set_value(picture.m_dest);
+            manifest_entry.append_attribute("manifest:media-type").set_value(picture.m_type);
+        }
+    }
+
+    std::string manifest_xml;
+    if(manifest_files_node)
+    {
+        std::ostringstream manifest_stream;
+        manifest.print(manifest_stream);
+        manifest_xml = manifest_stream.str();
+        zip.deleteEntry("META-INF/manifest.xml");
+        if(!zip.addData("META-INF/manifest.xml", manifest_xml.data(), manifest_xml.size()))
+            throw std::runtime_error("Could not replace the manifest");
+    }
+
+    if(zip.close() != LIBZIPPP_OK)
+        throw std::runtime_error("Could not write odt archive");
+}
+
+void writer::write_flat(const text_doc &doc, std::ostream &os, const pugi::xml_document *base)
+{
+    writer w(std::string{}, base, true);
+    doc.accept(w);
+    w.m_content.print(os, "  ");
+
+    if(!os.flush())
+        throw std::runtime_error("Could not write flat odt document");
+}
+
+void writer::write_flat(
+    const text_doc &doc, const std::string &filename, const pugi::xml_document *base)
+{
+    fs::path parent_path = fs::path(filename).parent_path();
+    if(!parent_path.empty() && !fs::exists(parent_path))
+        fs::create_directories(parent_path);
+
+    std::ofstream file(filename, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Unable to create " + filename + " for writing");
+
+    write_flat(doc, file, base);
+}
+
+void writer::write_archive(zip_writer &zip, const text_doc &doc, bool pipelined)
+{
+    const auto &parts = cached_parts();
+
+    // Add the mimetype, must be uncompressed and first:
+    zip.add(parts.m_mimetype);
+
+    // Add the content.xml, compressing it as it is printed:
+    if(pipelined)
+    {
+        // Visiting and printing, deflating and writing each get their own thread:
+        zip.add_pipelined("content.xml",
+            [this, &doc](const byte_sink &sink)
+            {
+                doc.accept(*this);
+                sink_xml_writer content_writer(sink);
+                m_content.print(content_writer, "  ");
+            });
+    }
+    else
+    {
+        doc.accept(*this);
+        zip.begin_entry("content.xml");
+        sink_xml_writer content_writer(
+            [&zip](const char *data, std::size_t size) { zip.write(data, size); });
+        m_content.print(content_writer, "  ");
+        zip.end_entry();
+    }
+
+    zip.add(parts.m_styles);
+    zip.add(parts.m_meta);
+
+    // Add the manifest. Without pictures it is the same for every document:
+    if(m_pictures.empty())
+    {
+        zip.add(parts.m_manifest);
+    }
+    else
+    {
+        for(auto &picture : m_pictures)
+        {
+            std::ifstream in(picture.m_source, std::ios::binary);
+            if(!in)
+                throw std::runtime_error("Could not add file to archive");
+            std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+            // Pictures are already compressed, deflating them again gains nothing:
+            zip.add(picture.m_dest, data, zip_method::store);
+            auto manifest_entry = m_manifest_files_node.append_child("manifest:file-entry");
+            manifest_entry.append_attribute("manifest:full-path").set_value(picture.m_dest);
+            manifest_entry.append_attribute("manifest:media-type").set_value(picture.m_type);
+        }
+        std::ostringstream manifest_stream;
+        m_manifest.print(manifest_stream);
+        zip.add("META-INF/manifest.xml", manifest_stream.str());
     }
-    std::ostringstream manifest_stream;
-    w.m_manifest.print(manifest_stream);
-    w.m_manifest.print(std::cout, "  ");
-    manifest_xml = manifest_stream.str();
-    zip.addData("META-INF/manifest.xml", manifest_xml.data(), manifest_xml.size());
 
-    zip.close();
+    zip.finish();
 }
 
 void writer::visit(const text &val)
@@ -144,9 +423,20 @@ void writer::visit(const text &val)
     get_current().append_child(pugi::node_pcdata).set_value(val.m_text);
 }
 
-void writer::visit(const span &) { get_current().append_child("text:span"); }
+void writer::visit(const span &s)
+{
+    auto n = get_current().append_child("text:span");
+    if(!s.get_style().is_empty())
+        n.append_attribute("text:style-name").set_value(s.get_style().get_name().c_str());
+}
 
-void writer::visit(const heading &) { get_current().append_child("text:h"); }
+void writer::visit(const heading &h)
+{
+    auto n = get_current().append_child("text:h");
+    n.append_attribute("text:outline-level").set_value(h.level());
+    if(!h.get_style().is_empty())
+        n.append_attribute("text:style-name").set_value(h.get_style().get_name().c_str());
+}
 
 void writer::visit(const paragraph &p)
 {
@@ -166,10 +456,35 @@ void writer::visit(const text_doc &doc)
 
     // Add any list / automatic styles:
     for(auto &[name, s] : doc.list_styles())
-        write_xml(m_automatic_styles, s);
+    {
+        auto parent = replace_base_style("text:list-style", name, m_automatic_styles);
+        write_xml(parent, s);
+    }
     // Add any text styles:
     for(auto &[name, s] : doc.styles())
-        write_xml(m_styles, s);
+    {
+        auto parent = replace_base_style("style:style", name, m_styles);
+        write_xml(parent, s);
+    }
+}
+
+pugi::xml_node writer::replace_base_style(
+    const char *tag, const std::string &name, pugi::xml_node parent)
+{
+    if(!m_update)
+        return parent;
+
+    // The document's definition wins over the one it was parsed with, so drop the old one and
+    // write the new one in its place:
+    for(auto styles : {m_styles, m_automatic_styles})
+    {
+        if(auto old = styles.find_child_by_attribute(tag, "style:name", name.c_str()))
+        {
+            styles.remove_child(old);
+            return styles;
+        }
+    }
+    return parent;
 }
 
 void writer::visit(const list &l)
@@ -195,13 +510,40 @@ void writer::visit(const bookmark &b)
 void writer::visit(const image &v)
 {
     auto n = get_current().append_child("draw:image");
+    const auto &uri = v.get_uri();
+
+    if(m_flat)
+    {
+        // Flat ODT has nowhere to put the file, so it is embedded. A data URI is embedded as is.
+        std::string encoded;
+        std::string mime_type;
+        constexpr std::string_view base64_marker = ";base64,";
+        if(auto marker = uri.find(base64_marker); uri.starts_with("data:") && marker != uri.npos)
+        {
+            mime_type = uri.substr(5, marker - 5);
+            encoded = uri.substr(marker + base64_marker.size());
+        }
+        else
+        {
+            std::ifstream in(uri, std::ios::binary);
+            if(!in)
+                throw std::runtime_error("Could not embed picture " + uri);
+            std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+            encoded = base64_encode(data);
+            mime_type = get_media_type(uri);
+        }
+        if(!mime_type.empty())
+            n.append_attribute("draw:mime-type").set_value(mime_type);
+        n.append_child("office:binary-data").append_child(pugi::node_pcdata).set_value(encoded);
+        return;
+    }
 
     // TODO: How to map the uri to archive / ODT filename?
     // Add the image to the manifest and mark an entry for archival:
     archive_item entry{};
-    entry.m_dest = ("Pictures" / fs::path(v.get_uri()).filename()).generic_string();
-    entry.m_source = v.get_uri();
-    entry.m_type = get_media_type(v.get_uri());
+    entry.m_dest = ("Pictures" / fs::path(uri).filename()).generic_string();
+    entry.m_source = uri;
+    entry.m_type = get_media_type(uri);
     m_pictures.insert(entry);
     n.append_attribute("xlink:href").set_value(entry.m_dest);
     n.append_attribute("xlink:type").set_value("simple");
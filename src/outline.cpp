@@ -0,0 +1,63 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/outline.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+
+std::string section::title() const { return const_block_text(*m_heading).str(); }
+
+outline::outline(const text_doc &doc)
+{
+    // Sections still waiting for a heading of their level or higher to end them
+    std::vector<std::size_t> open;
+    auto close_until = [&](int level, section::block_iterator end)
+    {
+        while(!open.empty() && m_sections[open.back()].m_level >= level)
+        {
+            m_sections[open.back()].m_end = end;
+            open.pop_back();
+        }
+    };
+
+    for(auto it = doc.m_children.cbegin(); it != doc.m_children.cend(); ++it)
+    {
+        if(!(*it)->is_type(elem_t::h))
+            continue;
+
+        const auto *h = dynamic_cast<const heading *>(it->get());
+        close_until(h->level(), it);
+
+        auto index = m_sections.size();
+        auto parent = open.empty() ? section::npos : open.back();
+        m_sections.push_back({h, h->level(), parent, {}, it, doc.m_children.cend()});
+        (parent == section::npos ? m_top_level : m_sections[parent].m_children).push_back(index);
+        open.push_back(index);
+    }
+}
+
+const section *outline::find(const heading &h) const
+{
+    for(const auto &s : m_sections)
+        if(s.m_heading == &h)
+            return &s;
+    return nullptr;
+}
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "docsmithcpp/output_buffer.h"
+
+namespace docsmith
+{
+namespace
+{
+void write_fd(int fd, const char *data, std::size_t size)
+{
+    while(size > 0)
+    {
+#ifdef _WIN32
+        auto n = ::_write(fd, data, static_cast<unsigned>(std::min<std::size_t>(size, 1 << 30)));
+#else
+        auto n = ::write(fd, data, size);
+#endif
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "Failed to write output");
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+}
+
+output_buffer::output_buffer(sink_fn sink, std::size_t capacity) :
+    m_sink(std::move(sink))
+{
+    m_data.reserve(capacity > 0 ? capacity : 1);
+}
+
+output_buffer::output_buffer(int fd, std::size_t capacity) :
+    output_buffer([fd](const char *data, std::size_t size) { write_fd(fd, data, size); }, capacity)
+{
+}
+
+output_buffer::~output_buffer()
+{
+    try
+    {
+        flush();
+    }
+    catch(...)
+    {
+    }
+}
+
+void output_buffer::flush()
+{
+    if(m_data.empty())
+        return;
+    m_last = m_data.back();
+    auto size = m_data.size();
+    try
+    {
+        m_sink(m_data.data(), size);
+    }
+    catch(...)
+    {
+        m_data.clear(); // Don't pass the same data again on the next flush
+        throw;
+    }
+    m_data.clear();
+    m_flushed += size;
+}
+
+void output_buffer::write_slow(std::string_view s)
+{
+    // Top up the buffer, then pass large writes straight through rather than copying them
+    auto room = m_data.capacity() - m_data.size();
+    m_data.insert(m_data.end(), s.begin(), s.begin() + static_cast<std::ptrdiff_t>(room));
+    s.remove_prefix(room);
+    flush();
+    if(s.size() >= m_data.capacity())
+    {
+        m_last = s.back();
+        m_sink(s.data(), s.size());
+        m_flushed += s.size();
+    }
+    else
+        m_data.insert(m_data.end(), s.begin(), s.end());
+}
+}
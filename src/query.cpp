@@ -0,0 +1,359 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+
+#include "docsmithcpp/query.h"
+#include "docsmithcpp/text_doc.h"
+
+namespace docsmith
+{
+namespace
+{
+constexpr std::uint32_t bit(elem_t t) { return 1u << static_cast<unsigned>(t); }
+
+std::uint32_t type_mask(std::string_view name)
+{
+    static const std::pair<std::string_view, elem_t> names[] = {
+        {"text_doc", elem_t::doc},
+        {"heading", elem_t::h},
+        {"paragraph", elem_t::p},
+        {"list", elem_t::lst},
+        {"list_item", elem_t::lit},
+        {"span", elem_t::spn},
+        {"text", elem_t::txt},
+        {"hyperlink", elem_t::href},
+        {"frame", elem_t::fr},
+        {"image", elem_t::img},
+        {"bookmark", elem_t::bookmark},
+    };
+    if(name == "*")
+        return ~0u;
+    for(auto &[n, t] : names)
+        if(n == name)
+            return bit(t);
+    throw std::invalid_argument("Unknown element type in selector: " + std::string(name));
+}
+
+/// Recursive descent over the selector text
+class selector_parser
+{
+public:
+    explicit selector_parser(std::string_view s) :
+        m_s(s)
+    {
+    }
+
+    bool at_end() const { return m_pos >= m_s.size(); }
+    char peek() const { return at_end() ? '\0' : m_s[m_pos]; }
+
+    bool skip_space()
+    {
+        auto start = m_pos;
+        while(!at_end() && (peek() == ' ' || peek() == '\t' || peek() == '\n'))
+            ++m_pos;
+        return m_pos != start;
+    }
+
+    bool accept(std::string_view token)
+    {
+        if(m_s.substr(m_pos, token.size()) != token)
+            return false;
+        m_pos += token.size();
+        return true;
+    }
+
+    void expect(std::string_view token)
+    {
+        if(!accept(token))
+            fail("expected '" + std::string(token) + "'");
+    }
+
+    std::string_view identifier()
+    {
+        auto start = m_pos;
+        while(!at_end() && (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_' ||
+                               peek() == '-'))
+            ++m_pos;
+        return m_s.substr(start, m_pos - start);
+    }
+
+    std::string quoted(char quote)
+    {
+        std::string r;
+        for(++m_pos; !at_end() && peek() != quote; ++m_pos)
+        {
+            if(peek() == '\\' && m_pos + 1 < m_s.size())
+                ++m_pos;
+            r.push_back(peek());
+        }
+        expect(std::string_view(&quote, 1));
+        return r;
+    }
+
+    [[noreturn]] void fail(const std::string &what) const
+    {
+        throw std::invalid_argument("Invalid selector \"" + std::string(m_s) + "\" at position " +
+                                    std::to_string(m_pos) + ": " + what);
+    }
+
+private:
+    std::string_view m_s;
+    std::size_t m_pos{0};
+};
+}
+
+selector::selector(std::string_view expression)
+{
+    selector_parser p(expression);
+    p.skip_space();
+
+    bool child_only = false;
+    while(!p.at_end())
+    {
+        step s;
+        s.m_child_only = child_only;
+
+        if(p.accept("*"))
+            s.m_types = ~0u;
+        else if(auto name = p.identifier(); !name.empty())
+            s.m_types = type_mask(name);
+        else if(p.peek() != '[')
+            p.fail("expected an element type or '['");
+
+        while(p.accept("["))
+        {
+            p.skip_space();
+            predicate pred{};
+            auto attr = p.identifier();
+            if(attr == "style")
+                pred.m_attribute = attribute::style;
+            else if(attr == "level")
+                pred.m_attribute = attribute::level;
+            else if(attr == "url")
+                pred.m_attribute = attribute::url;
+            else if(attr == "uri")
+                pred.m_attribute = attribute::uri;
+            else if(attr == "name")
+                pred.m_attribute = attribute::name;
+            else if(attr == "text")
+                pred.m_attribute = attribute::text;
+            else
+                p.fail("unknown attribute '" + std::string(attr) + "'");
+
+            p.skip_space();
+            // Longest operators first:
+            if(p.accept("!="))
+                pred.m_comparison = comparison::ne;
+            else if(p.accept("<="))
+                pred.m_comparison = comparison::le;
+            else if(p.accept(">="))
+                pred.m_comparison = comparison::ge;
+            else if(p.accept("^="))
+                pred.m_comparison = comparison::prefix;
+            else if(p.accept("$="))
+                pred.m_comparison = comparison::suffix;
+            else if(p.accept("*="))
+                pred.m_comparison = comparison::contains;
+            else if(p.accept("="))
+                pred.m_comparison = comparison::eq;
+            else if(p.accept("<"))
+                pred.m_comparison = comparison::lt;
+            else if(p.accept(">"))
+                pred.m_comparison = comparison::gt;
+            else
+                p.fail("expected a comparison operator");
+
+            p.skip_space();
+            if(p.peek() == '"' || p.peek() == '\'')
+                pred.m_value = p.quoted(p.peek());
+            else
+            {
+                pred.m_value = std::string(p.identifier());
+                if(pred.m_value.empty())
+                    p.fail("expected a value");
+            }
+            auto [end, ec] = std::from_chars(
+                pred.m_value.data(), pred.m_value.data() + pred.m_value.size(), pred.m_number);
+            pred.m_is_number =
+                ec == std::errc{} && end == pred.m_value.data() + pred.m_value.size();
+            if(pred.m_attribute == attribute::level && !pred.m_is_number)
+                p.fail("level must be compared with an integer");
+
+            p.skip_space();
+            p.expect("]");
+            s.m_predicates.push_back(std::move(pred));
+        }
+        m_steps.push_back(std::move(s));
+
+        bool spaced = p.skip_space();
+        child_only = p.accept(">");
+        if(child_only)
+            p.skip_space();
+        else if(!spaced && !p.at_end())
+            p.fail("unexpected character");
+        if(child_only && p.at_end())
+            p.fail("expected a selector after '>'");
+    }
+
+    if(m_steps.empty())
+        throw std::invalid_argument("Empty selector");
+    if(m_steps.size() > 63)
+        throw std::invalid_argument("Selector has too many steps");
+
+    for(std::size_t i = 0; i < m_steps.size(); ++i)
+        if(!m_steps[i].m_child_only)
+            m_persistent |= std::uint64_t{1} << i;
+}
+
+std::vector<element *> selector::select(element &root) const
+{
+    // The tree under a non-const root is non-const, so handing out mutable pointers is fine
+    auto found = select(std::as_const(root));
+    std::vector<element *> out;
+    out.reserve(found.size());
+    for(const auto *e : found)
+        out.push_back(const_cast<element *>(e));
+    return out;
+}
+
+std::vector<const element *> selector::select(const element &root) const
+{
+    std::vector<const element *> out;
+    walk(root, 1, out);
+    return out;
+}
+
+bool selector::matches_self(const element &e) const { return matches(m_steps.back(), e); }
+
+void selector::walk(
+    const element &e, std::uint64_t active, std::vector<const element *> &out) const
+{
+    // Bit i of active: steps before i matched on the ancestors, so step i may be tried here.
+    std::uint64_t matched = 0;
+    for(std::uint64_t bits = active; bits != 0; bits &= bits - 1)
+    {
+        auto i = static_cast<std::size_t>(std::countr_zero(bits));
+        if(matches(m_steps[i], e))
+            matched |= std::uint64_t{1} << i;
+    }
+    auto last = std::uint64_t{1} << (m_steps.size() - 1);
+    if(matched & last)
+        out.push_back(&e);
+
+    auto *kids = e.child_list();
+    if(!kids || kids->empty())
+        return;
+
+    // A step matched here makes the next one available to the children. Descendant steps stay
+    // available all the way down; child steps only for the next level.
+    std::uint64_t next = (active & m_persistent) | ((matched << 1) & ((last << 1) - 1));
+
+    // Prune once no step is available. The element types can't be used to prune as well: the
+    // readers build trees with add_child(), which doesn't check is_valid_child, so a parsed
+    // document may hold e.g. a hyperlink inside a span.
+    if(next == 0)
+        return;
+
+    for(const auto &child : *kids)
+        walk(*child, next, out);
+}
+
+namespace
+{
+template <typename T>
+int compare_values(const T &lhs, const T &rhs)
+{
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+}
+
+bool selector::matches(const step &s, const element &e) const
+{
+    if((s.m_types & bit(e.type())) == 0)
+        return false;
+
+    for(const auto &pred : s.m_predicates)
+    {
+        // Fetch the attribute, if this element has it:
+        std::string value;
+        long long number = 0;
+        bool numeric = pred.m_attribute == attribute::level;
+        switch(pred.m_attribute)
+        {
+        case attribute::style:
+            if(auto *st = dynamic_cast<const styled_base *>(&e))
+                value = st->style().get_name();
+            else
+                return false;
+            break;
+        case attribute::level:
+            if(auto *h = dynamic_cast<const heading *>(&e))
+                number = h->level();
+            else
+                return false;
+            break;
+        case attribute::url:
+            if(auto *href = dynamic_cast<const hyperlink *>(&e))
+                value = href->get_url();
+            else
+                return false;
+            break;
+        case attribute::uri:
+            if(auto *img = dynamic_cast<const image *>(&e))
+                value = img->get_uri();
+            else
+                return false;
+            break;
+        case attribute::name:
+            if(auto *b = dynamic_cast<const bookmark *>(&e))
+                value = b->m_name;
+            else
+                return false;
+            break;
+        case attribute::text:
+            if(auto *t = dynamic_cast<const text *>(&e))
+                value = t->m_text;
+            else
+                return false;
+            break;
+        }
+
+        int cmp = numeric ? compare_values(number, pred.m_number) : value.compare(pred.m_value);
+        bool ok = false;
+        switch(pred.m_comparison)
+        {
+        case comparison::eq: ok = cmp == 0; break;
+        case comparison::ne: ok = cmp != 0; break;
+        case comparison::lt: ok = cmp < 0; break;
+        case comparison::le: ok = cmp <= 0; break;
+        case comparison::gt: ok = cmp > 0; break;
+        case comparison::ge: ok = cmp >= 0; break;
+        case comparison::prefix: ok = value.starts_with(pred.m_value); break;
+        case comparison::suffix: ok = value.ends_with(pred.m_value); break;
+        case comparison::contains: ok = value.find(pred.m_value) != std::string::npos; break;
+        }
+        if(!ok)
+            return false;
+    }
+    return true;
+}
+}
@@ -0,0 +1,721 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <stdexcept>
+
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/parallel.h"
+#include "docsmithcpp/regex.h"
+
+namespace docsmith
+{
+namespace
+{
+constexpr int max_repeat = 1000;          //!< Largest count in {n,m}
+constexpr std::size_t max_nfa = 100000;   //!< Largest compiled pattern
+constexpr std::size_t max_dfa = 4096;     //!< DFA states cached before the cache is reset
+
+/// Parsed pattern
+struct ast
+{
+    enum class kind
+    {
+        set,    //!< One byte from m_set
+        concat, //!< m_kids in sequence
+        alt,    //!< One of m_kids
+        repeat, //!< m_kids[0], m_min to m_max (-1 for unbounded) times
+        begin,
+        end
+    };
+    kind m_kind;
+    std::bitset<256> m_set{};
+    std::vector<ast> m_kids{};
+    int m_min{0};
+    int m_max{0};
+};
+
+ast make_set(const std::bitset<256> &set) { return {ast::kind::set, set}; }
+
+ast make_byte(unsigned char c)
+{
+    std::bitset<256> set;
+    set.set(c);
+    return make_set(set);
+}
+
+std::bitset<256> byte_range(unsigned lo, unsigned hi)
+{
+    std::bitset<256> set;
+    for(auto c = lo; c <= hi; ++c)
+        set.set(c);
+    return set;
+}
+
+/// Any single non-ASCII UTF-8 character
+ast multibyte_char()
+{
+    auto cont = make_set(byte_range(0x80, 0xbf));
+    ast two{ast::kind::concat, {}, {make_set(byte_range(0xc2, 0xdf)), cont}};
+    ast three{ast::kind::concat, {}, {make_set(byte_range(0xe0, 0xef)), cont, cont}};
+    ast four{ast::kind::concat, {}, {make_set(byte_range(0xf0, 0xf4)), cont, cont, cont}};
+    return {ast::kind::alt, {}, {two, three, four}};
+}
+
+/// Matches a character from an ASCII set, or any character outside ASCII if negated
+ast make_class(std::bitset<256> set, bool negated)
+{
+    if(!negated)
+        return make_set(set);
+    set = ~set & byte_range(0x00, 0x7f);
+    return {ast::kind::alt, {}, {make_set(set), multibyte_char()}};
+}
+
+class parser
+{
+public:
+    parser(std::string_view pattern, bool case_insensitive) :
+        m_p(pattern),
+        m_case_insensitive(case_insensitive)
+    {
+    }
+
+    ast parse()
+    {
+        auto a = parse_alt();
+        if(m_pos != m_p.size())
+            fail("unmatched ')'");
+        return a;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string &what) const
+    {
+        throw std::invalid_argument("Invalid regex \"" + std::string(m_p) + "\": " + what);
+    }
+
+    bool more() const { return m_pos < m_p.size(); }
+    char peek() const { return m_p[m_pos]; }
+
+    void fold(std::bitset<256> &set) const
+    {
+        if(m_case_insensitive)
+            for(unsigned c = 'a'; c <= 'z'; ++c)
+                if(set[c] || set[c - 'a' + 'A'])
+                    set.set(c).set(c - 'a' + 'A');
+    }
+
+    ast parse_alt()
+    {
+        ast a{ast::kind::alt};
+        a.m_kids.push_back(parse_concat());
+        while(more() && peek() == '|')
+        {
+            ++m_pos;
+            a.m_kids.push_back(parse_concat());
+        }
+        return a.m_kids.size() == 1 ? std::move(a.m_kids.front()) : a;
+    }
+
+    ast parse_concat()
+    {
+        ast a{ast::kind::concat};
+        while(more() && peek() != '|' && peek() != ')')
+            a.m_kids.push_back(parse_repeat());
+        return a;
+    }
+
+    int parse_count()
+    {
+        auto start = m_pos;
+        int n = 0;
+        while(more() && peek() >= '0' && peek() <= '9' && n <= max_repeat)
+            n = n * 10 + (m_p[m_pos++] - '0');
+        if(m_pos == start)
+            fail("bad repetition count");
+        if(n > max_repeat)
+            fail("repetition count over " + std::to_string(max_repeat));
+        return n;
+    }
+
+    ast parse_repeat()
+    {
+        auto a = parse_atom();
+        while(more())
+        {
+            int min = 0, max = -1;
+            if(peek() == '*')
+                ++m_pos;
+            else if(peek() == '+')
+                ++m_pos, min = 1;
+            else if(peek() == '?')
+                ++m_pos, max = 1;
+            else if(peek() == '{')
+            {
+                ++m_pos;
+                min = max = parse_count();
+                if(more() && peek() == ',')
+                {
+                    ++m_pos;
+                    max = more() && peek() == '}' ? -1 : parse_count();
+                }
+                if(!more() || m_p[m_pos++] != '}')
+                    fail("expected '}'");
+                if(max >= 0 && max < min)
+                    fail("bad repetition range");
+            }
+            else
+                break;
+
+            if(more() && peek() == '?')
+                fail("lazy quantifiers are not supported");
+            if(a.m_kind == ast::kind::begin || a.m_kind == ast::kind::end)
+                fail("nothing to repeat");
+            a = ast{ast::kind::repeat, {}, {std::move(a)}, min, max};
+        }
+        return a;
+    }
+
+    /// The set for \d, \w or \s, if c is one of those letters in either case
+    std::optional<std::bitset<256>> class_escape(char c) const
+    {
+        switch(c)
+        {
+        case 'd':
+        case 'D':
+            return byte_range('0', '9');
+        case 'w':
+        case 'W':
+            return byte_range('0', '9') | byte_range('a', 'z') | byte_range('A', 'Z') |
+                   byte_range('_', '_');
+        case 's':
+        case 'S':
+            return byte_range('\t', '\r') | byte_range(' ', ' ');
+        default:
+            return std::nullopt;
+        }
+    }
+
+    unsigned char escaped_byte(char c) const
+    {
+        switch(c)
+        {
+        case 't':
+            return '\t';
+        case 'n':
+            return '\n';
+        case 'r':
+            return '\r';
+        case 'f':
+            return '\f';
+        case 'v':
+            return '\v';
+        }
+        if(c >= '1' && c <= '9')
+            fail("back references are not supported");
+        if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+            fail(std::string("unknown escape \\") + c);
+        return static_cast<unsigned char>(c);
+    }
+
+    ast parse_atom()
+    {
+        auto c = static_cast<unsigned char>(m_p[m_pos++]);
+        switch(c)
+        {
+        case '(':
+        {
+            if(more() && peek() == '?')
+            {
+                if(m_pos + 1 >= m_p.size() || m_p[m_pos + 1] != ':')
+                    fail("unsupported group");
+                m_pos += 2;
+            }
+            auto a = parse_alt();
+            if(!more() || m_p[m_pos++] != ')')
+                fail("missing ')'");
+            return a;
+        }
+        case '[':
+            return parse_class();
+        case '.':
+            return make_class({}, true);
+        case '^':
+            return {ast::kind::begin};
+        case '$':
+            return {ast::kind::end};
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            fail("nothing to repeat");
+        case '\\':
+        {
+            if(!more())
+                fail("trailing backslash");
+            char e = m_p[m_pos++];
+            if(auto set = class_escape(e))
+                return make_class(*set, e >= 'A' && e <= 'Z');
+            return literal(escaped_byte(e));
+        }
+        }
+        if(c < 0x80)
+            return literal(c);
+
+        // A whole UTF-8 character, so that a quantifier applies to all of it
+        std::size_t len = (c >> 5) == 0x06 ? 2 : (c >> 4) == 0x0e ? 3 : (c >> 3) == 0x1e ? 4 : 0;
+        if(len == 0 || m_pos - 1 + len > m_p.size() ||
+            !is_valid_utf8(m_p.substr(m_pos - 1, len)))
+            fail("invalid UTF-8");
+        ast a{ast::kind::concat, {}, {make_byte(c)}};
+        for(std::size_t i = 1; i < len; ++i)
+            a.m_kids.push_back(make_byte(static_cast<unsigned char>(m_p[m_pos++])));
+        return a;
+    }
+
+    ast literal(unsigned char c) const
+    {
+        std::bitset<256> set;
+        set.set(c);
+        fold(set);
+        return make_set(set);
+    }
+
+    unsigned char class_member()
+    {
+        if(!more())
+            fail("missing ']'");
+        auto c = static_cast<unsigned char>(m_p[m_pos++]);
+        if(c >= 0x80)
+            fail("non-ASCII characters in classes are not supported");
+        if(c == '\\')
+        {
+            if(!more())
+                fail("trailing backslash");
+            return escaped_byte(m_p[m_pos++]);
+        }
+        return c;
+    }
+
+    ast parse_class()
+    {
+        bool negated = more() && peek() == '^';
+        if(negated)
+            ++m_pos;
+
+        std::bitset<256> set;
+        for(bool first = true; first || !more() || peek() != ']'; first = false)
+        {
+            if(more() && peek() == '\\' && m_pos + 1 < m_p.size())
+                if(auto escape = class_escape(m_p[m_pos + 1]))
+                {
+                    if(m_p[m_pos + 1] >= 'A' && m_p[m_pos + 1] <= 'Z')
+                        fail("negated escapes in classes are not supported");
+                    set |= *escape;
+                    m_pos += 2;
+                    continue;
+                }
+
+            auto lo = class_member();
+            if(m_pos + 1 < m_p.size() && peek() == '-' && m_p[m_pos + 1] != ']')
+            {
+                ++m_pos;
+                auto hi = class_member();
+                if(hi < lo)
+                    fail("bad class range");
+                set |= byte_range(lo, hi);
+            }
+            else
+                set.set(lo);
+        }
+        ++m_pos; // ']'
+        fold(set);
+        return make_class(set, negated);
+    }
+
+    std::string_view m_p;
+    std::size_t m_pos{0};
+    bool m_case_insensitive;
+};
+}
+
+regex::regex(std::string_view pattern, bool case_insensitive) :
+    m_pattern(pattern)
+{
+    auto tree = parser(pattern, case_insensitive).parse();
+
+    // Thompson construction, back to front: each fragment is built knowing its successor
+    using kind = nfa_state::kind;
+    auto add = [this](nfa_state s)
+    {
+        if(m_nfa.size() == max_nfa)
+            throw std::invalid_argument("Regex \"" + m_pattern + "\" is too large");
+        m_nfa.push_back(s);
+        return static_cast<int>(m_nfa.size() - 1);
+    };
+    auto compile = [&](auto &self, const ast &a, int next) -> int
+    {
+        switch(a.m_kind)
+        {
+        case ast::kind::set:
+            return add({kind::bytes, a.m_set, next});
+        case ast::kind::concat:
+            for(auto it = a.m_kids.rbegin(); it != a.m_kids.rend(); ++it)
+                next = self(self, *it, next);
+            return next;
+        case ast::kind::alt:
+        {
+            int r = self(self, a.m_kids.back(), next);
+            for(auto i = a.m_kids.size() - 1; i-- > 0;)
+                r = add({kind::split, {}, self(self, a.m_kids[i], next), r});
+            return r;
+        }
+        case ast::kind::repeat:
+        {
+            int r = next;
+            if(a.m_max < 0)
+            {
+                r = add({kind::split, {}, -1, next});
+                int body = self(self, a.m_kids[0], r);
+                m_nfa[r].m_next = body;
+            }
+            else
+                for(int k = a.m_min; k < a.m_max; ++k)
+                    r = add({kind::split, {}, self(self, a.m_kids[0], r), next});
+            for(int k = 0; k < a.m_min; ++k)
+                r = self(self, a.m_kids[0], r);
+            return r;
+        }
+        case ast::kind::begin:
+            return add({kind::begin, {}, next});
+        case ast::kind::end:
+            return add({kind::end, {}, next});
+        }
+        return next;
+    };
+    m_start = compile(compile, tree, add({kind::match, {}, -1}));
+    m_mark.assign(m_nfa.size(), 0);
+
+    // With every anchor allowed, this finds an empty match in any context
+    std::vector<int> empty{m_start};
+    closure(empty, true, true);
+    m_matches_empty = std::any_of(empty.begin(), empty.end(),
+        [this](int st) { return m_nfa[st].m_kind == nfa_state::kind::match; });
+}
+
+void regex::next_generation()
+{
+    if(++m_generation == 0)
+    {
+        std::fill(m_mark.begin(), m_mark.end(), 0);
+        m_generation = 1;
+    }
+}
+
+void regex::closure(std::vector<int> &set, bool at_start, bool at_end)
+{
+    next_generation();
+    std::vector<int> stack(set.rbegin(), set.rend());
+    set.clear();
+    while(!stack.empty())
+    {
+        int s = stack.back();
+        stack.pop_back();
+        if(m_mark[s] == m_generation)
+            continue;
+        m_mark[s] = m_generation;
+
+        const auto &st = m_nfa[s];
+        switch(st.m_kind)
+        {
+        case nfa_state::kind::bytes:
+        case nfa_state::kind::match:
+            set.push_back(s);
+            break;
+        case nfa_state::kind::split:
+            stack.push_back(st.m_alt);
+            stack.push_back(st.m_next);
+            break;
+        case nfa_state::kind::begin:
+            if(at_start)
+                stack.push_back(st.m_next);
+            break;
+        case nfa_state::kind::end:
+            if(at_end)
+                stack.push_back(st.m_next);
+            else
+                set.push_back(s); // Kept so the end of the text can be checked later
+            break;
+        }
+    }
+}
+
+int regex::dfa_intern(std::vector<int> set)
+{
+    std::sort(set.begin(), set.end());
+    if(auto it = m_dfa_ids.find(set); it != m_dfa_ids.end())
+        return it->second;
+
+    if(m_dfa.size() == max_dfa)
+    {
+        m_dfa.clear();
+        m_dfa_match.clear();
+        m_dfa_ids.clear();
+        m_dfa_next.clear();
+        m_dfa_starts[0] = m_dfa_starts[1] = -1;
+    }
+    bool match = std::any_of(set.begin(), set.end(),
+        [this](int s) { return m_nfa[s].m_kind == nfa_state::kind::match; });
+    int id = static_cast<int>(m_dfa.size());
+    m_dfa.push_back(set);
+    m_dfa_match.push_back(match);
+    m_dfa_ids.emplace(std::move(set), id);
+    m_dfa_next.resize(m_dfa_next.size() + 256, -1);
+    return id;
+}
+
+int regex::dfa_start(bool at_start)
+{
+    auto &start = m_dfa_starts[at_start];
+    if(start < 0)
+    {
+        std::vector<int> set{m_start};
+        closure(set, at_start, false);
+        start = dfa_intern(std::move(set));
+    }
+    return start;
+}
+
+int regex::dfa_next(int state, unsigned char byte)
+{
+    if(int next = m_dfa_next[static_cast<std::size_t>(state) * 256 + byte]; next >= 0)
+        return next;
+
+    std::vector<int> set;
+    for(int s : m_dfa[state])
+        if(m_nfa[s].m_kind == nfa_state::kind::bytes && m_nfa[s].m_bytes[byte])
+            set.push_back(m_nfa[s].m_next);
+    set.push_back(m_start); // Unanchored: a match may start at any position
+    closure(set, false, false);
+
+    auto states = m_dfa.size();
+    int next = dfa_intern(std::move(set));
+    if(m_dfa.size() >= states) // Not reset, so state is still valid
+        m_dfa_next[static_cast<std::size_t>(state) * 256 + byte] = next;
+    return next;
+}
+
+bool regex::accepts_at_end(const std::vector<int> &set, bool at_start)
+{
+    auto end = set;
+    closure(end, at_start, true);
+    return std::any_of(end.begin(), end.end(),
+        [this](int s) { return m_nfa[s].m_kind == nfa_state::kind::match; });
+}
+
+bool regex::contains(std::string_view s)
+{
+    // The DFA would accept the empty matches that search() skips
+    if(m_matches_empty)
+        return search(s).has_value();
+
+    int state = dfa_start(true);
+    for(char c : s)
+    {
+        if(m_dfa_match[state])
+            return true;
+        auto byte = static_cast<unsigned char>(c);
+        auto next = m_dfa_next[static_cast<std::size_t>(state) * 256 + byte];
+        state = next >= 0 ? next : dfa_next(state, byte);
+    }
+    return m_dfa_match[state] || accepts_at_end(m_dfa[state], s.empty());
+}
+
+void regex::add_thread(std::vector<thread> &list, int state, std::size_t start, bool at_start,
+    bool at_end)
+{
+    m_stack.push_back(state);
+    while(!m_stack.empty())
+    {
+        int st = m_stack.back();
+        m_stack.pop_back();
+        if(m_mark[st] == m_generation)
+            continue;
+        m_mark[st] = m_generation;
+
+        const auto &n = m_nfa[st];
+        switch(n.m_kind)
+        {
+        case nfa_state::kind::bytes:
+        case nfa_state::kind::match:
+            list.push_back({st, start});
+            break;
+        case nfa_state::kind::split:
+            m_stack.push_back(n.m_alt);
+            m_stack.push_back(n.m_next);
+            break;
+        case nfa_state::kind::begin:
+            if(at_start)
+                m_stack.push_back(n.m_next);
+            break;
+        case nfa_state::kind::end:
+            if(at_end)
+                m_stack.push_back(n.m_next);
+            break;
+        }
+    }
+}
+
+std::optional<std::pair<std::size_t, std::size_t>> regex::search(
+    std::string_view s, std::size_t from)
+{
+    if(from > s.size())
+        return std::nullopt;
+
+    // Pike VM. Threads are kept in order of start position and a state is only entered once per
+    // step, by the thread that started first, so the leftmost match always survives.
+    std::vector<thread> current, next;
+    std::optional<std::pair<std::size_t, std::size_t>> best;
+    next_generation();
+    for(auto pos = from;; ++pos)
+    {
+        bool at_end = pos == s.size();
+        if(!best)
+            add_thread(current, m_start, pos, pos == 0, at_end);
+
+        // Empty matches aren't reported
+        for(const auto &t : current)
+            if(m_nfa[t.m_state].m_kind == nfa_state::kind::match && t.m_start < pos &&
+                (!best || t.m_start < best->first ||
+                    (t.m_start == best->first && pos > best->second)))
+                best = {t.m_start, pos};
+
+        if(at_end)
+            break;
+
+        next_generation();
+        next.clear();
+        auto byte = static_cast<unsigned char>(s[pos]);
+        for(const auto &t : current)
+        {
+            const auto &n = m_nfa[t.m_state];
+            if(n.m_kind == nfa_state::kind::bytes && n.m_bytes[byte] &&
+                !(best && t.m_start > best->first))
+                add_thread(next, n.m_next, t.m_start, false, pos + 1 == s.size());
+        }
+        std::swap(current, next);
+        if(best && current.empty())
+            break;
+    }
+    return best;
+}
+
+std::vector<std::pair<std::size_t, std::size_t>> regex::search_all(std::string_view s)
+{
+    // One Pike VM pass, as calling search() after each match would rescan the text the threads of
+    // that match ran over. A thread starts at every position. When one reaches the match state, its
+    // match replaces the ones it overlaps (those starting at or after it, as it ends here) and the
+    // threads which started inside it are dropped. A thread that started earlier may still replace
+    // the last few matches; those before it are final, as the threads overlapping them are gone.
+    std::vector<std::pair<std::size_t, std::size_t>> matches;
+    std::vector<thread> current, next;
+    next_generation();
+    for(std::size_t pos = 0;; ++pos)
+    {
+        bool at_end = pos == s.size();
+
+        // At most one thread is in the match state. Empty matches aren't reported.
+        for(const auto &t : current)
+            if(m_nfa[t.m_state].m_kind == nfa_state::kind::match && t.m_start < pos)
+            {
+                auto start = t.m_start;
+                while(!matches.empty() && matches.back().first >= start)
+                    matches.pop_back();
+                matches.push_back({start, pos});
+
+                std::erase_if(current,
+                    [&](const thread &u) { return u.m_start > start && u.m_start < pos; });
+                // Let the new thread below take the states the dropped ones held:
+                next_generation();
+                for(const auto &u : current)
+                    m_mark[u.m_state] = m_generation;
+                break;
+            }
+
+        if(at_end)
+            break;
+        add_thread(current, m_start, pos, pos == 0, false);
+
+        next_generation();
+        next.clear();
+        auto byte = static_cast<unsigned char>(s[pos]);
+        for(const auto &t : current)
+        {
+            const auto &n = m_nfa[t.m_state];
+            if(n.m_kind == nfa_state::kind::bytes && n.m_bytes[byte])
+                add_thread(next, n.m_next, t.m_start, false, pos + 1 == s.size());
+        }
+        std::swap(current, next);
+    }
+    return matches;
+}
+
+template <typename Element>
+std::vector<basic_regex_match<Element>> regex::find_all_below(Element &root)
+{
+    std::vector<basic_regex_match<Element>> matches;
+    basic_block_text<Element> bt;
+    for_each_block(root,
+        [&](Element &block)
+        {
+            bt.assign(block);
+            const auto &s = bt.str();
+            if(s.empty() || !contains(s))
+                return;
+
+            for(auto [begin, end] : search_all(s))
+            {
+                auto last = bt.locate(end - 1);
+                ++last.m_offset;
+                matches.push_back({&block, begin, end, bt.locate(begin), last,
+                    std::string(s.substr(begin, end - begin))});
+            }
+        });
+    return matches;
+}
+
+std::vector<regex_match> regex::find_all(element &root) { return find_all_below(root); }
+
+std::vector<const_regex_match> regex::find_all(const element &root)
+{
+    return find_all_below(root);
+}
+
+std::vector<std::vector<regex_match>> find_all_parallel(
+    const regex &re, const std::vector<element *> &roots, unsigned threads)
+{
+    std::vector<std::vector<regex_match>> results(roots.size());
+    parallel_for(roots.size(), threads,
+        [&]
+        {
+            // The DFA cache isn't shared between threads
+            return [&, local = re](std::size_t i) mutable
+            { results[i] = local.find_all(*roots[i]); };
+        });
+    return results;
+}
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/replace.h"
+#include "docsmithcpp/text.h"
+
+namespace docsmith
+{
+namespace
+{
+char fold(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+constexpr std::uint32_t output_flag = 0x80000000u;
+}
+
+std::size_t replace_result::total() const
+{
+    return std::accumulate(m_counts.begin(), m_counts.end(), std::size_t{0});
+}
+
+replacer::replacer(std::vector<rule> rules, bool case_insensitive) :
+    m_rules(std::move(rules)),
+    m_case_insensitive(case_insensitive)
+{
+    for(const auto &[pattern, replacement] : m_rules)
+        if(pattern.empty())
+            throw std::invalid_argument("Cannot replace an empty pattern");
+    build();
+}
+
+void replacer::build()
+{
+    // Only bytes that occur in a pattern get their own column in the transition table. Folding
+    // case here means the scan itself never has to:
+    for(const auto &[pattern, replacement] : m_rules)
+        for(char c : pattern)
+        {
+            auto &cls = m_classes[static_cast<unsigned char>(m_case_insensitive ? fold(c) : c)];
+            if(cls == 0)
+            {
+                if(m_num_classes == 256)
+                    throw std::logic_error("Too many distinct pattern bytes");
+                cls = static_cast<std::uint8_t>(m_num_classes++);
+            }
+        }
+    if(m_case_insensitive)
+        for(unsigned char c = 'A'; c <= 'Z'; ++c)
+            m_classes[c] = m_classes[c - 'A' + 'a'];
+
+    // Trie, with 0 as "no transition" (the root is never a target):
+    const auto width = m_num_classes;
+    m_next.assign(width, 0);
+    m_out.assign(1, -1);
+    for(std::size_t r = 0; r < m_rules.size(); ++r)
+    {
+        std::uint32_t state = 0;
+        for(char c : m_rules[r].first)
+        {
+            auto cls = m_classes[static_cast<unsigned char>(c)];
+            if(m_next[state * width + cls] == 0)
+            {
+                m_next[state * width + cls] = static_cast<std::uint32_t>(m_out.size());
+                m_out.push_back(-1);
+                m_next.resize(m_next.size() + width, 0);
+            }
+            state = m_next[state * width + cls];
+        }
+        // Identical patterns: the first rule wins
+        if(m_out[state] < 0)
+            m_out[state] = static_cast<std::int32_t>(r);
+    }
+
+    // Breadth first: failure links, completing the trie into a DFA as we go
+    std::vector<std::uint32_t> fail(m_out.size(), 0);
+    m_link.assign(m_out.size(), -1);
+    m_report.assign(m_out.size(), -1);
+    std::queue<std::uint32_t> pending;
+    for(std::size_t c = 0; c < width; ++c)
+        if(auto s = m_next[c]; s != 0)
+            pending.push(s);
+
+    while(!pending.empty())
+    {
+        auto state = pending.front();
+        pending.pop();
+        auto f = fail[state];
+        m_link[state] = m_out[f] >= 0 ? static_cast<std::int32_t>(f) : m_link[f];
+        m_report[state] = m_out[state] >= 0 ? static_cast<std::int32_t>(state) : m_link[state];
+
+        for(std::size_t c = 0; c < width; ++c)
+        {
+            auto &next = m_next[state * width + c];
+            if(next != 0)
+            {
+                fail[next] = m_next[f * width + c];
+                pending.push(next);
+            }
+            else
+                next = m_next[f * width + c];
+        }
+    }
+
+    // Store transitions as row offsets, saving a multiply per byte scanned, with the top bit
+    // marking states where some rule ends
+    if(m_out.size() * width >= output_flag)
+        throw std::logic_error("Too many patterns");
+    for(auto &next : m_next)
+        next = next * static_cast<std::uint32_t>(width) | (m_report[next] >= 0 ? output_flag : 0);
+}
+
+void replacer::find_matches(
+    const std::string &s, std::vector<match> &all, std::vector<match> &chosen) const
+{
+    // Every occurrence, then keep the leftmost-longest non-overlapping ones:
+    all.clear();
+    chosen.clear();
+    std::uint32_t row = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        auto next = m_next[row + m_classes[static_cast<unsigned char>(s[i])]];
+        row = next & ~output_flag;
+        if((next & output_flag) == 0)
+            continue;
+        for(auto out = m_report[row / m_num_classes]; out >= 0; out = m_link[out])
+        {
+            auto r = static_cast<std::size_t>(m_out[out]);
+            all.push_back({i + 1 - m_rules[r].first.size(), i + 1, r});
+        }
+    }
+    if(all.empty())
+        return;
+
+    std::sort(all.begin(), all.end(),
+        [](const match &a, const match &b)
+        { return a.m_begin != b.m_begin ? a.m_begin < b.m_begin : a.m_end > b.m_end; });
+
+    for(const auto &m : all)
+        if(chosen.empty() || m.m_begin >= chosen.back().m_end)
+            chosen.push_back(m);
+}
+
+replace_result replacer::apply(element &root) const
+{
+    replace_result result;
+    result.m_counts.assign(m_rules.size(), 0);
+
+    block_text bt;
+    std::vector<match> all, matches;
+    for_each_block(root,
+        [&](element &block)
+        {
+            bt.assign(block);
+            find_matches(bt.str(), all, matches);
+
+            // Back to front, so the node offsets of earlier matches stay valid
+            for(auto m = matches.rbegin(); m != matches.rend(); ++m)
+            {
+                auto first = bt.run_index(m->m_begin);
+                auto last = bt.run_index(m->m_end - 1);
+                const auto &runs = bt.runs();
+
+                for(auto i = last; i > first; --i)
+                    runs[i].m_node->m_text.erase(0, m->m_end - runs[i].m_start);
+
+                auto &head = runs[first].m_node->m_text;
+                auto begin = m->m_begin - runs[first].m_start;
+                auto count = std::min(m->m_end - m->m_begin, head.size() - begin);
+                head.replace(begin, count, m_rules[m->m_rule].second);
+                ++result.m_counts[m->m_rule];
+            }
+
+            // Observers recount the whole block, so one notification covers every edit in it
+            if(!matches.empty())
+                bt.runs().front().m_node->notify(change_t::text);
+        });
+    return result;
+}
+}
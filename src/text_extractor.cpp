@@ -0,0 +1,38 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include "docsmithcpp/text_extractor.h"
+
+namespace docsmith
+{
+void extract_text(const element &e, output_buffer &out)
+{
+    text_extractor extractor(out);
+    e.accept(extractor);
+}
+
+std::string to_plain_text(const element &e)
+{
+    std::string r;
+    {
+        output_buffer out([&](const char *data, std::size_t size) { r.append(data, size); });
+        extract_text(e, out);
+        out.flush();
+    }
+    return r;
+}
+}
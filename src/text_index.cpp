@@ -0,0 +1,254 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <algorithm>
+#include <unordered_set>
+
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/text_index.h"
+
+namespace docsmith
+{
+namespace
+{
+bool is_word_byte(unsigned char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+bool is_block(const element &e) { return e.is_type(elem_t::p) || e.is_type(elem_t::h); }
+
+template <typename E>
+E *nearest_block(E &e)
+{
+    for(auto *p = &e; p; p = p->parent())
+        if(is_block(*p))
+            return p;
+    return nullptr;
+}
+
+char fold(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+/// Call fn(token, offset) for every token in s
+template <typename Fn>
+void for_each_token(std::string_view s, Fn &&fn)
+{
+    std::size_t i = 0;
+    while(i < s.size())
+    {
+        while(i < s.size() && !is_word_byte(static_cast<unsigned char>(s[i])))
+            ++i;
+        auto start = i;
+        while(i < s.size() && is_word_byte(static_cast<unsigned char>(s[i])))
+            ++i;
+        if(i > start)
+            fn(s.substr(start, i - start), start);
+    }
+}
+}
+
+template <typename Element>
+std::string basic_text_index<Element>::normalise(std::string_view term)
+{
+    std::string r(term);
+    std::transform(r.begin(), r.end(), r.begin(), fold);
+    return r;
+}
+
+template <typename Element>
+void basic_text_index<Element>::build(Element &root)
+{
+    m_postings.clear();
+    m_nodes.clear();
+    m_kids.clear();
+    index(root, nullptr);
+}
+
+template <typename Element>
+const std::vector<typename basic_text_index<Element>::posting> &basic_text_index<Element>::find(
+    std::string_view term) const
+{
+    static const std::vector<posting> none;
+    auto it = m_postings.find(normalise(term));
+    return it != m_postings.end() ? it->second : none;
+}
+
+template <typename Element>
+std::vector<Element *> basic_text_index<Element>::find_blocks(std::string_view term) const
+{
+    std::vector<Element *> blocks;
+    std::unordered_set<Element *> seen;
+    for(const auto &posting : find(term))
+    {
+        auto it = m_nodes.find(posting.m_node);
+        if(it != m_nodes.end() && it->second.m_block && seen.insert(it->second.m_block).second)
+            blocks.push_back(it->second.m_block);
+    }
+    return blocks;
+}
+
+template <typename Element>
+void basic_text_index<Element>::add(text_type &node, Element *block)
+{
+    auto [it, inserted] = m_nodes.try_emplace(&node);
+    auto &entry = it->second;
+    if(inserted && node.parent())
+        m_kids[node.parent()].push_back({&node, &node});
+    unindex_text(entry);
+    entry.m_block = block;
+    index_text(node, entry);
+}
+
+template <typename Element>
+void basic_text_index<Element>::update(text_type &node)
+{
+    auto it = m_nodes.find(&node);
+    if(it == m_nodes.end())
+        return add(node, nullptr);
+
+    unindex_text(it->second);
+    index_text(node, it->second);
+}
+
+template <typename Element>
+void basic_text_index<Element>::update(Element &origin, change_t kind)
+{
+    if(kind == change_t::style)
+        return; // Styles aren't indexed
+
+    auto *block = nearest_block(origin);
+    switch(kind)
+    {
+    case change_t::text:
+        index(block ? *block : origin, block);
+        break;
+    case change_t::added:
+        if(origin.parent())
+            m_kids[origin.parent()].push_back({&origin, dynamic_cast<const text *>(&origin)});
+        index(origin, block);
+        break;
+    case change_t::children:
+        // The old children are already destroyed, so they are found through m_kids
+        forget_below(&origin);
+        index(origin, block);
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename Element>
+void basic_text_index<Element>::remove(text_type &node)
+{
+    auto it = m_nodes.find(&node);
+    if(it == m_nodes.end())
+        return;
+    unindex_text(it->second);
+    m_nodes.erase(it);
+    if(auto parent = m_kids.find(node.parent()); parent != m_kids.end())
+        std::erase_if(parent->second, [&node](const kid &k) { return k.m_text == &node; });
+}
+
+template <typename Element>
+void basic_text_index<Element>::index(Element &e, Element *block)
+{
+    if(is_block(e))
+        block = &e;
+    else if(auto *t = dynamic_cast<text_type *>(&e))
+    {
+        // The node may already be indexed, when a change notification re-indexes its block:
+        auto &entry = m_nodes[t];
+        unindex_text(entry);
+        entry.m_block = block;
+        index_text(*t, entry);
+    }
+
+    if(auto *kids = e.child_list())
+    {
+        auto &recorded = m_kids[&e];
+        recorded.clear();
+        for(const auto &child : *kids)
+        {
+            recorded.push_back({child.get(), dynamic_cast<const text *>(child.get())});
+            index(*child, block);
+        }
+    }
+}
+
+template <typename Element>
+void basic_text_index<Element>::forget_below(const element *e)
+{
+    auto it = m_kids.find(e);
+    if(it == m_kids.end())
+        return;
+    auto kids = std::move(it->second);
+    m_kids.erase(it);
+    for(const auto &k : kids)
+    {
+        if(auto node = m_nodes.find(k.m_text); k.m_text && node != m_nodes.end())
+        {
+            unindex_text(node->second);
+            m_nodes.erase(node);
+        }
+        else
+            forget_below(k.m_element);
+    }
+}
+
+template <typename Element>
+void basic_text_index<Element>::index_text(text_type &node, node_entry &entry)
+{
+    std::string key;
+    for_each_token(node.m_text,
+        [&](std::string_view token, std::size_t offset)
+        {
+            key.assign(token);
+            std::transform(key.begin(), key.end(), key.begin(), fold);
+            auto [it, inserted] = m_postings.try_emplace(key);
+            entry.m_postings.push_back({&it->first, it->second.size()});
+            it->second.push_back({&node, offset});
+        });
+}
+
+template <typename Element>
+void basic_text_index<Element>::unindex_text(node_entry &entry)
+{
+    // Each occurrence is replaced by the last one of its list, whose node's record of where it is
+    // is then corrected. Records are dropped as they are handled, so only current ones are found.
+    while(!entry.m_postings.empty())
+    {
+        auto [term, index] = entry.m_postings.back();
+        entry.m_postings.pop_back();
+
+        auto it = m_postings.find(*term);
+        auto &list = it->second;
+        auto last = list.size() - 1;
+        if(index != last)
+        {
+            list[index] = list[last];
+            auto &moved = m_nodes.find(list[index].m_node)->second.m_postings;
+            std::find(moved.begin(), moved.end(), std::pair{term, last})->second = index;
+        }
+        list.pop_back();
+        if(list.empty())
+            m_postings.erase(it);
+    }
+}
+
+template class basic_text_index<element>;
+template class basic_text_index<const element>;
+}
@@ -0,0 +1,336 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define DOCSMITH_SEARCH_SSE2 1
+// The AVX2 kernel is compiled for its own target and chosen at run time, so the build doesn't have
+// to assume AVX2. flatten inlines the shared kernel template into the AVX2 entry point, so all of
+// it is generated as AVX2 code.
+#if defined(__GNUC__) || defined(__clang__)
+#define DOCSMITH_SEARCH_AVX2 1
+#define DOCSMITH_TARGET_AVX2 __attribute__((target("avx2")))
+#define DOCSMITH_TARGET_AVX2_ENTRY __attribute__((target("avx2"), flatten))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define DOCSMITH_SEARCH_AVX2 1
+#define DOCSMITH_TARGET_AVX2
+#define DOCSMITH_TARGET_AVX2_ENTRY
+#endif
+#endif
+
+#include "docsmithcpp/text.h"
+#include "docsmithcpp/text_search.h"
+
+namespace docsmith
+{
+namespace
+{
+char fold(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+bool equal_folded(const char *a, const char *b, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; ++i)
+        if(fold(a[i]) != fold(b[i]))
+            return false;
+    return true;
+}
+
+/// Does the needle occur at h? The first and last characters have already been checked.
+bool verify(const char *h, std::string_view needle, bool case_insensitive)
+{
+    if(needle.size() <= 2)
+        return true;
+    return case_insensitive ? equal_folded(h + 1, needle.data() + 1, needle.size() - 2)
+                            : std::memcmp(h + 1, needle.data() + 1, needle.size() - 2) == 0;
+}
+
+std::size_t find_scalar(
+    std::string_view haystack, std::string_view needle, std::size_t from, bool case_insensitive)
+{
+    if(!case_insensitive)
+        return haystack.find(needle, from);
+
+    for(std::size_t i = from; i + needle.size() <= haystack.size(); ++i)
+        if(equal_folded(haystack.data() + i, needle.data(), needle.size()))
+            return i;
+    return std::string_view::npos;
+}
+
+// The vector kernels compare a block of haystack starting at i with the first needle character,
+// and the block starting at i + size - 1 with the last one. Candidate positions, where both
+// match, are then verified. This filters out almost every position with two compares.
+//
+// Vectors go to and from the ops by reference. Unless find_vector() is inlined into find_avx2()
+// (e.g. in unoptimised builds) it is compiled without AVX, and passing AVX vectors by value between
+// it and the AVX2 ops would disagree on the calling convention.
+#if defined(DOCSMITH_SEARCH_SSE2)
+struct sse2_ops
+{
+    static constexpr std::size_t block = 16;
+    using vec = __m128i;
+    static void splat(vec &v, char c) { v = _mm_set1_epi8(c); }
+    static void load(vec &v, const char *p)
+    {
+        v = _mm_loadu_si128(reinterpret_cast<const vec *>(p));
+    }
+    static std::uint32_t eq_mask(const vec &a, const vec &b)
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+    }
+    static void to_lower(vec &v)
+    {
+        // Bytes are signed, so non-ASCII bytes (negative) are never in 'A'..'Z':
+        auto upper = _mm_and_si128(
+            _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v));
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    }
+};
+#endif
+
+#if defined(DOCSMITH_SEARCH_AVX2)
+struct avx2_ops
+{
+    static constexpr std::size_t block = 32;
+    using vec = __m256i;
+    DOCSMITH_TARGET_AVX2 static void splat(vec &v, char c) { v = _mm256_set1_epi8(c); }
+    DOCSMITH_TARGET_AVX2 static void load(vec &v, const char *p)
+    {
+        v = _mm256_loadu_si256(reinterpret_cast<const vec *>(p));
+    }
+    DOCSMITH_TARGET_AVX2 static std::uint32_t eq_mask(const vec &a, const vec &b)
+    {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+    }
+    DOCSMITH_TARGET_AVX2 static void to_lower(vec &v)
+    {
+        auto upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+        v = _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+    }
+};
+
+/// Can the CPU and OS run AVX2 code?
+bool cpu_has_avx2()
+{
+#if defined(__AVX2__)
+    return true;
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#else
+    // AVX (leaf 1) with the OS saving the YMM registers (XCR0), then AVX2 (leaf 7):
+    int info[4];
+    __cpuid(info, 1);
+    constexpr int osxsave = 1 << 27, avx = 1 << 28;
+    if((info[2] & (osxsave | avx)) != (osxsave | avx) || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif
+
+#if defined(DOCSMITH_SEARCH_SSE2)
+template <typename Ops, bool CaseInsensitive>
+std::size_t find_vector(std::string_view haystack, std::string_view needle, std::size_t from)
+{
+    const char *h = haystack.data();
+    const std::size_t n = haystack.size();
+    const std::size_t last = needle.size() - 1;
+    typename Ops::vec first, final, a, b;
+    Ops::splat(first, CaseInsensitive ? fold(needle.front()) : needle.front());
+    Ops::splat(final, CaseInsensitive ? fold(needle.back()) : needle.back());
+
+    std::size_t i = from;
+    for(; i + last + Ops::block <= n; i += Ops::block)
+    {
+        Ops::load(a, h + i);
+        Ops::load(b, h + i + last);
+        if constexpr(CaseInsensitive)
+        {
+            Ops::to_lower(a);
+            Ops::to_lower(b);
+        }
+        for(auto mask = Ops::eq_mask(a, first) & Ops::eq_mask(b, final); mask != 0;
+            mask &= mask - 1)
+        {
+            auto pos = i + static_cast<std::size_t>(std::countr_zero(mask));
+            if(verify(h + pos, needle, CaseInsensitive))
+                return pos;
+        }
+    }
+    // Fewer than a block of candidate positions left:
+    return find_scalar(haystack, needle, i, CaseInsensitive);
+}
+
+std::size_t find_sse2(
+    std::string_view haystack, std::string_view needle, std::size_t from, bool case_insensitive)
+{
+    return case_insensitive ? find_vector<sse2_ops, true>(haystack, needle, from)
+                            : find_vector<sse2_ops, false>(haystack, needle, from);
+}
+#endif
+
+#if defined(DOCSMITH_SEARCH_AVX2)
+DOCSMITH_TARGET_AVX2_ENTRY std::size_t find_avx2(
+    std::string_view haystack, std::string_view needle, std::size_t from, bool case_insensitive)
+{
+    return case_insensitive ? find_vector<avx2_ops, true>(haystack, needle, from)
+                            : find_vector<avx2_ops, false>(haystack, needle, from);
+}
+#endif
+
+/// E is element or const element
+template <typename E>
+void find_in_tree(E &e, std::string_view needle, const search_options &options,
+    std::vector<basic_text_hit<const_like_t<E, text>>> &hits)
+{
+    // Check the tag first: a cross cast through the virtual base is costly and most nodes aren't text
+    if(e.is_type(elem_t::t))
+    {
+        auto *t = dynamic_cast<const_like_t<E, text> *>(&e);
+        for(auto pos = find_substring(t->m_text, needle, 0, options.m_case_insensitive);
+            pos != std::string::npos;
+            pos = find_substring(t->m_text, needle, pos + needle.size(), options.m_case_insensitive))
+            hits.push_back({t, pos});
+    }
+    if(auto *kids = e.child_list())
+        for(const auto &child : *kids)
+            find_in_tree(static_cast<E &>(*child), needle, options, hits);
+}
+
+template <typename E>
+std::vector<basic_text_hit<const_like_t<E, text>>> find_text_below(
+    E &root, std::string_view needle, const search_options &options)
+{
+    if(needle.empty())
+        throw std::invalid_argument("Cannot search for an empty string");
+    if(!is_valid_utf8(needle))
+        throw std::invalid_argument("Search text is not valid UTF-8");
+
+    std::vector<basic_text_hit<const_like_t<E, text>>> hits;
+    find_in_tree(root, needle, options, hits);
+    return hits;
+}
+}
+
+bool is_supported(search_kernel kernel)
+{
+    switch(kernel)
+    {
+    case search_kernel::scalar:
+        return true;
+    case search_kernel::sse2:
+#if defined(DOCSMITH_SEARCH_SSE2)
+        return true;
+#else
+        return false;
+#endif
+    case search_kernel::avx2:
+#if defined(DOCSMITH_SEARCH_AVX2)
+    {
+        static const bool supported = cpu_has_avx2();
+        return supported;
+    }
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+std::size_t find_substring(
+    std::string_view haystack, std::string_view needle, std::size_t from, bool case_insensitive)
+{
+    static const search_kernel best = is_supported(search_kernel::avx2) ? search_kernel::avx2
+                                      : is_supported(search_kernel::sse2) ? search_kernel::sse2
+                                                                          : search_kernel::scalar;
+    return find_substring(best, haystack, needle, from, case_insensitive);
+}
+
+std::size_t find_substring(search_kernel kernel, std::string_view haystack,
+    std::string_view needle, std::size_t from, bool case_insensitive)
+{
+    if(!is_supported(kernel))
+        throw std::invalid_argument("Search kernel is not supported on this machine");
+    if(needle.empty())
+        return from <= haystack.size() ? from : std::string_view::npos;
+    if(from > haystack.size() || haystack.size() - from < needle.size())
+        return std::string_view::npos;
+
+    switch(kernel)
+    {
+#if defined(DOCSMITH_SEARCH_AVX2)
+    case search_kernel::avx2:
+        return find_avx2(haystack, needle, from, case_insensitive);
+#endif
+#if defined(DOCSMITH_SEARCH_SSE2)
+    case search_kernel::sse2:
+        return find_sse2(haystack, needle, from, case_insensitive);
+#endif
+    default:
+        return find_scalar(haystack, needle, from, case_insensitive);
+    }
+}
+
+std::vector<text_hit> find_text(
+    element &root, std::string_view needle, const search_options &options)
+{
+    return find_text_below(root, needle, options);
+}
+
+std::vector<const_text_hit> find_text(
+    const element &root, std::string_view needle, const search_options &options)
+{
+    return find_text_below(root, needle, options);
+}
+
+bool is_valid_utf8(std::string_view s)
+{
+    for(std::size_t i = 0; i < s.size();)
+    {
+        auto c = static_cast<unsigned char>(s[i]);
+        std::size_t len = c < 0x80 ? 1
+            : (c >> 5) == 0x06     ? 2
+            : (c >> 4) == 0x0e     ? 3
+            : (c >> 3) == 0x1e     ? 4
+                                   : 0;
+        if(len == 0 || i + len > s.size())
+            return false;
+
+        std::uint32_t cp = len == 1 ? c : c & (0x7f >> len);
+        for(std::size_t k = 1; k < len; ++k)
+        {
+            auto cc = static_cast<unsigned char>(s[i + k]);
+            if((cc & 0xc0) != 0x80)
+                return false;
+            cp = (cp << 6) | (cc & 0x3f);
+        }
+        // Reject overlong encodings, surrogates and values beyond U+10FFFF:
+        static constexpr std::uint32_t min_cp[] = {0, 0, 0x80, 0x800, 0x10000};
+        if(cp < min_cp[len] || (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff)
+            return false;
+        i += len;
+    }
+    return true;
+}
+}
@@ -0,0 +1,70 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <thread>
+
+#include "docsmithcpp/versioned_doc.h"
+
+namespace docsmith
+{
+versioned_doc::versioned_doc(text_doc doc) :
+    m_latest(new version_ptr(std::make_shared<const doc_version>(doc_version{1, std::move(doc)})))
+{
+}
+
+versioned_doc::~versioned_doc() { delete m_latest.load(); }
+
+std::shared_ptr<const doc_version> versioned_doc::latest() const
+{
+    // Count this reader under the current epoch. If a publish changed the epoch meanwhile, its
+    // writer may already have checked the count, so count again under the new one.
+    for(;;)
+    {
+        auto epoch = m_epoch.load();
+        m_readers[epoch % 2].fetch_add(1);
+        if(m_epoch.load() == epoch)
+        {
+            auto v = *m_latest.load();
+            m_readers[epoch % 2].fetch_sub(1);
+            return v;
+        }
+        m_readers[epoch % 2].fetch_sub(1);
+    }
+}
+
+std::uint64_t versioned_doc::publish(text_doc doc)
+{
+    std::lock_guard lock(m_write_mutex);
+    return publish_locked(std::move(doc));
+}
+
+std::uint64_t versioned_doc::publish_locked(text_doc doc)
+{
+    const auto *previous = m_latest.load();
+    auto number = (*previous)->m_number + 1;
+    m_latest.store(
+        new version_ptr(std::make_shared<const doc_version>(doc_version{number, std::move(doc)})));
+
+    // Readers that may have loaded previous counted themselves under the old epoch. Later ones
+    // count under the new epoch, and see the new version.
+    auto epoch = m_epoch.fetch_add(1);
+    while(m_readers[epoch % 2].load() != 0)
+        std::this_thread::yield();
+    delete previous; // Snapshots of that version keep it alive
+    return number;
+}
+}
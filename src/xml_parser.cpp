@@ -0,0 +1,311 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+
+#include "docsmithcpp/xml_parser.h"
+
+namespace docsmith
+{
+namespace
+{
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+void append_utf8(std::string &out, char32_t cp)
+{
+    if(cp < 0x80)
+        out += static_cast<char>(cp);
+    else if(cp < 0x800)
+    {
+        out += static_cast<char>(0xC0 | cp >> 6);
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if(cp < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | cp >> 12);
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | cp >> 18);
+        out += static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+}
+
+std::string_view find_attribute(
+    std::span<const xml_attribute> attributes, std::string_view name, std::string_view fallback)
+{
+    for(const auto &a : attributes)
+        if(a.m_name == name)
+            return a.m_value;
+    return fallback;
+}
+
+xml_parser::xml_parser(xml_handler &handler) :
+    m_handler(handler)
+{
+}
+
+void xml_parser::feed(std::string_view data)
+{
+    if(m_pending.empty())
+    {
+        auto used = parse(data, false);
+        m_pending.assign(data.substr(used));
+        m_offset += used;
+        return;
+    }
+    m_pending.append(data);
+    auto used = parse(m_pending, false);
+    m_pending.erase(0, used);
+    m_offset += used;
+}
+
+void xml_parser::finish()
+{
+    auto used = parse(m_pending, true);
+    m_offset += used;
+    m_pending.clear();
+    if(m_depth > 0)
+        fail("element <" + m_open[m_depth - 1] + "> is not closed", 0);
+}
+
+std::size_t xml_parser::parse(std::string_view data, bool final)
+{
+    std::size_t pos = 0;
+    while(pos < data.size())
+    {
+        if(data[pos] != '<')
+        {
+            auto end = data.find('<', pos);
+            if(end == std::string_view::npos)
+            {
+                end = data.size();
+                // Hold back a reference that may continue in the next chunk
+                if(auto amp = data.rfind('&'); !final && amp != std::string_view::npos &&
+                    amp >= pos && data.find(';', amp) == std::string_view::npos)
+                    end = amp;
+            }
+            if(end == pos)
+                break;
+            text(data.substr(pos, end - pos));
+            pos = end;
+            continue;
+        }
+
+        auto rest = data.substr(pos);
+        if(rest.size() < 9 && !final && rest.starts_with("<!"))
+            break; // Can't tell a comment from CDATA yet
+
+        std::size_t end;
+        if(rest.starts_with("<!--"))
+        {
+            if((end = data.find("-->", pos + 4)) == std::string_view::npos)
+                break;
+            pos = end + 3;
+        }
+        else if(rest.starts_with("<![CDATA["))
+        {
+            if((end = data.find("]]>", pos + 9)) == std::string_view::npos)
+                break;
+            if(m_depth > 0 && end > pos + 9)
+                m_handler.characters(data.substr(pos + 9, end - pos - 9));
+            pos = end + 3;
+        }
+        else if(rest.starts_with("<?"))
+        {
+            if((end = data.find("?>", pos + 2)) == std::string_view::npos)
+                break;
+            pos = end + 2;
+        }
+        else if(rest.starts_with("<!"))
+        {
+            // A DOCTYPE, whose internal subset can contain '>'
+            auto open = data.find('[', pos);
+            auto close = data.find('>', pos);
+            if(open != std::string_view::npos && open < close)
+                close = data.find("]>", open);
+            if(close == std::string_view::npos)
+                break;
+            pos = data.find('>', close) + 1;
+        }
+        else if(rest.starts_with("</"))
+        {
+            if((end = data.find('>', pos)) == std::string_view::npos)
+                break;
+            end_tag(data.substr(pos + 2, end - pos - 2));
+            pos = end + 1;
+        }
+        else
+        {
+            // '>' can appear in attribute values
+            char quote = 0;
+            for(end = pos + 1; end < data.size(); ++end)
+            {
+                char c = data[end];
+                if(quote)
+                    quote = c == quote ? 0 : quote;
+                else if(c == '"' || c == '\'')
+                    quote = c;
+                else if(c == '>')
+                    break;
+            }
+            if(end == data.size())
+                break;
+            start_tag(data.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+        }
+    }
+    if(final && pos < data.size())
+        fail("unterminated markup", pos);
+    return pos;
+}
+
+void xml_parser::start_tag(std::string_view tag)
+{
+    bool empty = tag.ends_with('/');
+    if(empty)
+        tag.remove_suffix(1);
+
+    std::size_t i = 0;
+    while(i < tag.size() && !is_space(tag[i]))
+        ++i;
+    auto name = tag.substr(0, i);
+    if(name.empty())
+        fail("element without a name", 0);
+
+    m_values.clear();
+    m_value_spans.clear();
+    m_attributes.clear();
+    while(true)
+    {
+        while(i < tag.size() && is_space(tag[i]))
+            ++i;
+        if(i == tag.size())
+            break;
+        auto name_start = i;
+        while(i < tag.size() && tag[i] != '=' && !is_space(tag[i]))
+            ++i;
+        auto attr_name = tag.substr(name_start, i - name_start);
+        while(i < tag.size() && is_space(tag[i]))
+            ++i;
+        if(i == tag.size() || tag[i] != '=')
+            fail("attribute " + std::string(attr_name) + " without a value", 0);
+        ++i;
+        while(i < tag.size() && is_space(tag[i]))
+            ++i;
+        if(i == tag.size() || (tag[i] != '"' && tag[i] != '\''))
+            fail("attribute value is not quoted", 0);
+        auto close = tag.find(tag[i], i + 1);
+        if(close == std::string_view::npos)
+            fail("unterminated attribute value", 0);
+
+        // Views are made once all values are decoded, as m_values may move as it grows
+        auto start = m_values.size();
+        decode(tag.substr(i + 1, close - i - 1), m_values);
+        m_value_spans.emplace_back(start, m_values.size() - start);
+        m_attributes.push_back({attr_name, {}});
+        i = close + 1;
+    }
+    for(std::size_t a = 0; a < m_attributes.size(); ++a)
+        m_attributes[a].m_value =
+            std::string_view(m_values).substr(m_value_spans[a].first, m_value_spans[a].second);
+
+    m_handler.start_element(name, m_attributes);
+    if(empty)
+    {
+        m_handler.end_element(name);
+        return;
+    }
+    if(m_open.size() == m_depth)
+        m_open.emplace_back();
+    m_open[m_depth++].assign(name);
+}
+
+void xml_parser::end_tag(std::string_view tag)
+{
+    while(!tag.empty() && is_space(tag.back()))
+        tag.remove_suffix(1);
+    if(m_depth == 0 || m_open[m_depth - 1] != tag)
+        fail("unexpected </" + std::string(tag) + ">", 0);
+    --m_depth;
+    m_handler.end_element(tag);
+}
+
+void xml_parser::text(std::string_view raw)
+{
+    if(m_depth == 0)
+        return; // Whitespace around the root element
+    if(raw.find('&') == std::string_view::npos)
+        return m_handler.characters(raw);
+    m_text.clear();
+    decode(raw, m_text);
+    m_handler.characters(m_text);
+}
+
+void xml_parser::decode(std::string_view raw, std::string &out)
+{
+    while(true)
+    {
+        auto amp = raw.find('&');
+        out.append(raw.substr(0, amp));
+        if(amp == std::string_view::npos)
+            return;
+        auto semi = raw.find(';', amp);
+        if(semi == std::string_view::npos)
+            fail("unterminated reference", 0);
+        auto ref = raw.substr(amp + 1, semi - amp - 1);
+        if(ref == "lt")
+            out += '<';
+        else if(ref == "gt")
+            out += '>';
+        else if(ref == "amp")
+            out += '&';
+        else if(ref == "quot")
+            out += '"';
+        else if(ref == "apos")
+            out += '\'';
+        else if(ref.starts_with('#'))
+        {
+            bool hex = ref.size() > 1 && ref[1] == 'x';
+            auto digits = ref.substr(hex ? 2 : 1);
+            std::uint32_t cp = 0;
+            auto [end, ec] =
+                std::from_chars(digits.data(), digits.data() + digits.size(), cp, hex ? 16 : 10);
+            if(digits.empty() || ec != std::errc() || end != digits.data() + digits.size() ||
+                cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000))
+                fail("invalid character reference &" + std::string(ref) + ";", 0);
+            append_utf8(out, cp);
+        }
+        else
+            fail("unknown entity &" + std::string(ref) + ";", 0);
+        raw.remove_prefix(semi + 1);
+    }
+}
+
+void xml_parser::fail(std::string_view what, std::size_t pos) const
+{
+    throw std::runtime_error(
+        "XML error near offset " + std::to_string(m_offset + pos) + ": " + std::string(what));
+}
+}
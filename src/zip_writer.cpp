@@ -0,0 +1,501 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <zlib.h>
+
+#include "docsmithcpp/bounded_queue.h"
+#include "docsmithcpp/zip_writer.h"
+
+namespace docsmith
+{
+namespace
+{
+constexpr std::uint32_t local_header_sig = 0x04034b50;
+constexpr std::uint32_t central_header_sig = 0x02014b50;
+constexpr std::uint32_t end_of_central_dir_sig = 0x06054b50;
+constexpr std::uint32_t data_descriptor_sig = 0x08074b50;
+constexpr std::uint16_t flag_data_descriptor = 0x0008; // General purpose bit 3
+constexpr std::uint16_t version_needed = 20;  // 2.0: deflate
+constexpr std::uint16_t flag_utf8_name = 0x0800; // General purpose bit 11
+
+// No zip64 support, so sizes and offsets must fit in the classic 32 bit fields:
+constexpr std::uint64_t max_size = std::numeric_limits<std::uint32_t>::max();
+
+void put16(std::string &out, std::uint16_t v)
+{
+    out.push_back(static_cast<char>(v & 0xff));
+    out.push_back(static_cast<char>((v >> 8) & 0xff));
+}
+
+void put32(std::string &out, std::uint32_t v)
+{
+    put16(out, static_cast<std::uint16_t>(v & 0xffff));
+    put16(out, static_cast<std::uint16_t>(v >> 16));
+}
+
+std::uint32_t checked32(std::uint64_t v)
+{
+    if(v > max_size)
+        throw std::runtime_error("Archive exceeds 4 GiB, zip64 is not supported");
+    return static_cast<std::uint32_t>(v);
+}
+}
+
+std::uint32_t crc32(std::string_view data, std::uint32_t crc)
+{
+    // zlib takes a uInt length, so feed very large buffers in pieces:
+    constexpr std::size_t max_chunk = std::numeric_limits<uInt>::max();
+    auto p = reinterpret_cast<const Bytef *>(data.data());
+    for(std::size_t remaining = data.size(); remaining > 0;)
+    {
+        auto n = static_cast<uInt>(std::min(remaining, max_chunk));
+        crc = static_cast<std::uint32_t>(::crc32(crc, p, n));
+        p += n;
+        remaining -= n;
+    }
+    return crc;
+}
+
+std::string deflate(std::string_view data)
+{
+    z_stream zs{};
+    // Negative window bits: raw deflate without the zlib header / trailer, as zip expects.
+    if(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("Could not initialise deflate");
+
+    std::string out(deflateBound(&zs, static_cast<uLong>(data.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef *>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+
+    int result = ::deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+    if(result != Z_STREAM_END)
+        throw std::runtime_error("Could not deflate archive entry");
+
+    out.resize(zs.total_out);
+    return out;
+}
+
+zip_entry make_zip_entry(std::string name, std::string_view data, zip_method method)
+{
+    zip_entry e;
+    e.m_name = std::move(name);
+    e.m_method = method;
+    e.m_crc = crc32(data);
+    e.m_size = data.size();
+    e.m_data = method == zip_method::deflate ? deflate(data) : std::string(data);
+    return e;
+}
+
+deflater::deflater() :
+    m_stream(std::make_unique<z_stream_s>()),
+    m_buffer(64 * 1024, '\0')
+{
+    auto result = deflateInit2(
+        m_stream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if(result != Z_OK)
+        throw std::runtime_error("Could not initialise deflate");
+}
+
+deflater::~deflater() { deflateEnd(m_stream.get()); }
+
+void deflater::write(const char *data, std::size_t size, const byte_sink &out)
+{
+    m_crc = crc32(std::string_view(data, size), m_crc);
+    m_size += size;
+
+    constexpr std::size_t max_chunk = std::numeric_limits<uInt>::max();
+    while(size > 0)
+    {
+        auto n = std::min(size, max_chunk);
+        m_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        m_stream->avail_in = static_cast<uInt>(n);
+        run(Z_NO_FLUSH, out);
+        data += n;
+        size -= n;
+    }
+}
+
+void deflater::finish(const byte_sink &out)
+{
+    m_stream->next_in = nullptr;
+    m_stream->avail_in = 0;
+    run(Z_FINISH, out);
+}
+
+void deflater::run(int flush, const byte_sink &out)
+{
+    // Deflate until zlib has consumed all input (or, when finishing, written the end of stream):
+    for(;;)
+    {
+        m_stream->next_out = reinterpret_cast<Bytef *>(m_buffer.data());
+        m_stream->avail_out = static_cast<uInt>(m_buffer.size());
+        int result = ::deflate(m_stream.get(), flush);
+        if(result == Z_STREAM_ERROR)
+            throw std::runtime_error("Could not deflate archive entry");
+
+        auto produced = m_buffer.size() - m_stream->avail_out;
+        if(produced > 0)
+            out(m_buffer.data(), produced);
+
+        if(flush == Z_FINISH ? result == Z_STREAM_END : m_stream->avail_out != 0)
+            return;
+    }
+}
+
+zip_writer::zip_writer(sink out) :
+    m_out(std::move(out))
+{
+    using namespace std::chrono;
+    auto now = system_clock::now();
+    auto today = floor<days>(now);
+    year_month_day ymd{today};
+    hh_mm_ss hms{floor<seconds>(now - today)};
+
+    // MS-DOS date and time, as used by the zip headers:
+    m_dos_date = static_cast<std::uint16_t>(((static_cast<int>(ymd.year()) - 1980) << 9) |
+                                            (static_cast<unsigned>(ymd.month()) << 5) |
+                                            static_cast<unsigned>(ymd.day()));
+    m_dos_time = static_cast<std::uint16_t>((hms.hours().count() << 11) |
+                                            (hms.minutes().count() << 5) |
+                                            (hms.seconds().count() / 2));
+}
+
+void zip_writer::add(const std::string &name, std::string_view data, zip_method method)
+{
+    add(make_zip_entry(name, data, method));
+}
+
+void zip_writer::add(const zip_entry &entry)
+{
+    check_can_add();
+
+    central_record r{entry.m_name,
+        entry.m_method,
+        flag_utf8_name,
+        entry.m_crc,
+        entry.m_data.size(),
+        entry.m_size,
+        m_offset};
+    write_local_header(r);
+    emit(entry.m_data);
+    m_records.push_back(std::move(r));
+}
+
+void zip_writer::begin_entry(const std::string &name, zip_method method)
+{
+    begin_streamed(name, method);
+
+    m_stored_crc = 0;
+    if(method == zip_method::deflate)
+        m_deflater = std::make_unique<deflater>();
+}
+
+void zip_writer::write(const char *data, std::size_t size)
+{
+    if(!m_open_entry)
+        throw std::logic_error("No archive entry has been started");
+
+    if(m_deflater)
+        m_deflater->write(data, size, [this](const char *d, std::size_t n) { emit(d, n); });
+    else
+    {
+        m_stored_crc = crc32(std::string_view(data, size), m_stored_crc);
+        m_open_entry->m_size += size;
+        emit(data, size);
+    }
+}
+
+void zip_writer::end_entry()
+{
+    if(!m_open_entry)
+        throw std::logic_error("No archive entry has been started");
+
+    if(m_deflater)
+    {
+        m_deflater->finish([this](const char *d, std::size_t n) { emit(d, n); });
+        end_streamed(m_deflater->crc(), m_deflater->size());
+        m_deflater.reset();
+    }
+    else
+        end_streamed(m_stored_crc, m_open_entry->m_size);
+}
+
+void zip_writer::begin_streamed(const std::string &name, zip_method method)
+{
+    check_can_add();
+
+    // CRC and sizes are not known yet, so they are left zero here and written after the data:
+    auto flags = static_cast<std::uint16_t>(flag_utf8_name | flag_data_descriptor);
+    m_open_entry = central_record{name, method, flags, 0, 0, 0, m_offset};
+    write_local_header(*m_open_entry);
+    m_data_start = m_offset;
+}
+
+void zip_writer::end_streamed(std::uint32_t crc, std::uint64_t size)
+{
+    auto &r = *m_open_entry;
+    r.m_crc = crc;
+    r.m_size = size;
+    r.m_compressed_size = m_offset - m_data_start;
+
+    std::string descriptor;
+    put32(descriptor, data_descriptor_sig);
+    put32(descriptor, r.m_crc);
+    put32(descriptor, checked32(r.m_compressed_size));
+    put32(descriptor, checked32(r.m_size));
+    emit(descriptor);
+
+    m_records.push_back(std::move(r));
+    m_open_entry.reset();
+}
+
+void zip_writer::add_pipelined(
+    const std::string &name, const entry_producer &produce, std::size_t max_chunks)
+{
+    constexpr std::size_t chunk_size = 64 * 1024;
+
+    begin_streamed(name, zip_method::deflate);
+
+    bounded_queue<std::string> uncompressed(max_chunks);
+    bounded_queue<std::string> compressed(max_chunks);
+    std::exception_ptr produce_error, deflate_error;
+    deflater d;
+
+    // Stage 1: produce the data, batched into chunks:
+    std::thread producer(
+        [&]
+        {
+            try
+            {
+                std::string chunk;
+                chunk.reserve(chunk_size);
+                produce(
+                    [&](const char *data, std::size_t size)
+                    {
+                        chunk.append(data, size);
+                        if(chunk.size() < chunk_size)
+                            return;
+                        if(!uncompressed.push(std::exchange(chunk, {})))
+                            throw std::runtime_error("Archive pipeline was cancelled");
+                        chunk.reserve(chunk_size);
+                    });
+                if(!chunk.empty())
+                    uncompressed.push(std::move(chunk));
+            }
+            catch(...)
+            {
+                produce_error = std::current_exception();
+            }
+            uncompressed.close();
+        });
+
+    // Stage 2: deflate:
+    std::thread compressor(
+        [&]
+        {
+            try
+            {
+                std::string out;
+                auto collect = [&out](const char *data, std::size_t size) { out.append(data, size); };
+                auto pass_on = [&]
+                {
+                    if(!out.empty() && !compressed.push(std::move(out)))
+                        throw std::runtime_error("Archive pipeline was cancelled");
+                    out.clear();
+                };
+                while(auto chunk = uncompressed.pop())
+                {
+                    d.write(chunk->data(), chunk->size(), collect);
+                    pass_on();
+                }
+                if(!produce_error)
+                {
+                    d.finish(collect);
+                    pass_on();
+                }
+            }
+            catch(...)
+            {
+                deflate_error = std::current_exception();
+                uncompressed.close();
+            }
+            compressed.close();
+        });
+
+    // Stage 3: write. If the sink throws, close the queues so the other stages stop:
+    std::exception_ptr write_error;
+    try
+    {
+        while(auto chunk = compressed.pop())
+            emit(*chunk);
+    }
+    catch(...)
+    {
+        write_error = std::current_exception();
+        uncompressed.close();
+        compressed.close();
+    }
+    producer.join();
+    compressor.join();
+
+    // Later stages only fail because of an earlier one when they were cancelled, so report the
+    // error furthest down the pipeline:
+    for(auto &error : {write_error, deflate_error, produce_error})
+        if(error)
+        {
+            m_open_entry.reset();
+            std::rethrow_exception(error);
+        }
+
+    end_streamed(d.crc(), d.size());
+}
+
+void zip_writer::finish()
+{
+    if(m_finished)
+        return;
+    if(m_open_entry)
+        end_entry();
+    if(m_records.size() > std::numeric_limits<std::uint16_t>::max())
+        throw std::runtime_error("Too many archive entries, zip64 is not supported");
+
+    std::uint64_t central_dir_offset = m_offset;
+    std::string header;
+    for(const auto &r : m_records)
+    {
+        header.clear();
+        put32(header, central_header_sig);
+        put16(header, version_needed); // Version made by
+        put16(header, version_needed);
+        put16(header, r.m_flags);
+        put16(header, static_cast<std::uint16_t>(r.m_method));
+        put16(header, m_dos_time);
+        put16(header, m_dos_date);
+        put32(header, r.m_crc);
+        put32(header, checked32(r.m_compressed_size));
+        put32(header, checked32(r.m_size));
+        put16(header, static_cast<std::uint16_t>(r.m_name.size()));
+        put16(header, 0); // Extra field length
+        put16(header, 0); // Comment length
+        put16(header, 0); // Disk number
+        put16(header, 0); // Internal attributes
+        put32(header, 0); // External attributes
+        put32(header, checked32(r.m_offset));
+        header += r.m_name;
+        emit(header);
+    }
+    std::uint64_t central_dir_size = m_offset - central_dir_offset;
+
+    auto count = static_cast<std::uint16_t>(m_records.size());
+    header.clear();
+    put32(header, end_of_central_dir_sig);
+    put16(header, 0); // This disk
+    put16(header, 0); // Disk with the central directory
+    put16(header, count);
+    put16(header, count);
+    put32(header, checked32(central_dir_size));
+    put32(header, checked32(central_dir_offset));
+    put16(header, 0); // Comment length
+    emit(header);
+
+    m_finished = true;
+}
+
+void zip_writer::write_local_header(const central_record &r)
+{
+    std::string header;
+    header.reserve(30 + r.m_name.size());
+    put32(header, local_header_sig);
+    put16(header, version_needed);
+    put16(header, r.m_flags);
+    put16(header, static_cast<std::uint16_t>(r.m_method));
+    put16(header, m_dos_time);
+    put16(header, m_dos_date);
+    put32(header, r.m_crc);
+    put32(header, checked32(r.m_compressed_size));
+    put32(header, checked32(r.m_size));
+    put16(header, static_cast<std::uint16_t>(r.m_name.size()));
+    put16(header, 0); // Extra field length
+    header += r.m_name;
+    emit(header);
+}
+
+void zip_writer::check_can_add() const
+{
+    if(m_finished)
+        throw std::logic_error("Cannot add entries to a finished archive");
+    if(m_open_entry)
+        throw std::logic_error("The previous archive entry has not been ended");
+}
+
+void zip_writer::emit(const char *data, std::size_t size)
+{
+    if(size == 0)
+        return;
+    m_out(data, size);
+    m_offset += size;
+}
+
+void write_zip(const std::string &filename, const archive_filler &fill)
+{
+    namespace fs = std::filesystem;
+    fs::path parent_path = fs::path(filename).parent_path();
+    if(!parent_path.empty() && !fs::exists(parent_path))
+        fs::create_directories(parent_path);
+
+    std::ofstream file(filename, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Unable to create " + filename + " for writing");
+
+    write_zip(file, fill);
+}
+
+void write_zip(std::ostream &os, const archive_filler &fill)
+{
+    zip_writer zip([&os](const char *data, std::size_t size)
+        { os.write(data, static_cast<std::streamsize>(size)); });
+    fill(zip);
+
+    if(!os.flush())
+        throw std::runtime_error("Could not write archive");
+}
+
+std::vector<std::byte> write_zip(const archive_filler &fill)
+{
+    std::vector<std::byte> archive;
+    zip_writer zip(
+        [&archive](const char *data, std::size_t size)
+        {
+            auto bytes = reinterpret_cast<const std::byte *>(data);
+            archive.insert(archive.end(), bytes, bytes + size);
+        });
+    fill(zip);
+    return archive;
+}
+}
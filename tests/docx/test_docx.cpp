@@ -0,0 +1,394 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "docsmithcpp/archive_reader.h"
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/docx/file.h"
+#include "docsmithcpp/docx/reader.h"
+#include "docsmithcpp/docx/writer.h"
+#include "docsmithcpp/odt/file.h"
+#include "docsmithcpp/odt/to_docx.h"
+#include "docsmithcpp/xml_parser.h"
+
+using namespace docsmith;
+using par = paragraph;
+
+namespace
+{
+/// Records events as text, to compare parses of the same document fed in different chunks
+struct recorder : xml_handler
+{
+    void start_element(std::string_view name, std::span<const xml_attribute> attributes) override
+    {
+        (m_events += '<') += name;
+        for(const auto &a : attributes)
+            ((((m_events += ' ') += a.m_name) += '=') += a.m_value);
+        m_events += '>';
+    }
+    void end_element(std::string_view name) override { (m_events += "</") += name; }
+    void characters(std::string_view text) override { m_events += text; }
+    std::string m_events;
+};
+
+/// The text of each paragraph and heading, which survives conversion whatever the runs become
+std::vector<std::string> block_texts(const text_doc &doc)
+{
+    std::vector<std::string> texts;
+    for_each_block(
+        doc, [&texts](const element &block) { texts.push_back(const_block_text(block).str()); });
+    return texts;
+}
+
+std::string parse_in_chunks(std::string_view xml, std::size_t chunk)
+{
+    recorder r;
+    xml_parser parser(r);
+    for(std::size_t pos = 0; pos < xml.size(); pos += chunk)
+        parser.feed(xml.substr(pos, chunk));
+    parser.finish();
+    return r.m_events;
+}
+
+/// A package held in memory, fed to the reader a few bytes at a time
+docx::part_reader in_memory(const std::map<std::string, std::string> &parts)
+{
+    return [&parts](const std::string &name, const byte_sink &sink) {
+        auto it = parts.find(name);
+        if(it == parts.end())
+            return false;
+        for(std::size_t pos = 0; pos < it->second.size(); pos += 7)
+            sink(it->second.data() + pos, std::min<std::size_t>(7, it->second.size() - pos));
+        return true;
+    };
+}
+}
+
+TEST(XML_PARSER, ChunkBoundaries)
+{
+    std::string xml = "<?xml version=\"1.0\"?>\n<!DOCTYPE d [<!ENTITY x \"y\">]>\n"
+                      "<w:d a=\"1 &gt; 0\" b='&#x41;&#66;'><!-- <no/> --><e/>t&amp;u"
+                      "<![CDATA[<raw>]]><f x=\"a>b\">&lt;&#233;</f ></w:d>\n";
+    auto expected = "<w:d a=1 > 0 b=AB><e></et&u<raw><f x=a>b><\xc3\xa9</f</w:d";
+    for(std::size_t chunk : {1u, 2u, 3u, 5u, 8u, 13u, 1000u})
+    {
+        // Text may arrive in pieces, so compare with the pieces joined
+        EXPECT_EQ(parse_in_chunks(xml, chunk), expected) << "chunk " << chunk;
+    }
+
+    EXPECT_THROW(parse_in_chunks("<a><b></a>", 4), std::runtime_error);
+    EXPECT_THROW(parse_in_chunks("<a>", 4), std::runtime_error);
+    EXPECT_THROW(parse_in_chunks("<a>&bogus;</a>", 4), std::runtime_error);
+    EXPECT_THROW(parse_in_chunks("<a b=c/>", 4), std::runtime_error);
+}
+
+TEST(DOCX, ReadParts)
+{
+    const std::string w =
+        "xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"";
+    std::map<std::string, std::string> parts = {
+        {"_rels/.rels",
+            "<Relationships><Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/"
+            "officeDocument/2006/relationships/officeDocument\" Target=\"word/document.xml\"/>"
+            "</Relationships>"},
+        {"word/_rels/document.xml.rels",
+            "<Relationships>"
+            "<Relationship Id=\"rS\" Type=\".../styles\" Target=\"styles.xml\"/>"
+            "<Relationship Id=\"rN\" Type=\".../numbering\" Target=\"numbering.xml\"/>"
+            "<Relationship Id=\"rL\" Type=\".../hyperlink\" "
+            "Target=\"https://example.com/?a=1&amp;b=2\" TargetMode=\"External\"/>"
+            "<Relationship Id=\"rI\" Type=\".../image\" Target=\"media/../media/image1.png\"/>"
+            "</Relationships>"},
+        {"word/styles.xml",
+            "<w:styles " + w + ">"
+            "<w:style w:type=\"paragraph\" w:styleId=\"Heading1\"><w:name w:val=\"heading 1\"/>"
+            "<w:pPr><w:outlineLvl w:val=\"0\"/></w:pPr><w:rPr><w:sz w:val=\"32\"/></w:rPr>"
+            "</w:style>"
+            "<w:style w:type=\"paragraph\" w:styleId=\"Title1\"><w:basedOn w:val=\"Heading1\"/>"
+            "</w:style>"
+            "<w:style w:type=\"character\" w:styleId=\"Emphasis\"><w:rPr><w:i/>"
+            "<w:rFonts w:ascii=\"Arial\"/></w:rPr></w:style>"
+            "</w:styles>"},
+        {"word/numbering.xml",
+            "<w:numbering " + w + ">"
+            "<w:abstractNum w:abstractNumId=\"3\">"
+            "<w:lvl w:ilvl=\"0\"><w:start w:val=\"7\"/><w:numFmt w:val=\"decimal\"/>"
+            "<w:lvlText w:val=\"%1)\"/></w:lvl>"
+            "<w:lvl w:ilvl=\"1\"><w:numFmt w:val=\"bullet\"/><w:lvlText w:val=\"\xe2\x80\xa2\"/>"
+            "</w:lvl></w:abstractNum>"
+            "<w:num w:numId=\"1\"><w:abstractNumId w:val=\"3\"/></w:num>"
+            "</w:numbering>"},
+        {"word/document.xml",
+            "<w:document " + w + "><w:body>"
+            "<w:p><w:pPr><w:pStyle w:val=\"Title1\"/><w:rPr><w:rStyle w:val=\"X\"/></w:rPr></w:pPr>"
+            "<w:r><w:t>Title</w:t></w:r></w:p>"
+            "<w:p><w:r><w:t xml:space=\"preserve\">Plain </w:t></w:r>"
+            "<w:r><w:rPr><w:rStyle w:val=\"Emphasis\"/></w:rPr><w:t>styled</w:t><w:tab/>"
+            "<w:t>&amp; more</w:t></w:r>"
+            "<w:bookmarkStart w:id=\"0\" w:name=\"_GoBack\"/>"
+            "<w:bookmarkStart w:id=\"1\" w:name=\"B\"/>"
+            "<w:hyperlink r:id=\"rL\"><w:r><w:t>link</w:t></w:r></w:hyperlink>"
+            "<w:hyperlink w:anchor=\"B\"><w:r><w:t>back</w:t></w:r></w:hyperlink></w:p>"
+            "<w:p><w:pPr><w:numPr><w:ilvl w:val=\"0\"/><w:numId w:val=\"1\"/></w:numPr></w:pPr>"
+            "<w:r><w:t>seven</w:t></w:r></w:p>"
+            "<w:p><w:pPr><w:numPr><w:ilvl w:val=\"1\"/><w:numId w:val=\"1\"/></w:numPr></w:pPr>"
+            "<w:r><w:t>nested</w:t></w:r></w:p>"
+            "<w:p><w:pPr><w:numPr><w:ilvl w:val=\"0\"/><w:numId w:val=\"1\"/></w:numPr></w:pPr>"
+            "<w:r><w:t>eight</w:t></w:r></w:p>"
+            "<w:p><w:r><mc:AlternateContent><mc:Choice><w:drawing><a:blip r:embed=\"rI\"/>"
+            "</w:drawing></mc:Choice><mc:Fallback><w:pict><v:imagedata r:id=\"rI\"/></w:pict>"
+            "</mc:Fallback></mc:AlternateContent></w:r>"
+            "<w:del><w:r><w:delText>gone</w:delText></w:r></w:del></w:p>"
+            "<w:sectPr/></w:body></w:document>"}};
+
+    auto doc = docx::read(in_memory(parts));
+
+    text_doc expected{heading{1, span{text{"Title"}}}.set_style("Title1"),
+        par{span{text{"Plain "}}, span{text{"styled\t& more"}}.set_style("Emphasis"),
+            bookmark{"B"}, hyperlink{"https://example.com/?a=1&b=2", span{text{"link"}}},
+            hyperlink{"#B", span{text{"back"}}}},
+        list{list_item{par{span{text{"seven"}}}, list{list_item{par{span{text{"nested"}}}}}},
+            list_item{par{span{text{"eight"}}}}}
+            .set_style("WWNum1"),
+        par{frame{image{"word/media/image1.png"}}}};
+    EXPECT_EQ(doc, expected);
+
+    const auto *emphasis = doc.styles().find("Emphasis");
+    ASSERT_NE(emphasis, nullptr);
+    EXPECT_EQ(emphasis->m_text_props->m_font_style, font_style::italic);
+    EXPECT_EQ(emphasis->m_text_props->m_font_name->get_name(), "Arial");
+    EXPECT_EQ(doc.styles().find("Heading1")->m_text_props->m_font_size->m_points, 16.f);
+    EXPECT_EQ(doc.styles().find("Title1")->m_parent_style, style_name("Heading1"));
+
+    const auto *numbering = doc.list_styles().find("WWNum1");
+    ASSERT_NE(numbering, nullptr);
+    ASSERT_EQ(numbering->m_level_styles.size(), 2u);
+    const auto &first = std::get<list_style_num>(numbering->m_level_styles[0]);
+    EXPECT_EQ(first.m_start_from, 7);
+    EXPECT_EQ(first.m_num_suffix, ")");
+    EXPECT_EQ(
+        std::get<list_style_bullet>(numbering->m_level_styles[1]).m_bullet_char, "\xe2\x80\xa2");
+
+    parts.erase("word/document.xml");
+    EXPECT_THROW(docx::read(in_memory(parts)), std::runtime_error);
+}
+
+TEST(DOCX, WriteRoundTrip)
+{
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "docsmith_docx_write";
+    fs::create_directories(dir);
+
+    // Only the PNG header is read, for the size of the picture
+    auto picture = (dir / "Dot.PNG").string();
+    std::ofstream(picture, std::ios::binary)
+        .write("\x89PNG\r\n\x1a\n\0\0\0\x0dIHDR\0\0\0\x10\0\0\0\x08", 24);
+
+    text_doc doc{heading{1, "Title"}, par{"Tab\there\nand <b> & more"}.set_style("Quote"),
+        par{"Go ", span{text{"t"}, span{text{"o"}}}.set_style("Emphasis"), bookmark{"B"},
+            hyperlink{"https://example.com/?a=1&b=2", "out"}, hyperlink{"#B", "back"}},
+        list{list_item{par{"one"}, list{list_item{par{"nested"}}}}, list_item{par{"two"}}}
+            .set_style("Numbers"),
+        list{list_item{par{"again"}}}.set_style("Numbers"), par{frame{image{picture}}}};
+    doc.styles().add(style{"Quote", text_props{font_style::italic, font_size{12}}});
+    doc.styles().add(style{"Emphasis", text_props{font_name{"Arial"}}});
+    doc.list_styles().add(list_style{"Numbers",
+        {list_style_num(style{}, 1, list_enum::lower_roman, ")", 3),
+            list_style_bullet(style{}, 2, "-")}});
+
+    auto filename = (dir / "written.docx").string();
+    docx::writer::write(doc, filename);
+    auto actual = docx_file(filename).parse_text_doc();
+
+    // Runs come back as spans, and take the style of the innermost styled span
+    text_doc expected{heading{1, span{text{"Title"}}},
+        par{span{text{"Tab\there\nand <b> & more"}}}.set_style("Quote"),
+        par{span{text{"Go "}}, span{text{"t"}}.set_style("Emphasis"),
+            span{text{"o"}}.set_style("Emphasis"), bookmark{"B"},
+            hyperlink{"https://example.com/?a=1&b=2", span{text{"out"}}},
+            hyperlink{"#B", span{text{"back"}}}},
+        list{list_item{par{span{text{"one"}}}, list{list_item{par{span{text{"nested"}}}}}},
+            list_item{par{span{text{"two"}}}}},
+        list{list_item{par{span{text{"again"}}}}},
+        par{frame{image{"word/media/image1.png"}}}};
+    EXPECT_EQ(actual, expected);
+
+    const auto *quote = actual.styles().find("Quote");
+    ASSERT_NE(quote, nullptr);
+    EXPECT_EQ(quote->m_text_props->m_font_style, font_style::italic);
+    EXPECT_EQ(quote->m_text_props->m_font_size->m_points, 12.f);
+    EXPECT_EQ(actual.styles().find("Emphasis")->m_text_props->m_font_name->get_name(), "Arial");
+
+    // Each list is a numbering instance of its own, so the second one restarts
+    for(const char *name : {"WWNum1", "WWNum2"})
+    {
+        const auto *numbering = actual.list_styles().find(name);
+        ASSERT_NE(numbering, nullptr) << name;
+        ASSERT_EQ(numbering->m_level_styles.size(), 2u);
+        const auto &first = std::get<list_style_num>(numbering->m_level_styles[0]);
+        EXPECT_EQ(first.m_format, list_enum::lower_roman);
+        EXPECT_EQ(first.m_start_from, 3);
+        EXPECT_EQ(first.m_num_suffix, ")");
+        EXPECT_EQ(std::get<list_style_bullet>(numbering->m_level_styles[1]).m_bullet_char, "-");
+    }
+
+    // The same package is written to memory and, pipelined, to a file
+    auto archive = docx::writer::write(doc);
+    EXPECT_EQ(archive.size(), fs::file_size(filename));
+    docx::writer::write_async(doc, filename).get();
+    EXPECT_EQ(docx_file(filename).parse_text_doc(), expected);
+
+    fs::remove_all(dir);
+}
+
+TEST(DOCX, ConvertFromOdt)
+{
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "docsmith_odt_to_docx";
+    fs::create_directories(dir);
+
+    const std::string ns = "xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" "
+                           "xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\" "
+                           "xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\" "
+                           "xmlns:draw=\"urn:oasis:names:tc:opendocument:xmlns:drawing:1.0\" "
+                           "xmlns:fo=\"urn:oasis:names:tc:opendocument:xmlns:"
+                           "xsl-fo-compatible:1.0\" "
+                           "xmlns:svg=\"urn:oasis:names:tc:opendocument:xmlns:svg-compatible:1.0\" "
+                           "xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
+    std::map<std::string, std::string> parts = {
+        {"styles.xml",
+            "<office:document-styles " + ns + "><office:styles>"
+            "<style:style style:name=\"Quote\" style:family=\"paragraph\">"
+            "<style:text-properties fo:font-style=\"italic\" fo:font-size=\"12pt\"/>"
+            "</style:style>"
+            "<text:list-style style:name=\"Numbers\">"
+            "<text:list-level-style-number text:level=\"1\" style:num-format=\"i\" "
+            "style:num-suffix=\")\" text:start-value=\"3\"/>"
+            "<text:list-level-style-bullet text:level=\"2\" text:bullet-char=\"-\"/>"
+            "</text:list-style></office:styles><office:master-styles><style:master-page>"
+            "<style:header><text:p>Not in the body</text:p></style:header>"
+            "</style:master-page></office:master-styles></office:document-styles>"},
+        {"content.xml",
+            "<office:document-content " + ns + "><office:automatic-styles>"
+            "<style:style style:name=\"T1\" style:family=\"text\">"
+            "<style:text-properties style:font-name=\"Arial\"/></style:style>"
+            "</office:automatic-styles><office:body><office:text>"
+            "<text:h text:outline-level=\"2\">Title</text:h>"
+            "<text:p text:style-name=\"Quote\">Tab<text:tab/>here<text:line-break/>"
+            "and &lt;b&gt; &amp;<text:s text:c=\"2\"/>more</text:p>"
+            "<text:p>Go <text:span text:style-name=\"T1\">to</text:span>"
+            "<text:bookmark text:name=\"B\"/><text:a xlink:href=\"#B\">back</text:a>"
+            "<office:annotation><text:p>Dropped</text:p></office:annotation></text:p>"
+            "<text:list text:style-name=\"Numbers\"><text:list-item><text:p>one</text:p>"
+            "<text:list><text:list-item><text:p>nested</text:p></text:list-item></text:list>"
+            "</text:list-item></text:list>"
+            "<text:p><draw:frame svg:width=\"1in\" svg:height=\"0.5in\">"
+            "<draw:image xlink:href=\"Pictures/dot.png\"/></draw:frame></text:p>"
+            "</office:text></office:body></office:document-content>"},
+        {"Pictures/dot.png", "not really a PNG"}};
+
+    // Parts are passed on in small pieces, as they are inflated
+    docx::part_reader read_parts = [&](const std::string &name, const byte_sink &sink)
+    {
+        auto it = parts.find(name);
+        if(it == parts.end())
+            return false;
+        for(std::size_t i = 0; i < it->second.size(); i += 7)
+            sink(it->second.data() + i, std::min<std::size_t>(7, it->second.size() - i));
+        return true;
+    };
+
+    auto filename = (dir / "converted.docx").string();
+    write_zip(filename, [&](zip_writer &zip) { odt::convert_to_docx(read_parts, zip); });
+    auto actual = docx_file(filename).parse_text_doc();
+
+    text_doc expected{heading{2, span{text{"Title"}}},
+        par{span{text{"Tab\there\nand <b> &  more"}}}.set_style("Quote"),
+        par{span{text{"Go "}}, span{text{"to"}}.set_style("T1"), bookmark{"B"},
+            hyperlink{"#B", span{text{"back"}}}},
+        list{list_item{par{span{text{"one"}}}, list{list_item{par{span{text{"nested"}}}}}}},
+        par{frame{image{"word/media/image1.png"}}}};
+    EXPECT_EQ(actual, expected);
+
+    EXPECT_EQ(actual.styles().find("Quote")->m_text_props->m_font_size->m_points, 12.f);
+    EXPECT_EQ(actual.styles().find("T1")->m_text_props->m_font_name->get_name(), "Arial");
+    const auto *numbering = actual.list_styles().find("WWNum1");
+    ASSERT_NE(numbering, nullptr);
+    const auto &first = std::get<list_style_num>(numbering->m_level_styles[0]);
+    EXPECT_EQ(first.m_format, list_enum::lower_roman);
+    EXPECT_EQ(first.m_start_from, 3);
+    EXPECT_EQ(std::get<list_style_bullet>(numbering->m_level_styles[1]).m_bullet_char, "-");
+
+    // A missing content.xml is an error
+    parts.erase("content.xml");
+    EXPECT_THROW(write_zip([&](zip_writer &zip) { odt::convert_to_docx(read_parts, zip, false); }),
+        std::runtime_error);
+
+    fs::remove_all(dir);
+}
+
+TEST(DOCX, ConvertOdtFile)
+{
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "docsmith_odt_file_to_docx";
+    fs::create_directories(dir);
+
+    const std::string source = "odt/moderate.odt";
+    auto expected = block_texts(odt_file(source).parse_text_doc());
+    ASSERT_FALSE(expected.empty());
+    for(bool pipelined : {true, false})
+    {
+        auto filename = (dir / (pipelined ? "pipelined.docx" : "serial.docx")).string();
+        odt::convert_to_docx(source, filename, pipelined);
+        EXPECT_EQ(block_texts(docx_file(filename).parse_text_doc()), expected) << pipelined;
+    }
+
+    // An exception from the sink stops inflating, and read() rethrows it as it was
+    archive_reader odt(source);
+    std::size_t received = 0;
+    byte_sink failing = [&received](const char *, std::size_t size)
+    {
+        received += size;
+        throw std::length_error("Sink is full");
+    };
+    EXPECT_THROW(odt.read("content.xml", failing), std::length_error);
+    EXPECT_GT(received, 0u);
+    EXPECT_FALSE(odt.read("missing.xml", failing));
+
+    // The same from a conversion, on either path:
+    docx::part_reader read_parts = [&](const std::string &name, const byte_sink &sink)
+    { return odt.read(name, name == "content.xml" ? failing : sink); };
+    for(bool pipelined : {true, false})
+    {
+        auto convert = [&](zip_writer &zip) { odt::convert_to_docx(read_parts, zip, pipelined); };
+        EXPECT_THROW(write_zip((dir / "failed.docx").string(), convert), std::length_error)
+            << pipelined;
+    }
+
+    EXPECT_THROW(odt::convert_to_docx("odt/missing.odt", (dir / "missing.docx").string()),
+        std::runtime_error);
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,228 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "docsmithcpp/base64.h"
+#include "docsmithcpp/html_writer.h"
+#include "docsmithcpp/json.h"
+#include "docsmithcpp/markdown_writer.h"
+#include "docsmithcpp/output_buffer.h"
+#include "docsmithcpp/text_extractor.h"
+
+using namespace docsmith;
+using par = paragraph;
+
+TEST(PLAIN_TEXT, BlocksAndRuns)
+{
+    text_doc doc{heading{1, "Terms"}, par{"The Git", span{text{"Hub"}}, " repo"}, par{},
+        list{list_item{par{"one"}}, list_item{par{"two"}}}, par{"Link: ", hyperlink{"#x", "here"}}};
+    EXPECT_EQ(to_plain_text(doc), "Terms\nThe GitHub repo\none\ntwo\nLink: here\n");
+    EXPECT_EQ(to_plain_text(*doc.get_elem_of<span>()[0]), "Hub");
+}
+
+TEST(PLAIN_TEXT, ChunkedFlushing)
+{
+    text_doc doc;
+    for(int i = 0; i < 100; ++i)
+        doc.add(par{"paragraph " + std::to_string(i)});
+    doc.add(par{std::string(50, 'x')});
+
+    std::string out;
+    std::size_t flushes = 0;
+    {
+        output_buffer buf(
+            [&](const char *data, std::size_t size) {
+                EXPECT_LE(size, 64u);
+                ++flushes;
+                out.append(data, size);
+            },
+            16);
+        extract_text(doc, buf);
+        EXPECT_EQ(buf.size(), to_plain_text(doc).size());
+    }
+    EXPECT_EQ(out, to_plain_text(doc));
+    EXPECT_GT(flushes, 50u);
+}
+
+TEST(PLAIN_TEXT, FileDescriptor)
+{
+    std::FILE *f = std::tmpfile();
+    ASSERT_NE(f, nullptr);
+    {
+        output_buffer buf(fileno(f));
+        extract_text(text_doc{par{"to a file"}}, buf);
+        buf.flush();
+    }
+    std::rewind(f);
+    char line[32] = {};
+    ASSERT_NE(std::fgets(line, sizeof(line), f), nullptr);
+    EXPECT_STREQ(line, "to a file\n");
+    std::fclose(f);
+
+    output_buffer bad(-1);
+    bad.write("lost");
+    EXPECT_THROW(bad.flush(), std::system_error);
+}
+
+TEST(MARKDOWN, BlocksListsAndInlines)
+{
+    list_style numbered("L1", {list_style_num(style{}, 1, list_enum::arabic, ")", 7),
+                                  list_style_bullet(style{}, 2, bullet_type::bullet())});
+    list_style bullets("L2", {list_style_bullet(style{}, 1, bullet_type::bullet())});
+
+    text_doc doc{heading{1, "Title"}, heading{9, "Deep"},
+        par{"See ", hyperlink{"https://example.com/a b", "the *site*"}, " and ",
+            span{text{"this"}}.set_style("Em"), "."},
+        list{list_item{par{"seven"}, list{list_item{par{"nested"}}}},
+            list_item{par{"eight"}, par{"more"}}}
+            .set_style(numbered),
+        list{list_item{par{"dot"}}}.set_style(bullets), par{"1. not a list"},
+        par{frame{image{"Pictures/a.png"}}}};
+    doc.styles().add(style{"Em", text_props{font_style::italic}});
+    doc.list_styles().add(numbered);
+    doc.list_styles().add(bullets);
+
+    EXPECT_EQ(to_markdown(doc),
+        "# Title\n"
+        "\n"
+        "###### Deep\n"
+        "\n"
+        "See [the \\*site\\*](<https://example.com/a b>) and *this*.\n"
+        "\n"
+        "7) seven\n"
+        "   - nested\n"
+        "8) eight\n"
+        "\n"
+        "   more\n"
+        "\n"
+        "- dot\n"
+        "\n"
+        "1\\. not a list\n"
+        "\n"
+        "![](Pictures/a.png)\n");
+}
+
+TEST(MARKDOWN, MovedParserOutput)
+{
+    // Converting a parsed document must not need a copy of it: a moved tree keeps its parents
+    text_doc parsed{par{"one"}, list{list_item{par{"two"}}}};
+    text_doc doc = std::move(parsed);
+    EXPECT_EQ(doc.get_elem_of<list>()[0]->parent(), &doc);
+    EXPECT_EQ(to_markdown(doc), "one\n\n- two\n");
+}
+
+TEST(HTML, StylesheetAndElements)
+{
+    list_style alpha("L1", {list_style_num(style{}, 1, list_enum::lower_alpha, ")", 3)});
+    text_doc doc{heading{2, "A & B"}, par{"Styled"}.set_style("Quote"),
+        par{span{text{"x<y"}}.set_style("Plain"), hyperlink{"a.html?x=\"1\"", "link"}},
+        list{list_item{par{"item"}}}.set_style(alpha), par{frame{image{"Pictures/a.png"}}}};
+    auto base = style{"Base", text_props{font_name{"Liberation Serif"}, font_size{12.5f}}};
+    auto quote = style{"Quote", text_props{font_style::italic},
+        paragraph_props{break_before{break_type::page}}};
+    quote.m_parent_style = style_name("Base");
+    doc.styles().add(base);
+    doc.styles().add(quote);
+    doc.styles().add(style{"Plain"}); // No properties, so no class
+    doc.list_styles().add(alpha);
+
+    html_options options;
+    options.m_title = "Preview";
+    options.m_load_image = [](const std::string &uri) -> std::optional<std::string> {
+        return uri == "Pictures/a.png" ? std::optional<std::string>("\x89PNG") : std::nullopt;
+    };
+    EXPECT_EQ(to_html(doc, options),
+        "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>Preview</title>\n"
+        "<style>\n"
+        ".ds-Base{font-size:12.5pt;font-family:\"Liberation Serif\"}\n"
+        ".ds-Quote{font-size:12.5pt;font-style:italic;font-family:\"Liberation Serif\";"
+        "break-before:page}\n"
+        "</style>\n</head>\n<body>\n"
+        "<h2>A &amp; B</h2>\n"
+        "<p class=\"ds-Quote\">Styled</p>\n"
+        "<p><span>x&lt;y</span><a href=\"a.html?x=&quot;1&quot;\">link</a></p>\n"
+        "<ol type=\"a\" start=\"3\">\n<li><p>item</p>\n</li>\n</ol>\n"
+        "<p><img src=\"data:image/png;base64,iVBORw==\" alt=\"\"></p>\n"
+        "</body>\n</html>\n");
+}
+
+TEST(HTML, Base64)
+{
+    EXPECT_EQ(base64_encode(""), "");
+    EXPECT_EQ(base64_encode("f"), "Zg==");
+    EXPECT_EQ(base64_encode("fo"), "Zm8=");
+    EXPECT_EQ(base64_encode("foo"), "Zm9v");
+    EXPECT_EQ(base64_encode("foobar"), "Zm9vYmFy");
+    EXPECT_EQ(base64_encode(std::string("\xff\xfe\x00", 3)), "//4A");
+}
+
+TEST(JSON, RoundTrip)
+{
+    list_style numbered("L1", {list_style_num(style{"Num"}, 1, list_enum::upper_roman, ")", 4, "("),
+                                  list_style_bullet(style{}, 2, bullet_type::heavy_check_mark())});
+    std::get<list_style_num>(numbered.m_level_styles.front()).m_text_props =
+        text_props{font_size{9.5f}};
+    auto quote = style{"Quote", text_props{font_style::oblique, font_name{"Serif \"Pro\""}},
+        paragraph_props{break_after{break_type::odd_page}}};
+    quote.m_parent_style = style_name("Body");
+
+    text_doc doc{heading{3, "Caf\xc3\xa9 \"quoted\"\n\ttab\x01"},
+        par{"See ", hyperlink{"#Mark", "here"}, span{text{"it"}}.set_style("Em")}.set_style("Quote"),
+        list{list_item{par{"one"}, list{list_item{par{"nested"}}}}}.set_style(numbered),
+        par{frame{image{"Pictures/a.png"}}.set_style("fr1"), bookmark{"Mark"}}, par{}};
+    doc.styles().add(quote);
+    doc.styles().add(style{"Body"});
+    doc.styles().add(style{"fr1", graphics_props{align_horiz::centre, align_vert::from_top}});
+    doc.list_styles().add(numbered);
+
+    auto json = to_json(doc);
+    EXPECT_TRUE(json.starts_with("{\"docsmith\":1,\"styles\":[{\"name\":\"Body\"},"));
+    EXPECT_NE(json.find("\"children\":[\"Caf\xc3\xa9 \\\"quoted\\\"\\n\\ttab\\u0001\"]"),
+        std::string::npos);
+
+    auto read = read_json(json);
+    EXPECT_EQ(read, doc);
+    EXPECT_EQ(to_json(read), json);
+    ASSERT_NE(read.list_styles().find("L1"), nullptr);
+    const auto &level = std::get<list_style_num>(read.list_styles().find("L1")->m_level_styles[0]);
+    EXPECT_EQ(level.m_num_prefix, "(");
+    EXPECT_EQ(level.m_start_from, 4);
+    EXPECT_EQ(level.m_text_props->m_font_size->m_points, 9.5f);
+    EXPECT_EQ(read.get_elem_of<list>()[0]->parent(), &read);
+}
+
+TEST(JSON, ReaderInput)
+{
+    // Members in any order, unknown members, whitespace and escapes
+    auto doc = read_json(R"( { "extra": [1, {"x": null}, true], "body": [
+        {"children": ["A\u00e9\ud83d\ude00\/"], "level": 2, "type": "h"} ] } )");
+    ASSERT_EQ(doc.get_elem_of<heading>().size(), 1u);
+    EXPECT_EQ(doc.get_elem_of<heading>()[0]->level(), 2);
+    EXPECT_EQ(doc.get_elem_of<text>()[0]->m_text, "A\xc3\xa9\xf0\x9f\x98\x80/");
+
+    EXPECT_THROW(read_json(R"({"docsmith": 2})"), std::runtime_error);
+    EXPECT_THROW(read_json(R"({"body": [{"type": "table"}]})"), std::runtime_error);
+    EXPECT_THROW(read_json(R"({"body": [{"type": "image", "children": []}]})"), std::runtime_error);
+    EXPECT_THROW(read_json(R"({"body": [{"type": "p")"), std::runtime_error);
+    EXPECT_THROW(read_json(R"({"body": ["\ud83d"]})"), std::runtime_error);
+    EXPECT_THROW(read_json(R"({} {})"), std::runtime_error);
+    EXPECT_THROW(read_json("{\"x\":" + std::string(10000, '[')), std::runtime_error);
+}
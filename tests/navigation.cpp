@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "docsmithcpp/link_index.h"
+#include "docsmithcpp/query.h"
+#include "docsmithcpp/regex.h"
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/text_extractor.h"
+#include "docsmithcpp/text_index.h"
+#include "docsmithcpp/text_search.h"
+
+using namespace docsmith;
+using par = paragraph;
+
+namespace
+{
+text_doc make_report()
+{
+    return text_doc{heading{1, "Introduction"}, par{"Scope."},
+        heading{2, text{"Back"}, span{text{"ground"}}}, par{"History."}, heading{2, "Goals"},
+        heading{1, "Method"}, par{"Steps."}, list{list_item{"One"}}};
+}
+}
+
+TEST(OUTLINE, Sections)
+{
+    auto doc = make_report();
+    const auto &toc = doc.get_outline();
+
+    ASSERT_EQ(toc.size(), 4u);
+    EXPECT_EQ(toc.top_level(), (std::vector<std::size_t>{0, 3}));
+    EXPECT_EQ(toc[0].m_children, (std::vector<std::size_t>{1, 2}));
+    EXPECT_EQ(toc[1].title(), "Background");
+    EXPECT_EQ(toc[1].m_parent, 0u);
+    EXPECT_EQ(toc[3].m_parent, section::npos);
+
+    // Section ranges cover subsections and stop at the next heading of the same level:
+    EXPECT_EQ(std::distance(toc[0].m_begin, toc[0].m_end), 5);
+    EXPECT_EQ(std::distance(toc[1].m_begin, toc[1].m_end), 2);
+    EXPECT_EQ(std::distance(toc[2].m_begin, toc[2].m_end), 1);
+    EXPECT_EQ(toc[3].m_end, doc.m_children.end());
+    EXPECT_EQ(toc.find(*toc[2].m_heading), &toc[2]);
+}
+
+TEST(OUTLINE, CachedUntilEdited)
+{
+    auto doc = make_report();
+    const auto *first = &doc.get_outline();
+    EXPECT_EQ(&doc.get_outline(), first);
+
+    doc.add(heading{1, "Results"});
+    const auto &updated = doc.get_outline();
+    ASSERT_EQ(updated.size(), 5u);
+    EXPECT_EQ(updated[4].title(), "Results");
+    EXPECT_EQ(std::distance(updated[3].m_begin, updated[3].m_end), 3);
+
+    // Assigning to a top level heading may change its level:
+    auto *background = dynamic_cast<heading *>(std::next(doc.m_children.begin(), 2)->get());
+    *background = heading{1, "Background"};
+    const auto &relevelled = doc.get_outline();
+    ASSERT_EQ(relevelled.size(), 5u);
+    EXPECT_EQ(relevelled[1].m_level, 1);
+    EXPECT_EQ(relevelled.top_level(), (std::vector<std::size_t>{0, 1, 3, 4}));
+    EXPECT_EQ(relevelled[1].m_children, (std::vector<std::size_t>{2}));
+
+    // A copy builds its own outline over its own blocks:
+    text_doc copy = doc;
+    EXPECT_EQ(copy.get_outline()[0].m_begin, copy.m_children.begin());
+}
+
+TEST(LINK_INDEX, ResolveAndValidate)
+{
+    // As in the GenerateBookmark test, with a forward link, a dangling one and a duplicate:
+    text_doc doc{par{hyperlink{"#Bookmark%202", "Forward"}}, par{"Start", bookmark{"Bookmark 1"}},
+        par{hyperlink{"#Bookmark 1", "Back"}, hyperlink{"https://example.com", "External"}},
+        heading{1, bookmark{"Bookmark 2"}, "Title"}, par{hyperlink{"#Missing", "Broken"}},
+        par{bookmark{"Bookmark 1"}, hyperlink{"#Table1|table", "Other target"}}};
+
+    link_index index(doc);
+    ASSERT_EQ(index.links().size(), 3u);
+    EXPECT_EQ(index.links()[0].m_name, "Bookmark 2");
+    EXPECT_EQ(index.links()[0].m_target, index.find_bookmark("Bookmark 2"));
+    EXPECT_EQ(index.target(*index.links()[1].m_link), index.find_bookmark("Bookmark 1"));
+    EXPECT_EQ(index.find_bookmark("Missing"), nullptr);
+
+    auto dangling = index.dangling();
+    ASSERT_EQ(dangling.size(), 1u);
+    EXPECT_EQ(dangling[0]->m_name, "Missing");
+    EXPECT_EQ(index.duplicate_bookmarks(), std::vector<std::string>{"Bookmark 1"});
+
+    text_doc clean{par{bookmark{"A"}}, par{hyperlink{"#A", "to A"}}};
+    auto reports = validate_links({&doc, &clean}, 2);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].m_dangling, std::vector<std::string>{"Missing"});
+    EXPECT_FALSE(reports[0].ok());
+    EXPECT_TRUE(reports[1].ok());
+}
+
+TEST(PARENT, UpwardNavigation)
+{
+    text_doc doc{heading{1, "Title"},
+        list{list_item{par{"Item ", span{text{"one"}}}}, list_item{par{"Item two"}}}};
+    doc.add(par{"Added"});
+
+    auto texts = doc.get_elem_of<text>();
+    ASSERT_EQ(texts.size(), 5u);
+    auto *one = texts[2];
+    EXPECT_EQ(one->m_text, "one");
+    EXPECT_TRUE(one->parent()->is_type(elem_t::spn));
+    EXPECT_EQ(one->ancestors().size(), 5u); // span, paragraph, list_item, list, text_doc
+    EXPECT_EQ(one->ancestors().back(), &doc);
+    EXPECT_EQ(one->closest<list_item>(), doc.get_elem_of<list_item>()[0]);
+    EXPECT_EQ(one->closest<heading>(), nullptr);
+    EXPECT_EQ(texts[4]->closest<paragraph>()->parent(), &doc);
+    EXPECT_EQ(doc.parent(), nullptr);
+
+    // Copies and moves point into their own tree:
+    text_doc copy = doc;
+    EXPECT_EQ(copy.get_elem_of<text>()[2]->ancestors().back(), &copy);
+    text_doc moved = std::move(copy);
+    EXPECT_EQ(moved.get_elem_of<text>()[2]->ancestors().back(), &moved);
+    auto clone = texts[2]->closest<paragraph>()->clone();
+    EXPECT_EQ(clone->parent(), nullptr);
+    EXPECT_EQ(clone->get_elem_of<text>()[1]->closest<paragraph>(), clone.get());
+}
+
+TEST(CONST_ACCESS, ConcurrentReaders)
+{
+    text_doc doc;
+    for(int i = 0; i < 200; ++i)
+    {
+        doc.add(heading{1 + i % 3, "Section " + std::to_string(i)});
+        doc.add(par{"Text ", span{text{std::to_string(i)}}});
+        doc.add(list{list_item{par{"Item"}}});
+    }
+
+    // Expected results, from a copy so that the shared document's outline isn't built yet
+    const text_doc reference = doc;
+    const auto expected_text = to_plain_text(reference);
+    const auto expected_sections = reference.get_outline().size();
+    const auto expected_texts = reference.get_elem_of<text>().size();
+    const selector items("list > list_item paragraph");
+
+    // Readers only get a const reference. Run under TSan (DOCSMITHCPP_SANITIZE_THREAD) to check
+    // that this is free of data races, including the first, concurrent use of the outline cache.
+    const text_doc &shared = doc;
+    static_assert(std::is_same_v<decltype(shared.parent()), const element *>);
+    static_assert(std::is_same_v<decltype(shared.get_outline()[0].m_heading), const heading *>);
+    std::vector<std::thread> readers;
+    std::vector<int> failures(8, 0);
+    for(std::size_t t = 0; t < failures.size(); ++t)
+    {
+        readers.emplace_back(
+            [&, t]
+            {
+                auto &failed = failures[t];
+                failed += shared.get_outline().size() != expected_sections;
+                failed += to_plain_text(shared) != expected_text;
+
+                auto texts = shared.get_elem_of<text>();
+                failed += texts.size() != expected_texts;
+                failed += texts[1]->closest<paragraph>() != shared.get_elem_of<paragraph>()[0];
+                failed += shared.children().size() != 600;
+                failed += items.select_as<paragraph>(shared).size() != 200;
+                failed += shared
+                              .find_all<heading>([](const element *e)
+                                  { return dynamic_cast<const heading *>(e)->level() == 1; })
+                              .size() != 67;
+
+                // Searches through a const root give const results
+                std::vector<const_text_hit> items_found = find_text(shared, "Item");
+                failed += items_found.size() != 200;
+                failed += items_found[0].m_node->closest<paragraph>() == nullptr;
+                // A regex can't be shared, as matching builds its DFA, so each thread has its own
+                std::vector<const_regex_match> numbers = regex("\\d+").find_all(shared);
+                failed += numbers.size() != 400;
+                failed += numbers[1].m_first.m_node->m_text != "0";
+                failed += const_text_index(shared).find_blocks("section").size() != 200;
+            });
+    }
+    for(auto &r : readers)
+        r.join();
+    for(auto failed : failures)
+        EXPECT_EQ(failed, 0);
+}
@@ -17,12 +17,20 @@
  *****************************************************************************/
 
 #include <gtest/gtest.h>
+#include <libzippp/libzippp.h>
 
 #include "docsmithcpp/element.h"
 #include "docsmithcpp/iostream_writer.h"
 #include "docsmithcpp/odt/file.h"
+#include "docsmithcpp/odt/writer.h"
 #include "docsmithcpp/text_doc.h"
 
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
 using namespace docsmith;
 using par = paragraph;
 
@@ -231,4 +239,221 @@ TEST(ODT, GenerateBookmark)
     odt_file f("odt/out/bookmark.odt");
     f.save(d);
     open_file(f.filename());
-}
\ No newline at end of file
+}
+TEST(ODT, SaveAndParseRoundTrip)
+{
+    const text_doc expected{par{"First paragraph"}, par{"Second paragraph"}};
+
+    // Saving twice exercises the cached static archive parts:
+    odt_file f("odt/out/round_trip.odt");
+    f.save(expected);
+    f.save(expected);
+
+    const text_doc actual = f.parse_text_doc();
+    EXPECT_EQ(expected, actual);
+}
+
+/// Load the content.xml of an archive
+void load_content(const std::string &filename, pugi::xml_document &content)
+{
+    libzippp::ZipArchive zip(filename);
+    zip.open(libzippp::ZipArchive::ReadOnly);
+    content.load_string(zip.getEntry("content.xml").readAsText().c_str());
+}
+
+/// Number of style declarations in the content.xml of an archive.
+std::ptrdiff_t content_style_count(const std::string &filename)
+{
+    pugi::xml_document content;
+    load_content(filename, content);
+    auto root = content.document_element();
+    auto styles = root.child("office:styles");
+    auto automatic_styles = root.child("office:automatic-styles");
+    return std::distance(styles.begin(), styles.end()) +
+           std::distance(automatic_styles.begin(), automatic_styles.end());
+}
+
+/// Outline level and style of every heading, then the style of every span, in document order.
+std::vector<std::string> heading_and_span_styles(const text_doc &d)
+{
+    std::vector<std::string> styles;
+    for(auto *h : d.get_elem_of<heading>())
+        styles.push_back(std::to_string(h->level()) + ":" + h->get_style().get_name());
+    for(auto *s : d.get_elem_of<span>())
+        styles.push_back(s->get_style().get_name());
+    return styles;
+}
+
+TEST(ODT, UpdateSaveKeepsUnmodelledParts)
+{
+    auto f = odt_file("odt/moderate.odt");
+    text_doc d = f.parse_text_doc();
+    const auto styles = heading_and_span_styles(d);
+    ASSERT_FALSE(styles.empty());
+
+    // A style the base already declares replaces it rather than being written a second time:
+    d.styles().add(style(style_name("P3")));
+
+    auto first = d.find_all<text>(
+        [](element *e) { return dynamic_cast<text *>(e)->m_text == "First paragraph"; });
+    ASSERT_EQ(first.size(), 1u);
+    first.front()->m_text = "Edited paragraph";
+
+    f.save_update(d, "odt/out/moderate_updated.odt");
+
+    libzippp::ZipArchive updated("odt/out/moderate_updated.odt");
+    ASSERT_TRUE(updated.open(libzippp::ZipArchive::ReadOnly));
+    EXPECT_TRUE(updated.hasEntry("styles.xml"));
+    EXPECT_TRUE(updated.hasEntry("meta.xml"));
+    EXPECT_TRUE(updated.hasEntry("settings.xml"));
+    updated.close();
+
+    auto reparsed = odt_file("odt/out/moderate_updated.odt").parse_text_doc();
+    auto edited = reparsed.find_all<text>(
+        [](element *e) { return dynamic_cast<text *>(e)->m_text == "Edited paragraph"; });
+    EXPECT_EQ(edited.size(), 1u);
+    EXPECT_EQ(heading_and_span_styles(reparsed), styles);
+    EXPECT_EQ(content_style_count("odt/out/moderate_updated.odt"),
+        content_style_count("odt/moderate.odt"));
+}
+
+TEST(ODT, UpdateSaveReplacesEditedStyle)
+{
+    auto f = odt_file("odt/moderate.odt");
+    text_doc d = f.parse_text_doc();
+    d.styles().add(style{"P3", text_props{font_name{"Liberation Mono"}, font_size{14.f}}});
+
+    f.save_update(d, "odt/out/moderate_restyled.odt");
+
+    pugi::xml_document content;
+    load_content("odt/out/moderate_restyled.odt", content);
+    auto p3 = content.select_nodes("//style:style[@style:name='P3']");
+    ASSERT_EQ(p3.size(), 1u);
+    auto props = p3.first().node().child("style:text-properties");
+    EXPECT_STREQ(props.attribute("style:font-name").as_string(), "Liberation Mono");
+    EXPECT_STREQ(props.attribute("fo:font-size").as_string(), "14pt");
+    EXPECT_EQ(content_style_count("odt/out/moderate_restyled.odt"),
+        content_style_count("odt/moderate.odt"));
+}
+
+TEST(ODT, SaveKeepsStylesSharingAName)
+{
+    text_doc d{par{"Listed"}.set_style("L1")};
+    d.styles().add(style{"L1"});
+    d.list_styles().add(list_style("L1", {list_style_bullet(style{}, 1, bullet_type::bullet())}));
+
+    odt_file("odt/out/shared_style_name.odt").save(d);
+
+    pugi::xml_document content;
+    load_content("odt/out/shared_style_name.odt", content);
+    EXPECT_EQ(content.select_nodes("//style:style[@style:name='L1']").size(), 1u);
+    EXPECT_EQ(content.select_nodes("//text:list-style[@style:name='L1']").size(), 1u);
+}
+
+TEST(ODT, WriteToMemory)
+{
+    const text_doc expected{par{"Served from memory"}};
+
+    auto archive = odt::writer::write(expected);
+    ASSERT_GT(archive.size(), 4u);
+    EXPECT_EQ(archive[0], std::byte{'P'});
+    EXPECT_EQ(archive[1], std::byte{'K'});
+
+    std::ostringstream stream;
+    odt::writer::write(expected, stream);
+    auto streamed = stream.str();
+    ASSERT_EQ(streamed.size(), archive.size());
+
+    std::filesystem::create_directories("odt/out");
+    std::ofstream("odt/out/from_memory.odt", std::ios::binary)
+        .write(reinterpret_cast<const char *>(archive.data()), archive.size());
+
+    const text_doc actual = odt_file("odt/out/from_memory.odt").parse_text_doc();
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(ODT, AsyncSave)
+{
+    text_doc expected;
+    for(int i = 0; i < 1000; ++i)
+        expected.add(par{"Paragraph " + std::to_string(i)});
+
+    odt_file f("odt/out/async_save.odt");
+    auto saved = f.async_save(expected);
+    saved.get();
+
+    const text_doc actual = f.parse_text_doc();
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(ODT, FlatRoundTrip)
+{
+    const text_doc expected{par{"No archive, no deflate"}.set_style("Standard"),
+        par{frame{image{"data:image/png;base64,iVBORw0KGgo="}}}};
+
+    odt_file f("odt/out/round_trip.fodt");
+    f.save(expected);
+
+    // One plain XML file, with the picture embedded:
+    std::ifstream in("odt/out/round_trip.fodt", std::ios::binary);
+    std::string xml{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    EXPECT_EQ(xml.rfind("<?xml", 0), 0u);
+    EXPECT_NE(xml.find("<office:document "), std::string::npos);
+    EXPECT_NE(xml.find("<office:binary-data>iVBORw0KGgo=</office:binary-data>"), std::string::npos);
+
+    const text_doc actual = f.parse_text_doc();
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(ODT, FlatUpdateSaveKeepsMeta)
+{
+    // As another application would write it, with its own metadata and automatic styles:
+    std::filesystem::create_directories("odt/out");
+    std::ofstream("odt/out/flat_source.fodt", std::ios::binary)
+        << R"(<?xml version="1.0" encoding="UTF-8"?>
+<office:document xmlns:office="urn:oasis:names:tc:opendocument:xmlns:office:1.0"
+    xmlns:text="urn:oasis:names:tc:opendocument:xmlns:text:1.0"
+    xmlns:style="urn:oasis:names:tc:opendocument:xmlns:style:1.0"
+    xmlns:fo="urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0"
+    xmlns:meta="urn:oasis:names:tc:opendocument:xmlns:meta:1.0"
+    office:version="1.2" office:mimetype="application/vnd.oasis.opendocument.text">
+  <office:meta>
+    <meta:generator>LibreOffice/7.6</meta:generator>
+    <meta:user-defined meta:name="Reviewer">Jane Doe</meta:user-defined>
+  </office:meta>
+  <office:styles/>
+  <office:automatic-styles>
+    <style:style style:name="P1" style:family="paragraph">
+      <style:paragraph-properties fo:text-align="center"/>
+    </style:style>
+  </office:automatic-styles>
+  <office:body>
+    <office:text>
+      <text:p>First paragraph</text:p>
+    </office:text>
+  </office:body>
+</office:document>
+)";
+    odt_file source("odt/out/flat_source.fodt");
+
+    text_doc d = source.parse_text_doc();
+    auto first = d.find_all<text>(
+        [](element *e) { return dynamic_cast<text *>(e)->m_text == "First paragraph"; });
+    ASSERT_EQ(first.size(), 1u);
+    first.front()->m_text = "Edited paragraph";
+    source.save_update(d, "odt/out/flat_updated.fodt");
+
+    std::ifstream in("odt/out/flat_updated.fodt", std::ios::binary);
+    std::string xml{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    EXPECT_NE(xml.find("<meta:generator>LibreOffice/7.6</meta:generator>"), std::string::npos);
+    EXPECT_NE(xml.find(R"(<meta:user-defined meta:name="Reviewer">Jane Doe</meta:user-defined>)"),
+        std::string::npos);
+    EXPECT_NE(xml.find(R"(<style:style style:name="P1" style:family="paragraph">)"),
+        std::string::npos);
+    EXPECT_NE(xml.find(R"(<style:paragraph-properties fo:text-align="center" />)"),
+        std::string::npos);
+    EXPECT_EQ(xml.find("First paragraph"), std::string::npos);
+
+    const text_doc actual = odt_file("odt/out/flat_updated.fodt").parse_text_doc();
+    EXPECT_EQ(actual, (text_doc{par{"Edited paragraph"}}));
+}
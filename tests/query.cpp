@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "docsmithcpp/json.h"
+#include "docsmithcpp/query.h"
+#include "docsmithcpp/text_doc.h"
+
+using namespace docsmith;
+using par = paragraph;
+
+namespace
+{
+text_doc make_query_doc()
+{
+    return text_doc{heading{1, "Heading 1"},
+        par{"First paragraph"}.set_style("Text_20_body"),
+        heading{2, "Second Heading"},
+        heading{3, "Third Heading"},
+        list{list_item{par{"Item one"}.set_style("Text_20_body")},
+            list_item{list{list_item{par{"Nested item"}.set_style("Text_20_body")}}}}
+            .set_style("L1"),
+        par{text{"Here is a url to "},
+            hyperlink{"https://github.com/MichaelCoutlakis/docsmithcpp", "docsmith"},
+            text{" and a "},
+            hyperlink{"#Bookmark 1", "bookmark"}}};
+}
+}
+
+TEST(QUERY, TypeAndAttributes)
+{
+    auto doc = make_query_doc();
+
+    selector top_headings("heading[level<=2]");
+    auto headings = top_headings.select_as<heading>(doc);
+    ASSERT_EQ(headings.size(), 2u);
+    EXPECT_EQ(headings[0]->level(), 1);
+    EXPECT_EQ(headings[1]->level(), 2);
+
+    EXPECT_EQ(selector("paragraph[style=\"Text_20_body\"]").select(doc).size(), 3u);
+    EXPECT_EQ(selector("hyperlink[url^='#']").select(doc).size(), 1u);
+    EXPECT_EQ(selector("text[text*=url]").select(doc).size(), 1u);
+}
+
+TEST(QUERY, Combinators)
+{
+    auto doc = make_query_doc();
+
+    // Every list item paragraph, at any depth:
+    EXPECT_EQ(selector("list > list_item paragraph").select(doc).size(), 2u);
+
+    // Only paragraphs directly inside a list item of the top level list:
+    EXPECT_EQ(selector("text_doc > list > list_item > paragraph").select(doc).size(), 1u);
+
+    // The same compiled selector can be reused across documents:
+    selector nested("list list");
+    EXPECT_EQ(nested.select(doc).size(), 1u);
+    auto other = make_query_doc();
+    EXPECT_EQ(nested.select(other).size(), 1u);
+}
+
+TEST(QUERY, ParsedDocument)
+{
+    // Readers nest elements that is_valid_child doesn't allow, such as a hyperlink in a span
+    auto doc = read_json(R"({"body": [{"type": "p", "children": [{"type": "span", "children": [
+        {"type": "a", "url": "#Bookmark 1", "children": ["link"]},
+        {"type": "bookmark", "name": "Mark"}]}]}]})");
+
+    auto links = selector("paragraph hyperlink").select(doc);
+    ASSERT_EQ(links.size(), 1u);
+    EXPECT_EQ(dynamic_cast<hyperlink *>(links[0])->get_url(), "#Bookmark 1");
+    EXPECT_EQ(selector("span > bookmark").select(doc).size(), 1u);
+    EXPECT_EQ(selector("text_doc > hyperlink").select(doc).size(), 0u);
+}
+
+TEST(QUERY, InvalidSelectors)
+{
+    EXPECT_THROW(selector("table"), std::invalid_argument);
+    EXPECT_THROW(selector("heading[level<=two]"), std::invalid_argument);
+    EXPECT_THROW(selector("heading[colour=red]"), std::invalid_argument);
+    EXPECT_THROW(selector("list >"), std::invalid_argument);
+    EXPECT_THROW(selector(""), std::invalid_argument);
+}
@@ -0,0 +1,319 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "docsmithcpp/block_text.h"
+#include "docsmithcpp/regex.h"
+#include "docsmithcpp/replace.h"
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/text_index.h"
+#include "docsmithcpp/text_search.h"
+
+using namespace docsmith;
+using par = paragraph;
+
+namespace
+{
+text_doc make_search_doc()
+{
+    return text_doc{heading{1, "Contract Terms"},
+        par{text{"The supplier shall deliver the "}, span{text{"Goods"}}, text{" on time."}},
+        par{"Payment terms: the buyer pays within 30 days."},
+        list{list_item{"Goods remain the property of the supplier."}}};
+}
+}
+
+TEST(TEXT_INDEX, FindTermsAndBlocks)
+{
+    auto doc = make_search_doc();
+    text_index index(doc);
+
+    auto &goods = index.find("GOODS");
+    ASSERT_EQ(goods.size(), 2u);
+    EXPECT_EQ(goods[0].m_node->m_text, "Goods");
+    EXPECT_EQ(goods[0].m_offset, 0u);
+
+    auto blocks = index.find_blocks("supplier");
+    ASSERT_EQ(blocks.size(), 2u);
+    EXPECT_TRUE(blocks[0]->is_type(elem_t::p));
+
+    EXPECT_EQ(index.find_blocks("terms").size(), 2u); // Heading and paragraph
+    EXPECT_TRUE(index.find("missing").empty());
+}
+
+TEST(TEXT_INDEX, IncrementalUpdate)
+{
+    auto doc = make_search_doc();
+    text_index index(doc);
+
+    auto *node = index.find("goods").front().m_node;
+    node->m_text = "Services and services";
+    index.update(*node);
+
+    EXPECT_EQ(index.find("goods").size(), 1u);
+    ASSERT_EQ(index.find("services").size(), 2u);
+    EXPECT_EQ(index.find("services")[1].m_offset, 13u);
+
+    index.remove(*node);
+    EXPECT_TRUE(index.find("services").empty());
+}
+
+TEST(TEXT_INDEX, FollowsDocumentChanges)
+{
+    auto doc = make_search_doc();
+    auto &index = doc.index();
+
+    index.find("goods").front().m_node->set_text("Services");
+    EXPECT_EQ(index.find("goods").size(), 1u);
+    EXPECT_EQ(index.find("services").size(), 1u);
+
+    doc.add(par{"Late delivery ", span{text{"incurs"}}, " penalties."});
+    ASSERT_EQ(index.find_blocks("penalties").size(), 1u);
+    EXPECT_EQ(index.find("incurs").size(), 1u);
+
+    // One notification for a match across runs; both edited runs are re-indexed:
+    replacer({replacer::rule{"delivery incurs", "delay attracts"}}).apply(doc);
+    EXPECT_TRUE(index.find("incurs").empty());
+    EXPECT_EQ(index.find("attracts").size(), 1u);
+
+    *doc.get_elem_of<list_item>()[0] = list_item{"Title passes on payment."};
+    EXPECT_TRUE(index.find("remain").empty());
+    EXPECT_EQ(index.find("title").size(), 1u);
+
+    // Edits leave no stale postings behind. They don't keep document order, so compare against a
+    // fresh index as sets.
+    doc.get_elem_of<text>()[1]->set_text("The supplier shall deliver all the goods and the ");
+    text_index fresh(doc);
+    auto sorted = [](std::vector<text_posting> v)
+    {
+        std::sort(v.begin(), v.end(), [](const text_posting &a, const text_posting &b)
+            { return std::pair{a.m_node, a.m_offset} < std::pair{b.m_node, b.m_offset}; });
+        return v;
+    };
+    for(auto *term : {"the", "supplier", "goods", "services", "payment", "title", "delay", "on"})
+    {
+        auto got = sorted(index.find(term)), expected = sorted(fresh.find(term));
+        ASSERT_EQ(got.size(), expected.size()) << term;
+        for(std::size_t i = 0; i < got.size(); ++i)
+        {
+            EXPECT_EQ(got[i].m_node, expected[i].m_node) << term;
+            EXPECT_EQ(got[i].m_offset, expected[i].m_offset) << term;
+        }
+    }
+    EXPECT_EQ(index.size(), fresh.size());
+}
+
+TEST(TEXT_SEARCH, FindSubstring)
+{
+    // Long enough to exercise the vector kernel and the scalar tail:
+    std::string hay(200, 'a');
+    hay.replace(150, 6, "NeEdLe");
+    hay += "needle";
+    EXPECT_EQ(find_substring(hay, "needle"), 200u);
+    EXPECT_EQ(find_substring(hay, "needle", 0, true), 150u);
+
+    // Every kernel this machine can run, not only the one find_substring() picks:
+    for(auto kernel : {search_kernel::scalar, search_kernel::sse2, search_kernel::avx2})
+    {
+        if(!is_supported(kernel))
+        {
+            EXPECT_THROW(find_substring(kernel, hay, "needle"), std::invalid_argument);
+            continue;
+        }
+        SCOPED_TRACE(static_cast<int>(kernel));
+        EXPECT_EQ(find_substring(kernel, hay, "needle"), 200u);
+        EXPECT_EQ(find_substring(kernel, hay, "needle", 0, true), 150u);
+        EXPECT_EQ(find_substring(kernel, hay, "needle", 151, true), 200u);
+        EXPECT_EQ(find_substring(kernel, hay, "x"), std::string::npos);
+        EXPECT_EQ(find_substring(kernel, hay, "aaaa", 196), 196u);
+        EXPECT_EQ(find_substring(kernel, hay, "aaaa", 197), std::string::npos);
+        for(std::size_t i = 0; i < 64; ++i)
+            EXPECT_EQ(find_substring(kernel, hay, "a", i), i);
+    }
+    EXPECT_TRUE(is_supported(search_kernel::scalar));
+}
+
+TEST(TEXT_SEARCH, FindTextInDocument)
+{
+    auto doc = make_search_doc();
+
+    auto hits = find_text(doc, "supplier");
+    ASSERT_EQ(hits.size(), 2u);
+    EXPECT_EQ(hits[0].m_node->m_text.substr(hits[0].m_offset, 8), "supplier");
+
+    EXPECT_EQ(find_text(doc, "GOODS").size(), 0u);
+    EXPECT_EQ(find_text(doc, "GOODS", {.m_case_insensitive = true}).size(), 2u);
+
+    // Non-ASCII text matches exactly and never from the middle of a character:
+    text_doc utf8{par{"Caf\xc3\xa9 au lait, CAF\xc3\x89"}};
+    EXPECT_EQ(find_text(utf8, "caf\xc3\xa9", {.m_case_insensitive = true}).size(), 1u);
+    EXPECT_EQ(find_text(utf8, "\xc3\xa9").size(), 1u);
+    EXPECT_THROW(find_text(utf8, "\xa9"), std::invalid_argument);
+    EXPECT_THROW(find_text(utf8, ""), std::invalid_argument);
+}
+
+TEST(REPLACE, AcrossRuns)
+{
+    // As in moderate.odt, a word split between plain text and a span:
+    text_doc doc{par{text{"See Git"}, span{text{"Hub"}}, text{" and GitHub."}},
+        heading{2, "GitHub"}};
+
+    replacer r({replacer::rule{"GitHub", "GitLab"}});
+    auto result = r.apply(doc);
+    EXPECT_EQ(result.m_counts, std::vector<std::size_t>{3});
+
+    auto texts = doc.get_elem_of<text>();
+    ASSERT_EQ(texts.size(), 4u);
+    EXPECT_EQ(texts[0]->m_text, "See GitLab"); // Written into the run where the match starts
+    EXPECT_EQ(texts[1]->m_text, "");           // The span stays, emptied
+    EXPECT_EQ(texts[2]->m_text, " and GitLab.");
+    EXPECT_EQ(texts[3]->m_text, "GitLab");
+
+    // Empty text nodes on the boundaries of a match are left alone:
+    text_doc empties{par{text{"See "}, span{text{""}}, text{"Git"}, text{""}, span{text{"Hub"}},
+        text{""}, text{" now"}, text{""}}};
+    EXPECT_EQ(r.apply(empties).total(), 1u);
+    texts = empties.get_elem_of<text>();
+    ASSERT_EQ(texts.size(), 8u);
+    EXPECT_EQ(texts[0]->m_text, "See ");
+    EXPECT_EQ(texts[1]->m_text, "");
+    EXPECT_EQ(texts[2]->m_text, "GitLab");
+    EXPECT_EQ(texts[4]->m_text, "");
+    EXPECT_EQ(texts[6]->m_text, " now");
+
+    const_block_text bt(*empties.get_elem_of<paragraph>()[0]);
+    EXPECT_EQ(bt.locate(4).m_node, texts[2]);
+    EXPECT_EQ(bt.locate(10).m_node, texts[6]);
+}
+
+TEST(REPLACE, ManyPatterns)
+{
+    auto doc = make_search_doc();
+    replacer r({{"supplier", "vendor"}, {"the buyer", "the customer"}, {"buy", "purchase"},
+                   {"goods", "products"}, {"Terms", "Conditions"}},
+        true);
+    auto result = r.apply(doc);
+    EXPECT_EQ(result.m_counts, (std::vector<std::size_t>{2, 1, 0, 2, 2}));
+    EXPECT_EQ(result.total(), 7u);
+
+    auto texts = doc.get_elem_of<text>();
+    EXPECT_EQ(texts[0]->m_text, "Contract Conditions");
+    EXPECT_EQ(texts[1]->m_text, "The vendor shall deliver the ");
+    EXPECT_EQ(texts[2]->m_text, "products"); // Span text
+    EXPECT_EQ(texts[4]->m_text, "Payment Conditions: the customer pays within 30 days.");
+
+    // Leftmost-longest, without overlaps:
+    text_doc ushers{par{"ushers"}};
+    auto counts = replacer({{"he", "1"}, {"she", "2"}, {"hers", "3"}, {"usher", "4"}})
+                      .apply(ushers)
+                      .m_counts;
+    EXPECT_EQ(counts, (std::vector<std::size_t>{0, 0, 0, 1}));
+    EXPECT_EQ(ushers.get_elem_of<text>()[0]->m_text, "4s");
+
+    EXPECT_THROW(replacer({replacer::rule{"", "x"}}), std::invalid_argument);
+}
+
+TEST(REGEX, Search)
+{
+    using span_t = std::pair<std::size_t, std::size_t>;
+    auto search = [](const char *pattern, std::string_view s, bool nocase = false)
+    { return regex(pattern, nocase).search(s); };
+
+    EXPECT_EQ(search("\\d{2}/\\d{2}/\\d{4}", "Due 01/02/2025."), span_t(4, 14));
+    EXPECT_EQ(search("a|ab|abc", "xabcd"), span_t(1, 4)); // Leftmost-longest
+    EXPECT_EQ(search("(?:ab)+c?", "zababab"), span_t(1, 7));
+    EXPECT_EQ(search("^the", "the end", true), span_t(0, 3));
+    EXPECT_EQ(search("^end", "the end"), std::nullopt);
+    EXPECT_EQ(search("end$", "the end"), span_t(4, 7));
+    EXPECT_EQ(search("[^a-z ]+", "abc DEF ghi"), span_t(4, 7));
+    EXPECT_EQ(search("caf.", "un caf\xc3\xa9"), span_t(3, 8)); // . is a whole character
+    EXPECT_EQ(search("x{2,3}", "xxxxx"), span_t(0, 3));
+    EXPECT_EQ(search("PAYMENT", "late payment", true), span_t(5, 12));
+    EXPECT_EQ(search("a*", "bbaab"), span_t(2, 4)); // Empty matches are skipped
+    EXPECT_EQ(search("x?", "abc"), std::nullopt);
+    EXPECT_EQ(search("^", "abc"), std::nullopt);
+    EXPECT_FALSE(regex("x?").contains("abc"));
+    EXPECT_TRUE(regex("x?").contains("axc"));
+
+    // Linear time: the classic exponential case for backtracking engines
+    std::string as(5000, 'a');
+    EXPECT_EQ(search("(a|aa)*b", as), std::nullopt);
+    EXPECT_FALSE(regex("(a*)*b").contains(as));
+
+    for(auto *bad : {"(ab", "ab)", "*a", "a{3,2}", "a*?", "(a)\\1", "[z-a]", "(?=a)"})
+        EXPECT_THROW(regex{bad}, std::invalid_argument) << bad;
+}
+
+TEST(REGEX, SearchAll)
+{
+    using span_t = std::pair<std::size_t, std::size_t>;
+    auto search_each = [](regex &re, std::string_view s)
+    {
+        std::vector<span_t> found;
+        for(std::size_t from = 0; auto m = re.search(s, from);)
+        {
+            found.push_back(*m);
+            from = m->second;
+        }
+        return found;
+    };
+
+    for(auto *pattern : {"a|ab|abc", "b*", "(?:ab)+c?", "^a+", "a+$", "x{2,3}", "a|a[^z]*z", "\w+"})
+        for(std::string_view s : {"", "xabcd abab", "aaazaab", "xxxxxxxx", "abcabcab zz"})
+        {
+            regex re(pattern);
+            EXPECT_EQ(re.search_all(s), search_each(re, s)) << pattern << " in " << s;
+        }
+
+    // Every match ends before a thread that started at it gives up at the end of the block, so
+    // rescanning from each match would be quadratic:
+    std::string as(100000, 'a');
+    text_doc doc{par{as}};
+    auto matches = regex("a|a[^z]*z").find_all(doc);
+    ASSERT_EQ(matches.size(), as.size());
+    EXPECT_EQ(matches.back().m_begin, as.size() - 1);
+    EXPECT_EQ(matches.back().m_end, as.size());
+}
+
+TEST(REGEX, FindAllAcrossRuns)
+{
+    text_doc doc{par{text{"Account 1234-"}, span{text{"5678"}}, text{"-9012, sort code 12-34-56."}},
+        par{"No numbers here."}, heading{1, "Ref 9999-0000-1111"}};
+
+    regex account("\\d{4}-\\d{4}-\\d{4}");
+    auto matches = account.find_all(doc);
+    ASSERT_EQ(matches.size(), 2u);
+
+    EXPECT_EQ(matches[0].m_text, "1234-5678-9012");
+    EXPECT_EQ(matches[0].m_first.m_node->m_text, "Account 1234-");
+    EXPECT_EQ(matches[0].m_first.m_offset, 8u);
+    EXPECT_EQ(matches[0].m_last.m_node->m_text, "-9012, sort code 12-34-56.");
+    EXPECT_EQ(matches[0].m_last.m_offset, 5u);
+    EXPECT_TRUE(matches[1].m_block->is_type(elem_t::h));
+
+    auto doc2 = make_search_doc();
+    std::vector<element *> roots{&doc, &doc2, &doc};
+    auto results = find_all_parallel(regex("\\d+"), roots, 2);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].size(), 9u);
+    EXPECT_EQ(results[1].size(), 1u);
+    EXPECT_EQ(results[2].size(), 9u);
+}
@@ -17,6 +17,10 @@
  *****************************************************************************/
 #include <gtest/gtest.h>
 #include <filesystem>
+#include <fstream>
+
+#include "docsmithcpp/docx/file.h"
+#include "docsmithcpp/zip_writer.h"
 
 TEST(ODT_TEST, LoadSimpleODT_Doc)
 {
@@ -24,6 +28,26 @@ TEST(ODT_TEST, LoadSimpleODT_Doc)
 
 TEST(DOCX_TEST, LoadSimpleDOCX_DOC)
 {
+    using namespace docsmith;
+
+    // A minimal package, as written by Word without the parts which aren't read
+    auto path = std::filesystem::temp_directory_path() / "docsmith_simple.docx";
+    {
+        std::ofstream os(path, std::ios::binary);
+        zip_writer zip([&](const char *data, std::size_t size) { os.write(data, size); });
+        zip.add("_rels/.rels",
+            "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+            "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/"
+            "2006/relationships/officeDocument\" Target=\"word/document.xml\"/></Relationships>");
+        zip.add("word/document.xml",
+            "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">"
+            "<w:body><w:p><w:pPr><w:outlineLvl w:val=\"1\"/></w:pPr><w:r><w:t>Hello</w:t></w:r>"
+            "</w:p><w:p><w:r><w:t>World</w:t></w:r></w:p></w:body></w:document>");
+        zip.finish();
+    }
+
+    auto doc = docx_file(path.string()).parse_text_doc();
+    EXPECT_EQ(doc, (text_doc{heading{2, span{text{"Hello"}}}, paragraph{span{text{"World"}}}}));
 }
 
 int main(int argc, char** argv)
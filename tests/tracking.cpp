@@ -0,0 +1,202 @@
+/******************************************************************************
+ * Copyright 2025 Michael Coutlakis
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "docsmithcpp/doc_stats.h"
+#include "docsmithcpp/handle.h"
+#include "docsmithcpp/replace.h"
+#include "docsmithcpp/text_doc.h"
+#include "docsmithcpp/text_extractor.h"
+#include "docsmithcpp/versioned_doc.h"
+
+using namespace docsmith;
+using par = paragraph;
+
+TEST(DOC_STATS, CountsAndStyles)
+{
+    text_doc doc{heading{1, "Terms"}, par{"The Git", span{text{"Hub"}}, " repo"},
+        list{list_item{par{"Caf\xc3\xa9 au lait"}}}};
+    doc.add(par{"Quoted text"}.set_style(style_name("Quote")));
+
+    const auto &totals = doc.stats().totals();
+    EXPECT_EQ(totals.m_words, 1u + 3u + 3u + 2u); // "GitHub" is one word across the span
+    EXPECT_EQ(totals.m_chars, 5u + 15u + 12u + 11u);
+    EXPECT_EQ(totals.m_paragraphs, 3u);
+    EXPECT_EQ(totals.m_headings, 1u);
+
+    ASSERT_EQ(doc.stats().by_style().size(), 2u);
+    EXPECT_EQ(doc.stats().by_style().at("Quote").m_words, 2u);
+    EXPECT_EQ(doc.stats().by_style().at("").m_paragraphs, 2u);
+    EXPECT_EQ(doc.stats().of(*doc.get_elem_of<list>()[0]).m_words, 3u);
+}
+
+TEST(DOC_STATS, IncrementalUpdates)
+{
+    text_doc doc{par{"one two"}, list{list_item{par{"three"}}}};
+    auto &stats = doc.stats();
+    EXPECT_EQ(stats.totals().m_words, 3u);
+
+    auto *three = doc.get_elem_of<text>()[1];
+    three->set_text("three four five");
+    EXPECT_EQ(stats.totals().m_words, 5u);
+    EXPECT_EQ(stats.of(*doc.get_elem_of<list>()[0]).m_words, 3u);
+
+    doc.get_elem_of<list_item>()[0]->add(par{"six"});
+    doc.add(heading{2, "seven"});
+    EXPECT_EQ(stats.totals().m_words, 7u);
+    EXPECT_EQ(stats.totals().m_paragraphs, 3u);
+    EXPECT_EQ(stats.totals().m_headings, 1u);
+
+    // Joining two words across a span boundary:
+    auto *p = doc.get_elem_of<paragraph>()[0];
+    p->add(span{text{"more"}});
+    EXPECT_EQ(stats.totals().m_words, 7u); // "twomore"
+
+    p->set_style(style_name("Body"));
+    EXPECT_EQ(stats.by_style().at("Body").m_words, 2u);
+    EXPECT_EQ(stats.by_style().at("").m_words, 5u);
+
+    // Everything agrees with a recount:
+    auto expected = stats.totals();
+    stats.rebuild();
+    EXPECT_EQ(stats.totals(), expected);
+
+    doc = text_doc{par{"reset"}};
+    EXPECT_EQ(doc.stats().totals().m_words, 1u);
+}
+
+TEST(DOC_STATS, ForgetsReplacedElements)
+{
+    text_doc doc{par{"intro"}, list{list_item{par{"a"}}, list_item{par{"b"}}}};
+    auto &stats = doc.stats();
+    auto *item = doc.get_elem_of<list_item>()[0];
+    auto *heading_ = doc.get_elem_of<paragraph>()[0];
+
+    // Each assignment destroys the old paragraphs, whose entries mustn't pile up:
+    for(int i = 0; i < 50; ++i)
+    {
+        *item = list_item{par{"c d"}, list{list_item{par{"e"}}}};
+        *heading_ = paragraph{"intro", span{text{" again"}}};
+    }
+    item->add(par{"f"});
+    *doc.get_elem_of<list>()[0] = list{list_item{par{"g"}}, list_item{par{"h"}}};
+    item = doc.get_elem_of<list_item>()[0];
+    *item = list_item{par{"i j"}};
+
+    EXPECT_EQ(stats.cached(), doc_stats(doc).cached());
+    EXPECT_EQ(stats.totals(), doc_stats(doc).totals());
+    EXPECT_EQ(stats.totals().m_words, 5u);
+    EXPECT_EQ(stats.of(*item).m_words, 2u);
+}
+
+TEST(DOC_STATS, SeesReplacements)
+{
+    text_doc doc{par{"alpha beta"}, par{"beta"}};
+    EXPECT_EQ(doc.stats().totals().m_chars, 14u);
+    replacer({replacer::rule{"beta", "gamma delta"}}).apply(doc);
+    EXPECT_EQ(doc.stats().totals().m_words, 5u);
+    EXPECT_EQ(doc.stats().totals().m_chars, 28u);
+}
+
+TEST(HANDLE, SurviveEditsAndFailSafely)
+{
+    text_doc doc{heading{1, "Title"}, par{"first"}, par{"second"}};
+    auto paras = doc.get_handles(doc.get_elem_of<paragraph>());
+    ASSERT_EQ(paras.size(), 2u);
+    EXPECT_EQ(doc.get_handle(*doc.get_elem_of<paragraph>()[0]), paras[0]);
+
+    // Edits elsewhere leave handles valid:
+    doc.add(par{"third"});
+    doc.get_elem_of<paragraph>()[1]->add(span{text{" more"}});
+    ASSERT_NE(doc.resolve(paras[1]), nullptr);
+    EXPECT_EQ(doc.resolve(paras[1])->get_elem_of<text>()[1]->m_text, " more");
+
+    // Destroying the element makes its handle resolve to nullptr, even after the slot is reused:
+    doc.m_children.erase(std::next(doc.m_children.begin()));
+    EXPECT_EQ(doc.resolve(paras[0]), nullptr);
+    auto third = doc.get_handle(*doc.get_elem_of<paragraph>()[1]);
+    EXPECT_EQ(third.m_index, paras[0].m_index);
+    EXPECT_EQ(doc.resolve(paras[0]), nullptr);
+    EXPECT_NE(doc.resolve(third), nullptr);
+
+    handle<element> as_element{third.m_index, third.m_generation};
+    EXPECT_EQ(doc.resolve(as_element), doc.resolve(third));
+    EXPECT_EQ(doc.resolve(handle<heading>{third.m_index, third.m_generation}), nullptr);
+    EXPECT_EQ(doc.resolve(handle<paragraph>{}), nullptr);
+
+    // A copy or a reparse (reassignment) doesn't resolve old handles:
+    text_doc copy = doc;
+    EXPECT_EQ(copy.resolve(third), nullptr);
+    doc = text_doc{par{"reparsed"}};
+    EXPECT_EQ(doc.resolve(third), nullptr);
+
+    paragraph loose{"not in the document"};
+    EXPECT_THROW(doc.get_handle(loose), std::invalid_argument);
+}
+
+TEST(VERSIONED_DOC, SnapshotsWhileEditing)
+{
+    versioned_doc doc(text_doc{heading{1, "Log"}});
+    auto first = doc.snapshot();
+    EXPECT_EQ(doc.latest()->m_number, 1u);
+
+    EXPECT_EQ(doc.edit([](text_doc &d) { d.add(par{"Entry 1"}); }), 2u);
+    EXPECT_EQ(first->m_children.size(), 1u); // Earlier snapshots don't change
+    EXPECT_EQ(doc.snapshot()->m_children.size(), 2u);
+    EXPECT_EQ(doc.publish(text_doc{par{"Replaced"}}), 3u);
+    EXPECT_EQ(to_plain_text(*doc.snapshot()), "Replaced\n");
+
+    // One writer publishes while readers take snapshots. Each version has as many entries as its
+    // number says, so a reader that saw a half edited document would notice. Run under TSan
+    // (DOCSMITHCPP_SANITIZE_THREAD) to check for data races.
+    doc.publish(text_doc{heading{1, "Log"}});
+    const auto base = doc.latest()->m_number;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    std::vector<int> failures(4, 0);
+    for(std::size_t t = 0; t < failures.size(); ++t)
+    {
+        readers.emplace_back(
+            [&, t]
+            {
+                std::uint64_t seen = 0;
+                while(!done.load())
+                {
+                    auto v = doc.latest();
+                    auto entries = v->m_doc.get_elem_of<paragraph>().size();
+                    failures[t] += entries != v->m_number - base;
+                    failures[t] += v->m_number < seen; // Versions only move forward
+                    failures[t] += v->m_doc.get_outline().size() != 1;
+                    seen = v->m_number;
+                }
+            });
+    }
+    for(int i = 0; i < 100; ++i)
+        doc.edit([i](text_doc &d) { d.add(par{"Entry " + std::to_string(i)}); });
+    done = true;
+    for(auto &r : readers)
+        r.join();
+    for(auto failed : failures)
+        EXPECT_EQ(failed, 0);
+    EXPECT_EQ(doc.snapshot()->get_elem_of<paragraph>().size(), 100u);
+}